@@ -0,0 +1,425 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Actuation latency benchmark on a plain Linux host. Runs opcuaserver (built
+ * with the axparameter stub) against the mock device services on a private
+ * D-Bus bus and switches its output ports, first one at a time with a Write of
+ * the port node and then in batches with the SetOutputs method. Reports the
+ * client's round trip, the time until the mock's SetState and, for
+ * SetOutputs, the time until the confirmed states are notified on a
+ * subscription.
+ */
+
+#include <open62541/client_highlevel.h>
+#include <open62541/client_subscriptions.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mock_device.h"
+
+#define CONNECT_TIMEOUT_S 10
+#define SETTLE_MS 500
+#define WAIT_TIMEOUT_MS 2000
+#define ITERATE_TIMEOUT_MS 1
+#define NODEID_PORT_BASE 2000
+#define NODEID_SET_OUTPUTS 3200
+#define SAMPLING_INTERVAL_MS 1.0
+
+static gint inputs = 2;
+static gint outputs = 4;
+static gint count = 500;
+static gint ua_port = 48420;
+static gchar *server_path = "bench/opcuaserver";
+static gchar *server_log = "bench/opcuaserver.log";
+
+static const GOptionEntry entries[] = {
+    {"inputs", 'i', 0, G_OPTION_ARG_INT, &inputs, "Number of input ports (2)", "N"},
+    {"outputs", 'o', 0, G_OPTION_ARG_INT, &outputs, "Number of output ports, set per SetOutputs call (4)", "N"},
+    {"count", 'n', 0, G_OPTION_ARG_INT, &count, "Writes and calls to measure (500)", "N"},
+    {"port", 'p', 0, G_OPTION_ARG_INT, &ua_port, "OPC UA server port (48420)", "PORT"},
+    {"server", 0, 0, G_OPTION_ARG_FILENAME, &server_path, "opcuaserver to run", "PATH"},
+    {"server-log", 0, 0, G_OPTION_ARG_FILENAME, &server_log, "Where to write the server's output", "PATH"},
+    {NULL, 0, 0, 0, NULL, NULL, NULL}};
+
+/* Latest notified state of each output and when it arrived, only touched by the main thread */
+static bool *notified_states;
+static gint64 *notified_us;
+
+typedef struct
+{
+    const gchar *name;
+    gint64 *values;
+    guint count;
+} samples_t;
+
+static void on_data_change(
+    UA_Client *client,
+    UA_UInt32 sub_id,
+    void *sub_context,
+    UA_UInt32 mon_id,
+    void *mon_context,
+    UA_DataValue *value)
+{
+    (void)client;
+    (void)sub_id;
+    (void)sub_context;
+    (void)mon_id;
+    const guint output = GPOINTER_TO_UINT(mon_context);
+
+    if (value->hasValue && UA_Variant_hasScalarType(&value->value, &UA_TYPES[UA_TYPES_BOOLEAN]))
+    {
+        notified_states[output] = *(UA_Boolean *)value->value.data;
+        notified_us[output] = g_get_monotonic_time();
+    }
+}
+
+static bool subscribe_outputs(UA_Client *client)
+{
+    UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+    request.requestedPublishingInterval = 0.0;
+    request.maxNotificationsPerPublish = 0;
+    UA_CreateSubscriptionResponse subscription = UA_Client_Subscriptions_create(client, request, NULL, NULL, NULL);
+    if (UA_STATUSCODE_GOOD != subscription.responseHeader.serviceResult)
+    {
+        fprintf(
+            stderr,
+            "Failed to create subscription (%s)\n",
+            UA_StatusCode_name(subscription.responseHeader.serviceResult));
+        return false;
+    }
+
+    bool ok = true;
+    for (gint i = 0; i < outputs && ok; i++)
+    {
+        UA_MonitoredItemCreateRequest item =
+            UA_MonitoredItemCreateRequest_default(UA_NODEID_NUMERIC(1, NODEID_PORT_BASE + inputs + i));
+        // Output port nodes are data sources, sampled at their interval rather than on writes
+        item.requestedParameters.samplingInterval = SAMPLING_INTERVAL_MS;
+        UA_MonitoredItemCreateResult result = UA_Client_MonitoredItems_createDataChange(
+            client,
+            subscription.subscriptionId,
+            UA_TIMESTAMPSTORETURN_BOTH,
+            item,
+            GUINT_TO_POINTER(i),
+            on_data_change,
+            NULL);
+        ok = UA_STATUSCODE_GOOD == result.statusCode;
+        if (!ok)
+        {
+            fprintf(stderr, "Failed to monitor output %d (%s)\n", i, UA_StatusCode_name(result.statusCode));
+        }
+        UA_MonitoredItemCreateResult_clear(&result);
+    }
+    if (ok)
+    {
+        printf("publishing interval %.1f ms (revised by the server)\n", subscription.revisedPublishingInterval);
+    }
+    return ok;
+}
+
+static void iterate(UA_Client *client, const gint64 until)
+{
+    while (g_get_monotonic_time() < until)
+    {
+        UA_Client_run_iterate(client, ITERATE_TIMEOUT_MS);
+    }
+}
+
+/* Latest SetState at the mock of outputs first to first + n - 1, 0 until all are set after since */
+static gint64 get_set_time(const gint first, const gint n, const gint64 since)
+{
+    gint64 latest = 0;
+    for (gint i = first; i < first + n; i++)
+    {
+        const gint64 set = mock_device_get_set_time(inputs + i);
+        if (set < since)
+        {
+            return 0;
+        }
+        latest = MAX(latest, set);
+    }
+    return latest;
+}
+
+/* Latest notification of outputs first to first + n - 1, 0 until all have notified state after since */
+static gint64 get_notify_time(const gint first, const gint n, const bool state, const gint64 since)
+{
+    gint64 latest = 0;
+    for (gint i = first; i < first + n; i++)
+    {
+        if (notified_us[i] < since || state != notified_states[i])
+        {
+            return 0;
+        }
+        latest = MAX(latest, notified_us[i]);
+    }
+    return latest;
+}
+
+/* Iterate the client until the mock has seen SetState of the outputs and their states are notified */
+static bool wait_for(
+    UA_Client *client,
+    const gint first,
+    const gint n,
+    const bool state,
+    const gint64 since,
+    gint64 *set,
+    gint64 *notified)
+{
+    const gint64 deadline = g_get_monotonic_time() + WAIT_TIMEOUT_MS * 1000;
+    *set = 0;
+    *notified = 0;
+    while (0 == *set || 0 == *notified)
+    {
+        if (g_get_monotonic_time() > deadline)
+        {
+            fprintf(stderr, "Timed out waiting for outputs %d to %d\n", first, first + n - 1);
+            return false;
+        }
+        UA_Client_run_iterate(client, ITERATE_TIMEOUT_MS);
+        *set = 0 == *set ? get_set_time(first, n, since) : *set;
+        *notified = 0 == *notified ? get_notify_time(first, n, state, since) : *notified;
+    }
+    return true;
+}
+
+static bool measure_write(UA_Client *client, samples_t *round_trip, samples_t *to_set)
+{
+    for (gint i = 0; i < count; i++)
+    {
+        const gint output = i % outputs;
+        UA_Boolean state = !notified_states[output];
+        UA_Variant value;
+        UA_Variant_setScalar(&value, &state, &UA_TYPES[UA_TYPES_BOOLEAN]);
+
+        const gint64 start = g_get_monotonic_time();
+        const UA_StatusCode status =
+            UA_Client_writeValueAttribute(client, UA_NODEID_NUMERIC(1, NODEID_PORT_BASE + inputs + output), &value);
+        const gint64 done = g_get_monotonic_time();
+        if (UA_STATUSCODE_GOOD != status)
+        {
+            fprintf(stderr, "Failed to write output %d (%s)\n", output, UA_StatusCode_name(status));
+            return false;
+        }
+
+        // Wait for the confirmed state to settle the next toggle
+        gint64 set;
+        gint64 notified;
+        if (!wait_for(client, output, 1, state, start, &set, &notified))
+        {
+            return false;
+        }
+        round_trip->values[round_trip->count++] = done - start;
+        to_set->values[to_set->count++] = set - start;
+    }
+    return true;
+}
+
+static bool measure_method(UA_Client *client, samples_t *round_trip, samples_t *to_set, samples_t *to_notify)
+{
+    UA_UInt32 *ports = g_new(UA_UInt32, outputs);
+    UA_Boolean *states = g_new(UA_Boolean, outputs);
+    for (gint i = 0; i < outputs; i++)
+    {
+        ports[i] = inputs + i;
+    }
+    UA_Variant input[2];
+    UA_Variant_setArray(&input[0], ports, outputs, &UA_TYPES[UA_TYPES_UINT32]);
+    UA_Variant_setArray(&input[1], states, outputs, &UA_TYPES[UA_TYPES_BOOLEAN]);
+
+    bool ok = true;
+    for (gint i = 0; i < count && ok; i++)
+    {
+        const bool state = !notified_states[0];
+        for (gint j = 0; j < outputs; j++)
+        {
+            states[j] = state;
+        }
+
+        size_t output_size = 0;
+        UA_Variant *output = NULL;
+        const gint64 start = g_get_monotonic_time();
+        UA_StatusCode status = UA_Client_call(
+            client,
+            UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+            UA_NODEID_NUMERIC(1, NODEID_SET_OUTPUTS),
+            2,
+            input,
+            &output_size,
+            &output);
+        const gint64 done = g_get_monotonic_time();
+        if (UA_STATUSCODE_GOOD == status && 1 == output_size)
+        {
+            const UA_StatusCode *results = output[0].data;
+            for (size_t j = 0; j < output[0].arrayLength && UA_STATUSCODE_GOOD == status; j++)
+            {
+                status = results[j];
+            }
+        }
+        UA_Array_delete(output, output_size, &UA_TYPES[UA_TYPES_VARIANT]);
+        if (UA_STATUSCODE_GOOD != status)
+        {
+            fprintf(stderr, "Failed to call SetOutputs (%s)\n", UA_StatusCode_name(status));
+            ok = false;
+            break;
+        }
+
+        gint64 set;
+        gint64 notified;
+        ok = wait_for(client, 0, outputs, state, start, &set, &notified);
+        if (ok)
+        {
+            round_trip->values[round_trip->count++] = done - start;
+            to_set->values[to_set->count++] = set - start;
+            to_notify->values[to_notify->count++] = notified - start;
+        }
+    }
+    g_free(states);
+    g_free(ports);
+    return ok;
+}
+
+static int compare_latency(const void *a, const void *b)
+{
+    const gint64 x = *(const gint64 *)a;
+    const gint64 y = *(const gint64 *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const samples_t *samples, const double p)
+{
+    const guint i = (guint)(p / 100.0 * (samples->count - 1) + 0.5);
+    return samples->values[i] / 1000.0;
+}
+
+static void report(samples_t *samples)
+{
+    if (0 == samples->count)
+    {
+        return;
+    }
+    qsort(samples->values, samples->count, sizeof(*samples->values), compare_latency);
+    printf(
+        "%-24s %8.2f %8.2f %8.2f %8.2f\n",
+        samples->name,
+        percentile(samples, 50),
+        percentile(samples, 90),
+        percentile(samples, 99),
+        samples->values[samples->count - 1] / 1000.0);
+}
+
+static GSubprocess *spawn_server(const gchar *address)
+{
+    GError *error = NULL;
+    gchar *port = g_strdup_printf("%d", ua_port);
+    GSubprocessLauncher *launcher = g_subprocess_launcher_new(G_SUBPROCESS_FLAGS_STDERR_MERGE);
+    g_subprocess_launcher_setenv(launcher, "DBUS_SYSTEM_BUS_ADDRESS", address, TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_port", port, TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_serverMinPublishingInterval", "1", TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_serverMinSamplingInterval", "1", TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_logLevel", "warning", FALSE);
+    g_subprocess_launcher_set_stdout_file_path(launcher, server_log);
+
+    GSubprocess *server = g_subprocess_launcher_spawn(launcher, &error, server_path, NULL);
+    if (NULL == server)
+    {
+        fprintf(stderr, "Failed to start %s (%s)\n", server_path, error->message);
+        g_error_free(error);
+    }
+    g_object_unref(launcher);
+    g_free(port);
+    return server;
+}
+
+static bool run(const gchar *address, GSubprocess **server, UA_Client **client)
+{
+    if (!mock_device_start(address, 0, inputs, outputs) || NULL == (*server = spawn_server(address)) ||
+        NULL == (*client = bench_connect_client(ua_port, CONNECT_TIMEOUT_S)) || !subscribe_outputs(*client))
+    {
+        return false;
+    }
+
+    // Let the initial values arrive
+    iterate(*client, g_get_monotonic_time() + SETTLE_MS * 1000);
+
+    samples_t samples[] = {
+        {"Write round trip", g_new(gint64, count), 0},
+        {"Write to SetState", g_new(gint64, count), 0},
+        {"SetOutputs round trip", g_new(gint64, count), 0},
+        {"SetOutputs to SetState", g_new(gint64, count), 0},
+        {"SetOutputs to notified", g_new(gint64, count), 0}};
+    const bool ok = measure_write(*client, &samples[0], &samples[1]) &&
+                    measure_method(*client, &samples[2], &samples[3], &samples[4]);
+    if (ok)
+    {
+        printf("%d writes of one output, %d SetOutputs calls of %d outputs\n", count, count, outputs);
+        printf("%-24s %8s %8s %8s %8s\n", "ms", "p50", "p90", "p99", "max");
+        for (guint i = 0; i < G_N_ELEMENTS(samples); i++)
+        {
+            report(&samples[i]);
+        }
+    }
+    for (guint i = 0; i < G_N_ELEMENTS(samples); i++)
+    {
+        g_free(samples[i].values);
+    }
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    GError *error = NULL;
+    GOptionContext *options = g_option_context_new("- actuation latency of output ports through opcuaserver");
+    g_option_context_add_main_entries(options, entries, NULL);
+    if (!g_option_context_parse(options, &argc, &argv, &error))
+    {
+        fprintf(stderr, "%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free(options);
+    if (0 > inputs || 0 >= outputs || 0 >= count)
+    {
+        fprintf(stderr, "Invalid options\n");
+        return EXIT_FAILURE;
+    }
+    notified_states = g_new0(bool, outputs);
+    notified_us = g_new0(gint64, outputs);
+
+    // A private bus in place of the system bus
+    GTestDBus *bus = g_test_dbus_new(G_TEST_DBUS_NONE);
+    g_test_dbus_up(bus);
+    GSubprocess *server = NULL;
+    UA_Client *client = NULL;
+    const bool ok = run(g_test_dbus_get_bus_address(bus), &server, &client);
+
+    if (NULL != client)
+    {
+        UA_Client_disconnect(client);
+        UA_Client_delete(client);
+    }
+    if (NULL != server)
+    {
+        bench_stop_server(server);
+    }
+    mock_device_stop();
+    g_test_dbus_down(bus);
+    g_object_unref(bus);
+    g_free(notified_us);
+    g_free(notified_states);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,202 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Signals decoded per second: the old decoding (one child value per tuple
+ * member and strcmp dispatch) against dbus_port_unpack_signal and
+ * dbus_temp_unpack_signal with quark dispatch. Every signal body is parsed
+ * from a D-Bus message with g_dbus_message_new_from_blob, which gives the
+ * same GVariants as GDBus delivers, and the parsing alone is measured as well.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "opcua_dbus.h"
+
+#define SIGNALS 1000000
+
+/* Decoding of a PortChanged signal as it was done before */
+static bool old_port_unpack_signal(GVariant *parameters, dbus_port_signal_t *signal)
+{
+    gboolean *values[] = {
+        &signal->virtual,
+        &signal->hidden,
+        &signal->input,
+        &signal->virtual_trig,
+        &signal->state,
+        &signal->activelow,
+    };
+    GVariant *gvalue = g_variant_get_child_value(parameters, 0);
+    if (!gvalue)
+    {
+        return false;
+    }
+    signal->subscription_id = g_variant_get_int32(gvalue);
+    signal->port = g_variant_get_int32(gvalue);
+    g_variant_unref(gvalue);
+    for (gsize i = 0; i < G_N_ELEMENTS(values); i++)
+    {
+        gvalue = g_variant_get_child_value(parameters, i + 1);
+        if (!gvalue)
+        {
+            return false;
+        }
+        *values[i] = g_variant_get_boolean(gvalue);
+        g_variant_unref(gvalue);
+    }
+    return true;
+}
+
+/* The temperature signal as it was decoded before */
+static bool old_temp_unpack_signal(GVariant *parameters, uint32_t *subscription_id, double *value)
+{
+    GVariant *gvalue = g_variant_get_child_value(parameters, 0);
+    if (!gvalue)
+    {
+        return false;
+    }
+    *subscription_id = g_variant_get_int32(gvalue);
+    g_variant_unref(gvalue);
+    gvalue = g_variant_get_child_value(parameters, 1);
+    if (!gvalue)
+    {
+        return false;
+    }
+    *value = g_variant_get_double(gvalue);
+    g_variant_unref(gvalue);
+    return true;
+}
+
+/* A signal with the given body, marshalled as it comes over the bus */
+static guchar *marshal(const gchar *interface, const gchar *name, GVariant *body, gsize *size)
+{
+    GDBusMessage *message = g_dbus_message_new_signal("/bench", interface, name);
+    g_dbus_message_set_body(message, body);
+    guchar *blob = g_dbus_message_to_blob(message, size, G_DBUS_CAPABILITY_FLAGS_NONE, NULL);
+    g_object_unref(message);
+    return blob;
+}
+
+static GDBusMessage *parse(guchar *blob, const gsize size)
+{
+    GDBusMessage *message = g_dbus_message_new_from_blob(blob, size, G_DBUS_CAPABILITY_FLAGS_NONE, NULL);
+    assert(NULL != message);
+    return message;
+}
+
+static double rate(const gint64 start)
+{
+    return SIGNALS / ((g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC);
+}
+
+int main(void)
+{
+    gsize port_size;
+    gsize temp_size;
+    guchar *port_blob = marshal(
+        "com.axis.IOControl.State",
+        PORT_SIGNAL_NAME,
+        g_variant_new("(ibbbbbb)", 3, FALSE, FALSE, TRUE, FALSE, TRUE, FALSE),
+        &port_size);
+    guchar *temp_blob =
+        marshal("com.axis.TemperatureController", TEMP_SIGNAL_NAME, g_variant_new("(id)", 7, 42.5), &temp_size);
+    guchar *blobs[] = {temp_blob, port_blob};
+    const gsize sizes[] = {temp_size, port_size};
+    const gchar *names[] = {TEMP_SIGNAL_NAME, PORT_SIGNAL_NAME};
+    const GQuark port_quark = g_quark_from_static_string(PORT_SIGNAL_NAME);
+    dbus_port_signal_t signal;
+    uint32_t subid;
+    double value;
+    guint64 sink = 0;
+
+    // Sanity check that both decoders agree
+    dbus_port_signal_t expected;
+    memset(&expected, 0, sizeof(expected));
+    memset(&signal, 0, sizeof(signal));
+    GDBusMessage *port_message = parse(port_blob, port_size);
+    GDBusMessage *temp_message = parse(temp_blob, temp_size);
+    GVariant *port_body = g_dbus_message_get_body(port_message);
+    GVariant *temp_body = g_dbus_message_get_body(temp_message);
+    const bool agree = old_port_unpack_signal(port_body, &expected) && dbus_port_unpack_signal(port_body, &signal) &&
+                       0 == memcmp(&expected, &signal, sizeof(signal)) &&
+                       dbus_temp_unpack_signal(temp_body, &subid, &value) && 7 == subid && 42.5 == value;
+    g_object_unref(port_message);
+    g_object_unref(temp_message);
+    if (!agree)
+    {
+        fprintf(stderr, "Decoders disagree\n");
+        return EXIT_FAILURE;
+    }
+
+    gint64 start = g_get_monotonic_time();
+    for (guint i = 0; i < SIGNALS; i++)
+    {
+        GDBusMessage *message = parse(blobs[i & 1], sizes[i & 1]);
+        sink += NULL != g_dbus_message_get_body(message);
+        g_object_unref(message);
+    }
+    const double parse_rate = rate(start);
+
+    start = g_get_monotonic_time();
+    for (guint i = 0; i < SIGNALS; i++)
+    {
+        GDBusMessage *message = parse(blobs[i & 1], sizes[i & 1]);
+        const gchar *name = names[i & 1];
+        if (0 == strcmp(name, TEMP_SIGNAL_NAME))
+        {
+            old_temp_unpack_signal(g_dbus_message_get_body(message), &subid, &value);
+            sink += subid;
+        }
+        if (0 == strcmp(name, PORT_SIGNAL_NAME))
+        {
+            old_port_unpack_signal(g_dbus_message_get_body(message), &signal);
+            sink += signal.state;
+        }
+        g_object_unref(message);
+    }
+    const double old_rate = rate(start);
+
+    start = g_get_monotonic_time();
+    for (guint i = 0; i < SIGNALS; i++)
+    {
+        GDBusMessage *message = parse(blobs[i & 1], sizes[i & 1]);
+        // GLib resolves the detail of "g-signal::<name>" to a quark once per emission
+        if (port_quark == g_quark_try_string(names[i & 1]))
+        {
+            dbus_port_unpack_signal(g_dbus_message_get_body(message), &signal);
+            sink += signal.state;
+        }
+        else
+        {
+            dbus_temp_unpack_signal(g_dbus_message_get_body(message), &subid, &value);
+            sink += subid;
+        }
+        g_object_unref(message);
+    }
+    const double new_rate = rate(start);
+
+    printf("checksum %llu\n", (unsigned long long)sink);
+    printf("message parsing only:          %12.0f signals/s\n", parse_rate);
+    printf("child values + strcmp:         %12.0f signals/s\n", old_rate);
+    printf("g_variant_get + quark:         %12.0f signals/s\n", new_rate);
+
+    g_free(port_blob);
+    g_free(temp_blob);
+    return EXIT_SUCCESS;
+}
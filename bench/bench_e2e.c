@@ -0,0 +1,465 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * End to end benchmark on a plain Linux host. Starts a private D-Bus bus with
+ * the mock device services, runs opcuaserver (built with the axparameter stub)
+ * against it and subscribes to every node with an open62541 client. The mock
+ * emits signals at a fixed rate and the benchmark reports the throughput, the
+ * latency from D-Bus emit to DataChangeNotification and the server's CPU time
+ * and memory.
+ *
+ * Latency is measured on the temperatures, whose values are the sequence
+ * numbers of the signals. Ports are toggled to load the port path and are only
+ * counted.
+ */
+
+#include <open62541/client_highlevel.h>
+#include <open62541/client_subscriptions.h>
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mock_device.h"
+
+#define CONNECT_TIMEOUT_S 10
+#define SETTLE_MS 500
+#define DRAIN_MS 1000
+#define ITERATE_TIMEOUT_MS 10
+#define NODEID_TEMP_BASE 1000
+#define NODEID_PORT_BASE 2000
+
+/* Update queue variables of the Diagnostics object (ns=1;i=3500) and the queue's capacity */
+#define NODEID_DIAG_DROPPED 3506
+#define NODEID_DIAG_QUEUE_DEPTH 3507
+#define NODEID_DIAG_QUEUE_HIGH_WATER 3508
+#define UPDATE_QUEUE_CAPACITY 1024
+
+static gint temps = 8;
+static gint inputs = 4;
+static gint outputs = 4;
+static gint rate = 1000;
+static gint duration = 10;
+static gint ua_port = 48400;
+static gdouble publishing_interval = 0.0;
+static gdouble sampling_interval = 0.0;
+static gint queue_size = 100;
+static gchar *server_path = "bench/opcuaserver";
+static gchar *server_log = "bench/opcuaserver.log";
+
+static const GOptionEntry entries[] = {
+    {"temps", 't', 0, G_OPTION_ARG_INT, &temps, "Number of temperature sensors (8)", "N"},
+    {"inputs", 'i', 0, G_OPTION_ARG_INT, &inputs, "Number of input ports (4)", "N"},
+    {"outputs", 'o', 0, G_OPTION_ARG_INT, &outputs, "Number of output ports (4)", "N"},
+    {"rate", 'r', 0, G_OPTION_ARG_INT, &rate, "Signals per second, over all channels (1000)", "N"},
+    {"duration", 'd', 0, G_OPTION_ARG_INT, &duration, "Seconds to emit signals (10)", "S"},
+    {"port", 'p', 0, G_OPTION_ARG_INT, &ua_port, "OPC UA server port (48400)", "PORT"},
+    {"publishing-interval", 0, 0, G_OPTION_ARG_DOUBLE, &publishing_interval, "Requested publishing interval", "MS"},
+    {"sampling-interval", 0, 0, G_OPTION_ARG_DOUBLE, &sampling_interval, "Requested sampling interval", "MS"},
+    {"queue-size", 0, 0, G_OPTION_ARG_INT, &queue_size, "Monitored item queue size (100)", "N"},
+    {"server", 0, 0, G_OPTION_ARG_FILENAME, &server_path, "opcuaserver to run", "PATH"},
+    {"server-log", 0, 0, G_OPTION_ARG_FILENAME, &server_log, "Where to write the server's output", "PATH"},
+    {NULL, 0, 0, 0, NULL, NULL, NULL}};
+
+/* Emit time of each signal, indexed by sequence number */
+static atomic_int_fast64_t *emit_us;
+static guint total;
+static atomic_bool emitting;
+
+/* Only touched by the client thread */
+static gint64 *latencies;
+static guint nbr_latencies;
+static guint port_notifications;
+static gint64 last_notification;
+static bool *seen;
+
+typedef struct
+{
+    double cpu_s;
+    long rss_kb;
+    long hwm_kb;
+} usage_t;
+
+static bool get_usage(GPid pid, usage_t *usage)
+{
+    usage->cpu_s = bench_get_cpu_s(pid);
+
+    gchar *status = NULL;
+    gchar *path = g_strdup_printf("/proc/%d/status", pid);
+    bool ok = g_file_get_contents(path, &status, NULL, NULL);
+    g_free(path);
+    if (ok)
+    {
+        const gchar *rss = strstr(status, "VmRSS:");
+        const gchar *hwm = strstr(status, "VmHWM:");
+        usage->rss_kb = NULL != rss ? atol(rss + strlen("VmRSS:")) : 0;
+        usage->hwm_kb = NULL != hwm ? atol(hwm + strlen("VmHWM:")) : 0;
+    }
+    g_free(status);
+    return ok;
+}
+
+static void on_data_change(
+    UA_Client *client,
+    UA_UInt32 sub_id,
+    void *sub_context,
+    UA_UInt32 mon_id,
+    void *mon_context,
+    UA_DataValue *value)
+{
+    (void)client;
+    (void)sub_id;
+    (void)sub_context;
+    (void)mon_id;
+    const guint channel = GPOINTER_TO_UINT(mon_context);
+    const gint64 now = g_get_monotonic_time();
+
+    // The first notification of each item is the initial value
+    if (!seen[channel])
+    {
+        seen[channel] = true;
+        return;
+    }
+    last_notification = now;
+    if (!value->hasValue)
+    {
+        return;
+    }
+    if (UA_Variant_hasScalarType(&value->value, &UA_TYPES[UA_TYPES_BOOLEAN]))
+    {
+        port_notifications++;
+        return;
+    }
+    if (!UA_Variant_hasScalarType(&value->value, &UA_TYPES[UA_TYPES_DOUBLE]))
+    {
+        return;
+    }
+    const double seq = *(UA_Double *)value->value.data;
+    if (0 > seq || total <= seq)
+    {
+        return;
+    }
+    const gint64 emitted = atomic_load(&emit_us[(guint)seq]);
+    if (0 < emitted)
+    {
+        latencies[nbr_latencies++] = now - emitted;
+    }
+}
+
+static gpointer emit_signals(gpointer data)
+{
+    (void)data;
+    const guint channels = temps + inputs + outputs;
+    bool *states = g_new0(bool, inputs + outputs);
+    const gint64 start = g_get_monotonic_time();
+
+    for (guint i = 0; i < total; i++)
+    {
+        const gint64 due = start + (gint64)i * G_USEC_PER_SEC / rate;
+        gint64 now = g_get_monotonic_time();
+        if (due > now)
+        {
+            g_usleep(due - now);
+            now = g_get_monotonic_time();
+        }
+        const guint channel = i % channels;
+        if (channel < (guint)temps)
+        {
+            atomic_store(&emit_us[i], now);
+            mock_device_emit_temp(channel, i);
+        }
+        else
+        {
+            const guint port = channel - temps;
+            states[port] = !states[port];
+            mock_device_emit_port(port, states[port]);
+        }
+    }
+    g_free(states);
+    atomic_store(&emitting, false);
+    return NULL;
+}
+
+static bool subscribe_all(UA_Client *client)
+{
+    const guint channels = temps + inputs + outputs;
+    UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+    request.requestedPublishingInterval = publishing_interval;
+    request.maxNotificationsPerPublish = 0;
+    UA_CreateSubscriptionResponse subscription = UA_Client_Subscriptions_create(client, request, NULL, NULL, NULL);
+    if (UA_STATUSCODE_GOOD != subscription.responseHeader.serviceResult)
+    {
+        fprintf(
+            stderr,
+            "Failed to create subscription (%s)\n",
+            UA_StatusCode_name(subscription.responseHeader.serviceResult));
+        return false;
+    }
+
+    UA_MonitoredItemCreateRequest *items = g_new0(UA_MonitoredItemCreateRequest, channels);
+    void **contexts = g_new0(void *, channels);
+    UA_Client_DataChangeNotificationCallback *callbacks = g_new0(UA_Client_DataChangeNotificationCallback, channels);
+    UA_Client_DeleteMonitoredItemCallback *delete_callbacks = g_new0(UA_Client_DeleteMonitoredItemCallback, channels);
+    for (guint i = 0; i < channels; i++)
+    {
+        const UA_UInt32 id = i < (guint)temps ? NODEID_TEMP_BASE + i : NODEID_PORT_BASE + i - temps;
+        items[i] = UA_MonitoredItemCreateRequest_default(UA_NODEID_NUMERIC(1, id));
+        items[i].requestedParameters.samplingInterval = sampling_interval;
+        items[i].requestedParameters.queueSize = queue_size;
+        contexts[i] = GUINT_TO_POINTER(i);
+        callbacks[i] = on_data_change;
+    }
+
+    UA_CreateMonitoredItemsRequest create;
+    UA_CreateMonitoredItemsRequest_init(&create);
+    create.subscriptionId = subscription.subscriptionId;
+    create.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+    create.itemsToCreate = items;
+    create.itemsToCreateSize = channels;
+    UA_CreateMonitoredItemsResponse response =
+        UA_Client_MonitoredItems_createDataChanges(client, create, contexts, callbacks, delete_callbacks);
+
+    bool ok = UA_STATUSCODE_GOOD == response.responseHeader.serviceResult && channels == response.resultsSize;
+    for (size_t i = 0; ok && i < response.resultsSize; i++)
+    {
+        if (UA_STATUSCODE_GOOD != response.results[i].statusCode)
+        {
+            fprintf(stderr, "Failed to monitor item %zu (%s)\n", i, UA_StatusCode_name(response.results[i].statusCode));
+            ok = false;
+        }
+    }
+    if (ok)
+    {
+        printf(
+            "publishing interval %.1f ms, sampling interval %.1f ms (revised by the server)\n",
+            subscription.revisedPublishingInterval,
+            response.results[0].revisedSamplingInterval);
+    }
+    UA_CreateMonitoredItemsResponse_clear(&response);
+    g_free(items);
+    g_free(contexts);
+    g_free(callbacks);
+    g_free(delete_callbacks);
+    return ok;
+}
+
+static void iterate(UA_Client *client, const gint64 until)
+{
+    while (g_get_monotonic_time() < until || atomic_load(&emitting))
+    {
+        UA_Client_run_iterate(client, ITERATE_TIMEOUT_MS);
+    }
+}
+
+static int compare_latency(const void *a, const void *b)
+{
+    const gint64 x = *(const gint64 *)a;
+    const gint64 y = *(const gint64 *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double p)
+{
+    const guint i = (guint)(p / 100.0 * (nbr_latencies - 1) + 0.5);
+    return latencies[i] / 1000.0;
+}
+
+static void report(const gint64 start, const double elapsed, const usage_t *before, const usage_t *after)
+{
+    const guint channels = temps + inputs + outputs;
+    const guint temps_emitted = total / channels * temps + MIN(total % channels, (guint)temps);
+    const double seconds = (last_notification - start) / (double)G_USEC_PER_SEC;
+
+    printf(
+        "%u signals emitted at %d/s over %u temperatures and %u ports\n",
+        total,
+        rate,
+        (guint)temps,
+        (guint)(inputs + outputs));
+    printf(
+        "temperatures: %u of %u delivered, ports: %u of %u delivered, %.0f notifications/s\n",
+        nbr_latencies,
+        temps_emitted,
+        port_notifications,
+        total - temps_emitted,
+        0 < seconds ? (nbr_latencies + port_notifications) / seconds : 0.0);
+    if (0 < nbr_latencies)
+    {
+        qsort(latencies, nbr_latencies, sizeof(*latencies), compare_latency);
+        printf(
+            "latency ms: p50 %.2f  p90 %.2f  p99 %.2f  p99.9 %.2f  max %.2f\n",
+            percentile(50),
+            percentile(90),
+            percentile(99),
+            percentile(99.9),
+            latencies[nbr_latencies - 1] / 1000.0);
+    }
+    printf(
+        "server: cpu %.1f%% (%.2f s), rss %ld kB, peak rss %ld kB\n",
+        100.0 * (after->cpu_s - before->cpu_s) / elapsed,
+        after->cpu_s - before->cpu_s,
+        after->rss_kb,
+        after->hwm_kb);
+}
+
+static bool read_diagnostic(UA_Client *client, const UA_UInt32 id, UA_UInt64 *count)
+{
+    UA_Variant value;
+    UA_Variant_init(&value);
+    const UA_StatusCode status = UA_Client_readValueAttribute(client, UA_NODEID_NUMERIC(1, id), &value);
+    const bool ok = UA_STATUSCODE_GOOD == status && UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_UINT64]);
+    if (ok)
+    {
+        *count = *(UA_UInt64 *)value.data;
+    }
+    else
+    {
+        fprintf(stderr, "Failed to read diagnostics variable %u (%s)\n", id, UA_StatusCode_name(status));
+    }
+    UA_Variant_clear(&value);
+    return ok;
+}
+
+/* After the drain the queue is empty, and it only fills up when updates were dropped */
+static bool check_diagnostics(UA_Client *client)
+{
+    UA_UInt64 dropped = 0;
+    UA_UInt64 depth = 0;
+    UA_UInt64 high_water = 0;
+    if (!read_diagnostic(client, NODEID_DIAG_DROPPED, &dropped) ||
+        !read_diagnostic(client, NODEID_DIAG_QUEUE_DEPTH, &depth) ||
+        !read_diagnostic(client, NODEID_DIAG_QUEUE_HIGH_WATER, &high_water))
+    {
+        return false;
+    }
+    printf(
+        "update queue: depth %llu, high-water %llu of %d, dropped %llu\n",
+        (unsigned long long)depth,
+        (unsigned long long)high_water,
+        UPDATE_QUEUE_CAPACITY,
+        (unsigned long long)dropped);
+    const bool ok = 0 == depth && 0 < high_water && (UPDATE_QUEUE_CAPACITY > high_water || 0 < dropped);
+    if (!ok)
+    {
+        fprintf(stderr, "Unexpected update queue diagnostics\n");
+    }
+    return ok;
+}
+
+static GSubprocess *spawn_server(const gchar *address)
+{
+    GError *error = NULL;
+    gchar *port = g_strdup_printf("%d", ua_port);
+    GSubprocessLauncher *launcher = g_subprocess_launcher_new(G_SUBPROCESS_FLAGS_STDERR_MERGE);
+    g_subprocess_launcher_setenv(launcher, "DBUS_SYSTEM_BUS_ADDRESS", address, TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_port", port, TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_logLevel", "warning", FALSE);
+    g_subprocess_launcher_set_stdout_file_path(launcher, server_log);
+
+    GSubprocess *server = g_subprocess_launcher_spawn(launcher, &error, server_path, NULL);
+    if (NULL == server)
+    {
+        fprintf(stderr, "Failed to start %s (%s)\n", server_path, error->message);
+        g_error_free(error);
+    }
+    g_object_unref(launcher);
+    g_free(port);
+    return server;
+}
+
+static bool run(const gchar *address, GSubprocess **server, UA_Client **client)
+{
+    if (!mock_device_start(address, temps, inputs, outputs) || NULL == (*server = spawn_server(address)) ||
+        NULL == (*client = bench_connect_client(ua_port, CONNECT_TIMEOUT_S)) || !subscribe_all(*client))
+    {
+        return false;
+    }
+    const GPid pid = atoi(g_subprocess_get_identifier(*server));
+
+    // Let the initial values arrive
+    iterate(*client, g_get_monotonic_time() + SETTLE_MS * 1000);
+
+    usage_t before;
+    usage_t after;
+    if (!get_usage(pid, &before))
+    {
+        fprintf(stderr, "Failed to read the server's usage\n");
+        return false;
+    }
+    const gint64 start = g_get_monotonic_time();
+    atomic_store(&emitting, true);
+    GThread *emitter = g_thread_new("emitter", emit_signals, NULL);
+    iterate(*client, 0);
+    const double elapsed = (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+    const bool got_usage = get_usage(pid, &after);
+    iterate(*client, g_get_monotonic_time() + DRAIN_MS * 1000);
+    g_thread_join(emitter);
+    if (!got_usage)
+    {
+        fprintf(stderr, "Failed to read the server's usage\n");
+        return false;
+    }
+    report(start, elapsed, &before, &after);
+    return check_diagnostics(*client);
+}
+
+int main(int argc, char **argv)
+{
+    GError *error = NULL;
+    GOptionContext *options = g_option_context_new("- end to end latency through opcuaserver");
+    g_option_context_add_main_entries(options, entries, NULL);
+    if (!g_option_context_parse(options, &argc, &argv, &error))
+    {
+        fprintf(stderr, "%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free(options);
+    if (0 >= temps || 0 > inputs || 0 > outputs || 0 >= rate || 0 >= duration)
+    {
+        fprintf(stderr, "Invalid options\n");
+        return EXIT_FAILURE;
+    }
+
+    total = (guint)rate * duration;
+    emit_us = calloc(total, sizeof(*emit_us));
+    latencies = g_new(gint64, total);
+    seen = g_new0(bool, temps + inputs + outputs);
+
+    // A private bus in place of the system bus
+    GTestDBus *bus = g_test_dbus_new(G_TEST_DBUS_NONE);
+    g_test_dbus_up(bus);
+    GSubprocess *server = NULL;
+    UA_Client *client = NULL;
+    const bool ok = run(g_test_dbus_get_bus_address(bus), &server, &client);
+
+    if (NULL != client)
+    {
+        UA_Client_disconnect(client);
+        UA_Client_delete(client);
+    }
+    if (NULL != server)
+    {
+        bench_stop_server(server);
+    }
+    mock_device_stop();
+    g_test_dbus_down(bus);
+    g_object_unref(bus);
+    g_free(seen);
+    g_free(latencies);
+    free(emit_us);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,382 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Event check on a plain Linux host. Runs opcuaserver (built with the
+ * axparameter stub) against the mock device services on a private D-Bus bus
+ * with a high limit alarm on the temperature sensor, and subscribes to the
+ * events of the Server object with an event filter. It then toggles an input
+ * port and moves the temperature across the limit and back through the
+ * hysteresis, and fails unless exactly the expected PortTransitionEventType
+ * and ExclusiveLevelAlarmType events arrive. Reports the time from each
+ * signal to its event.
+ */
+
+#include <open62541/client_highlevel.h>
+#include <open62541/client_subscriptions.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mock_device.h"
+
+#define CONNECT_TIMEOUT_S 10
+#define SETTLE_MS 500
+#define WAIT_TIMEOUT_MS 2000
+#define QUIET_MS 300
+#define ITERATE_TIMEOUT_MS 1
+#define EVENTS_MAX 64
+#define NODEID_TEMP_BASE 1000
+#define NODEID_PORT_BASE 2000
+#define NODEID_PORT_TRANSITION 3300
+#define ALARM_HIGH 50.0
+#define ALARM_HYSTERESIS 2.0
+
+static gint ua_port = 48430;
+static gchar *server_path = "bench/opcuaserver";
+static gchar *server_log = "bench/opcuaserver.log";
+
+static const GOptionEntry entries[] = {
+    {"port", 'p', 0, G_OPTION_ARG_INT, &ua_port, "OPC UA server port (48430)", "PORT"},
+    {"server", 0, 0, G_OPTION_ARG_FILENAME, &server_path, "opcuaserver to run", "PATH"},
+    {"server-log", 0, 0, G_OPTION_ARG_FILENAME, &server_log, "Where to write the server's output", "PATH"},
+    {NULL, 0, 0, 0, NULL, NULL, NULL}};
+
+/* Fields selected by the event filter, in the order of the event's values */
+typedef enum
+{
+    FIELD_EVENT_TYPE,
+    FIELD_SOURCE_NODE,
+    FIELD_RISING,
+    FIELD_ACTIVE,
+    FIELDS
+} field_t;
+
+typedef struct
+{
+    UA_NodeId type; // numeric only, the other fields are not kept
+    UA_NodeId source;
+    bool state; // Rising of a port transition, ActiveState/Id of an alarm
+    gint64 received_us;
+} event_t;
+
+/* A signal of the mock services and the event it should cause */
+typedef struct
+{
+    const char *what;
+    bool port;    // a state of input port 0, otherwise a temperature of sensor 0
+    double value; // the state or the temperature
+    bool event;
+    bool state;
+} step_t;
+
+static const step_t steps[] = {
+    {"port rising", true, 1.0, true, true},
+    {"port falling", true, 0.0, true, false},
+    {"below the high limit", false, ALARM_HIGH - 5.0, false, false},
+    {"above the high limit", false, ALARM_HIGH + 1.0, true, true},
+    {"below the limit, within the hysteresis", false, ALARM_HIGH - ALARM_HYSTERESIS / 2, false, false},
+    {"below the hysteresis", false, ALARM_HIGH - ALARM_HYSTERESIS - 1.0, true, false}};
+
+static event_t events[EVENTS_MAX];
+static guint events_count;
+
+static UA_NodeId numeric_field(const UA_Variant *field)
+{
+    if (UA_Variant_hasScalarType(field, &UA_TYPES[UA_TYPES_NODEID]))
+    {
+        const UA_NodeId *id = field->data;
+        if (UA_NODEIDTYPE_NUMERIC == id->identifierType)
+        {
+            return *id;
+        }
+    }
+    return UA_NODEID_NULL;
+}
+
+static void on_event(
+    UA_Client *client,
+    UA_UInt32 sub_id,
+    void *sub_context,
+    UA_UInt32 mon_id,
+    void *mon_context,
+    size_t fields_size,
+    UA_Variant *fields)
+{
+    (void)client;
+    (void)sub_id;
+    (void)sub_context;
+    (void)mon_id;
+    (void)mon_context;
+    if (FIELDS != fields_size || EVENTS_MAX <= events_count)
+    {
+        return;
+    }
+
+    // A port transition has no ActiveState and an alarm no Rising, so one of them is empty
+    event_t *event = &events[events_count++];
+    event->type = numeric_field(&fields[FIELD_EVENT_TYPE]);
+    event->source = numeric_field(&fields[FIELD_SOURCE_NODE]);
+    event->state = false;
+    for (size_t i = FIELD_RISING; i <= FIELD_ACTIVE; i++)
+    {
+        if (UA_Variant_hasScalarType(&fields[i], &UA_TYPES[UA_TYPES_BOOLEAN]))
+        {
+            event->state = *(UA_Boolean *)fields[i].data;
+        }
+    }
+    event->received_us = g_get_monotonic_time();
+}
+
+static UA_SimpleAttributeOperand select_field(const UA_NodeId type, UA_QualifiedName *path, const size_t path_size)
+{
+    UA_SimpleAttributeOperand operand;
+    UA_SimpleAttributeOperand_init(&operand);
+    operand.typeDefinitionId = type;
+    operand.browsePath = path;
+    operand.browsePathSize = path_size;
+    operand.attributeId = UA_ATTRIBUTEID_VALUE;
+    return operand;
+}
+
+static bool subscribe_events(UA_Client *client)
+{
+    UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+    request.requestedPublishingInterval = 0.0;
+    UA_CreateSubscriptionResponse subscription = UA_Client_Subscriptions_create(client, request, NULL, NULL, NULL);
+    if (UA_STATUSCODE_GOOD != subscription.responseHeader.serviceResult)
+    {
+        fprintf(
+            stderr,
+            "Failed to create subscription (%s)\n",
+            UA_StatusCode_name(subscription.responseHeader.serviceResult));
+        return false;
+    }
+
+    UA_QualifiedName event_type = UA_QUALIFIEDNAME(0, "EventType");
+    UA_QualifiedName source_node = UA_QUALIFIEDNAME(0, "SourceNode");
+    UA_QualifiedName rising = UA_QUALIFIEDNAME(1, "Rising");
+    UA_QualifiedName active[] = {UA_QUALIFIEDNAME(0, "ActiveState"), UA_QUALIFIEDNAME(0, "Id")};
+    UA_SimpleAttributeOperand clauses[FIELDS];
+    clauses[FIELD_EVENT_TYPE] = select_field(UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE), &event_type, 1);
+    clauses[FIELD_SOURCE_NODE] = select_field(UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE), &source_node, 1);
+    clauses[FIELD_RISING] = select_field(UA_NODEID_NUMERIC(1, NODEID_PORT_TRANSITION), &rising, 1);
+    clauses[FIELD_ACTIVE] = select_field(UA_NODEID_NUMERIC(0, UA_NS0ID_ALARMCONDITIONTYPE), active, 2);
+
+    UA_EventFilter filter;
+    UA_EventFilter_init(&filter);
+    filter.selectClauses = clauses;
+    filter.selectClausesSize = FIELDS;
+
+    UA_MonitoredItemCreateRequest item;
+    UA_MonitoredItemCreateRequest_init(&item);
+    item.itemToMonitor.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    item.itemToMonitor.attributeId = UA_ATTRIBUTEID_EVENTNOTIFIER;
+    item.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    item.requestedParameters.queueSize = EVENTS_MAX;
+    item.requestedParameters.discardOldest = true;
+    item.requestedParameters.filter.encoding = UA_EXTENSIONOBJECT_DECODED;
+    item.requestedParameters.filter.content.decoded.data = &filter;
+    item.requestedParameters.filter.content.decoded.type = &UA_TYPES[UA_TYPES_EVENTFILTER];
+
+    UA_MonitoredItemCreateResult result = UA_Client_MonitoredItems_createEvent(
+        client,
+        subscription.subscriptionId,
+        UA_TIMESTAMPSTORETURN_BOTH,
+        item,
+        NULL,
+        on_event,
+        NULL);
+    const bool ok = UA_STATUSCODE_GOOD == result.statusCode;
+    if (!ok)
+    {
+        fprintf(
+            stderr,
+            "Failed to monitor the events of the Server object (%s)\n",
+            UA_StatusCode_name(result.statusCode));
+    }
+    UA_MonitoredItemCreateResult_clear(&result);
+    return ok;
+}
+
+/* Iterate the client until it has count events or until is reached */
+static void iterate(UA_Client *client, const guint count, const gint64 until)
+{
+    while (events_count < count && g_get_monotonic_time() < until)
+    {
+        UA_Client_run_iterate(client, ITERATE_TIMEOUT_MS);
+    }
+}
+
+static bool check_event(const step_t *step, const event_t *event)
+{
+    const UA_NodeId type = step->port ? UA_NODEID_NUMERIC(1, NODEID_PORT_TRANSITION)
+                                      : UA_NODEID_NUMERIC(0, UA_NS0ID_EXCLUSIVELEVELALARMTYPE);
+    const UA_NodeId source = UA_NODEID_NUMERIC(1, step->port ? NODEID_PORT_BASE : NODEID_TEMP_BASE);
+    if (!UA_NodeId_equal(&type, &event->type) || !UA_NodeId_equal(&source, &event->source))
+    {
+        fprintf(
+            stderr,
+            "%s: event of type ns=%u;i=%u from ns=%u;i=%u\n",
+            step->what,
+            event->type.namespaceIndex,
+            event->type.identifier.numeric,
+            event->source.namespaceIndex,
+            event->source.identifier.numeric);
+        return false;
+    }
+    if (step->state != event->state)
+    {
+        fprintf(stderr, "%s: event with %s\n", step->what, event->state ? "true" : "false");
+        return false;
+    }
+    return true;
+}
+
+static bool run_step(UA_Client *client, const step_t *step)
+{
+    const guint before = events_count;
+    const gint64 start = g_get_monotonic_time();
+    if (step->port)
+    {
+        mock_device_emit_port(0, 0.0 != step->value);
+    }
+    else
+    {
+        mock_device_emit_temp(0, step->value);
+    }
+
+    // An expected event, and then no other one
+    guint expected = before;
+    if (step->event)
+    {
+        expected++;
+        iterate(client, expected, start + WAIT_TIMEOUT_MS * 1000);
+        if (events_count < expected)
+        {
+            fprintf(stderr, "%s: no event\n", step->what);
+            return false;
+        }
+        if (!check_event(step, &events[before]))
+        {
+            return false;
+        }
+    }
+    iterate(client, expected + 1, g_get_monotonic_time() + QUIET_MS * 1000);
+    if (events_count != expected)
+    {
+        fprintf(stderr, "%s: %u unexpected events\n", step->what, events_count - expected);
+        return false;
+    }
+
+    if (step->event)
+    {
+        printf("%-44s ok %8.2f ms\n", step->what, (events[before].received_us - start) / 1000.0);
+    }
+    else
+    {
+        printf("%-44s ok %11s\n", step->what, "no event");
+    }
+    return true;
+}
+
+static GSubprocess *spawn_server(const gchar *address)
+{
+    GError *error = NULL;
+    gchar *port = g_strdup_printf("%d", ua_port);
+    gchar *high = g_strdup_printf("%.1f", ALARM_HIGH);
+    gchar *hysteresis = g_strdup_printf("%.1f", ALARM_HYSTERESIS);
+    GSubprocessLauncher *launcher = g_subprocess_launcher_new(G_SUBPROCESS_FLAGS_STDERR_MERGE);
+    g_subprocess_launcher_setenv(launcher, "DBUS_SYSTEM_BUS_ADDRESS", address, TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_port", port, TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_serverMinPublishingInterval", "1", TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_portEvents", "yes", TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_alarmHigh", high, TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_alarmHysteresis", hysteresis, TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_logLevel", "warning", FALSE);
+    g_subprocess_launcher_set_stdout_file_path(launcher, server_log);
+
+    GSubprocess *server = g_subprocess_launcher_spawn(launcher, &error, server_path, NULL);
+    if (NULL == server)
+    {
+        fprintf(stderr, "Failed to start %s (%s)\n", server_path, error->message);
+        g_error_free(error);
+    }
+    g_object_unref(launcher);
+    g_free(hysteresis);
+    g_free(high);
+    g_free(port);
+    return server;
+}
+
+static bool run(const gchar *address, GSubprocess **server, UA_Client **client)
+{
+    if (!mock_device_start(address, 1, 1, 0) || NULL == (*server = spawn_server(address)) ||
+        NULL == (*client = bench_connect_client(ua_port, CONNECT_TIMEOUT_S)) || !subscribe_events(*client))
+    {
+        return false;
+    }
+
+    // Let the initial values arrive, they send no events
+    iterate(*client, 1, g_get_monotonic_time() + SETTLE_MS * 1000);
+    if (0 < events_count)
+    {
+        fprintf(stderr, "%u events before the first signal\n", events_count);
+        return false;
+    }
+
+    printf("high limit %.1f, hysteresis %.1f\n", ALARM_HIGH, ALARM_HYSTERESIS);
+    bool ok = true;
+    for (guint i = 0; i < G_N_ELEMENTS(steps) && ok; i++)
+    {
+        ok = run_step(*client, &steps[i]);
+    }
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    GError *error = NULL;
+    GOptionContext *options = g_option_context_new("- port transition and limit alarm events of opcuaserver");
+    g_option_context_add_main_entries(options, entries, NULL);
+    if (!g_option_context_parse(options, &argc, &argv, &error))
+    {
+        fprintf(stderr, "%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free(options);
+
+    // A private bus in place of the system bus
+    GTestDBus *bus = g_test_dbus_new(G_TEST_DBUS_NONE);
+    g_test_dbus_up(bus);
+    GSubprocess *server = NULL;
+    UA_Client *client = NULL;
+    const bool ok = run(g_test_dbus_get_bus_address(bus), &server, &client);
+
+    if (NULL != client)
+    {
+        UA_Client_disconnect(client);
+        UA_Client_delete(client);
+    }
+    if (NULL != server)
+    {
+        bench_stop_server(server);
+    }
+    mock_device_stop();
+    g_test_dbus_down(bus);
+    g_object_unref(bus);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
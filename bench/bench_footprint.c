@@ -0,0 +1,256 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Footprint benchmark on a plain Linux host. Runs each given opcuaserver
+ * binary (one per build profile) against the mock device services on a
+ * private D-Bus bus and reports its stripped size, the time until the
+ * server logs that it is ready, the time until a client first connects and
+ * the peak and steady state resident memory.
+ */
+
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "mock_device.h"
+
+#define CONNECT_TIMEOUT_S 10
+
+static gint temps = 32;
+static gint inputs = 8;
+static gint outputs = 8;
+static gint settle = 2;
+static gint runs = 3;
+static gint ua_port = 48410;
+static gchar *server_log = "bench/opcuaserver.log";
+
+static const GOptionEntry entries[] = {
+    {"temps", 't', 0, G_OPTION_ARG_INT, &temps, "Number of temperature sensors (32)", "N"},
+    {"inputs", 'i', 0, G_OPTION_ARG_INT, &inputs, "Number of input ports (8)", "N"},
+    {"outputs", 'o', 0, G_OPTION_ARG_INT, &outputs, "Number of output ports (8)", "N"},
+    {"settle", 's', 0, G_OPTION_ARG_INT, &settle, "Seconds after connecting before memory is read (2)", "S"},
+    {"runs", 'r', 0, G_OPTION_ARG_INT, &runs, "Runs per binary, the median is reported (3)", "N"},
+    {"port", 'p', 0, G_OPTION_ARG_INT, &ua_port, "OPC UA server port (48410)", "PORT"},
+    {"server-log", 0, 0, G_OPTION_ARG_FILENAME, &server_log, "Where to write the server's output", "PATH"},
+    {NULL, 0, 0, 0, NULL, NULL, NULL}};
+
+typedef struct
+{
+    double ready_ms;
+    double connect_ms;
+    guint64 peak_kb;
+    guint64 steady_kb;
+} sample_t;
+
+/* VmHWM and VmRSS from /proc/<pid>/status, in kB */
+static bool get_memory(GPid pid, guint64 *peak_kb, guint64 *steady_kb)
+{
+    gchar *path = g_strdup_printf("/proc/%d/status", pid);
+    gchar *status = NULL;
+    bool ok = g_file_get_contents(path, &status, NULL, NULL);
+    g_free(path);
+    if (!ok)
+    {
+        return false;
+    }
+
+    const gchar *hwm = strstr(status, "VmHWM:");
+    const gchar *rss = strstr(status, "VmRSS:");
+    ok = NULL != hwm && NULL != rss;
+    if (ok)
+    {
+        *peak_kb = g_ascii_strtoull(hwm + strlen("VmHWM:"), NULL, 10);
+        *steady_kb = g_ascii_strtoull(rss + strlen("VmRSS:"), NULL, 10);
+    }
+    g_free(status);
+    return ok;
+}
+
+/* Milliseconds from spawn until a client gets a session */
+static bool wait_connect(const gint64 spawned, double *connect_ms)
+{
+    gchar *url = g_strdup_printf("opc.tcp://localhost:%d", ua_port);
+    UA_Client *client = UA_Client_new();
+    UA_ClientConfig_setDefault(UA_Client_getConfig(client));
+
+    bool ok = true;
+    const gint64 deadline = spawned + CONNECT_TIMEOUT_S * G_USEC_PER_SEC;
+    while (UA_STATUSCODE_GOOD != UA_Client_connect(client, url))
+    {
+        if (g_get_monotonic_time() > deadline)
+        {
+            fprintf(stderr, "Failed to connect to %s\n", url);
+            ok = false;
+            break;
+        }
+        g_usleep(1000);
+    }
+    *connect_ms = (g_get_monotonic_time() - spawned) / 1000.0;
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+    g_free(url);
+    return ok;
+}
+
+/* The server logs "Ready after <ms> ms" once it has started */
+static bool get_ready_ms(double *ready_ms)
+{
+    gchar *log = NULL;
+    if (!g_file_get_contents(server_log, &log, NULL, NULL))
+    {
+        return false;
+    }
+    const gchar *ready = strstr(log, "Ready after ");
+    if (NULL != ready)
+    {
+        *ready_ms = g_ascii_strtod(ready + strlen("Ready after "), NULL);
+    }
+    g_free(log);
+    return NULL != ready;
+}
+
+static bool measure(const gchar *address, const gchar *path, sample_t *sample)
+{
+    GError *error = NULL;
+    gchar *port = g_strdup_printf("%d", ua_port);
+    GSubprocessLauncher *launcher = g_subprocess_launcher_new(G_SUBPROCESS_FLAGS_STDERR_MERGE);
+    g_subprocess_launcher_setenv(launcher, "DBUS_SYSTEM_BUS_ADDRESS", address, TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_port", port, TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_logLevel", "info", TRUE);
+    g_subprocess_launcher_set_stdout_file_path(launcher, server_log);
+
+    const gint64 spawned = g_get_monotonic_time();
+    GSubprocess *server = g_subprocess_launcher_spawn(launcher, &error, path, NULL);
+    g_object_unref(launcher);
+    g_free(port);
+    if (NULL == server)
+    {
+        fprintf(stderr, "Failed to start %s (%s)\n", path, error->message);
+        g_error_free(error);
+        return false;
+    }
+
+    const GPid pid = atoi(g_subprocess_get_identifier(server));
+    bool ok = wait_connect(spawned, &sample->connect_ms);
+    if (ok)
+    {
+        g_usleep((gulong)settle * G_USEC_PER_SEC);
+        ok = get_memory(pid, &sample->peak_kb, &sample->steady_kb);
+    }
+
+    // The log is complete once the server has exited
+    g_subprocess_send_signal(server, SIGTERM);
+    (void)g_subprocess_wait(server, NULL, NULL);
+    g_object_unref(server);
+    if (ok && !get_ready_ms(&sample->ready_ms))
+    {
+        fprintf(stderr, "No ready time in %s\n", server_log);
+        ok = false;
+    }
+    return ok;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    const double x = *(const double *)a;
+    const double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double median(double *values, const gint count)
+{
+    qsort(values, count, sizeof(*values), compare_double);
+    return values[count / 2];
+}
+
+static bool run(const gchar *address, gchar **paths, const gint count)
+{
+    if (!mock_device_start(address, temps, inputs, outputs))
+    {
+        return false;
+    }
+    printf("%d temperatures, %d inputs, %d outputs, median of %d runs\n", temps, inputs, outputs, runs);
+    printf("%-32s %10s %10s %10s %10s %10s\n", "binary", "size kB", "ready ms", "connect ms", "peak kB", "steady kB");
+
+    double *ready = g_new(double, runs);
+    double *connect = g_new(double, runs);
+    double *peak = g_new(double, runs);
+    double *steady = g_new(double, runs);
+    bool ok = true;
+    for (gint b = 0; b < count && ok; b++)
+    {
+        struct stat st;
+        if (0 != stat(paths[b], &st))
+        {
+            fprintf(stderr, "No such binary %s\n", paths[b]);
+            ok = false;
+            break;
+        }
+        for (gint r = 0; r < runs && ok; r++)
+        {
+            sample_t sample = {0};
+            ok = measure(address, paths[b], &sample);
+            ready[r] = sample.ready_ms;
+            connect[r] = sample.connect_ms;
+            peak[r] = sample.peak_kb;
+            steady[r] = sample.steady_kb;
+        }
+        if (ok)
+        {
+            printf("%-32s %10llu %10.1f %10.1f %10.0f %10.0f\n", paths[b], (unsigned long long)st.st_size / 1024,
+                   median(ready, runs), median(connect, runs), median(peak, runs), median(steady, runs));
+        }
+    }
+    g_free(steady);
+    g_free(peak);
+    g_free(connect);
+    g_free(ready);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    GError *error = NULL;
+    GOptionContext *options = g_option_context_new("BINARY... - size, memory and startup time of opcuaserver builds");
+    g_option_context_add_main_entries(options, entries, NULL);
+    if (!g_option_context_parse(options, &argc, &argv, &error))
+    {
+        fprintf(stderr, "%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free(options);
+
+    if (2 > argc || 0 > temps || 0 > inputs || 0 > outputs || 0 > settle || 0 >= runs)
+    {
+        fprintf(stderr, "Invalid options\n");
+        return EXIT_FAILURE;
+    }
+
+    // A private bus in place of the system bus
+    GTestDBus *bus = g_test_dbus_new(G_TEST_DBUS_NONE);
+    g_test_dbus_up(bus);
+    const bool ok = run(g_test_dbus_get_bus_address(bus), &argv[1], argc - 1);
+    mock_device_stop();
+    g_test_dbus_down(bus);
+    g_object_unref(bus);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,108 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Cost of recording a latency sample: diagnostics_record_latency alone, with
+ * the clock read that ends a stage, and from several threads at once. The
+ * histograms are recorded in production, the target is below 50 ns.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "opcua_diagnostics.h"
+
+#define SAMPLES 20000000
+#define THREADS 4
+
+static double per_sample_ns(const int64_t start_ns)
+{
+    return (double)(diagnostics_now_ns() - start_ns) / SAMPLES;
+}
+
+/* Spread over the buckets like real latencies, from ns to ms */
+static int64_t latency(const uint32_t i)
+{
+    return (int64_t)((i * 2654435761u) >> (i & 15));
+}
+
+static void *record(void *data)
+{
+    (void)data;
+    for (uint32_t i = 0; i < SAMPLES; i++)
+    {
+        diagnostics_record_latency(DIAG_STAGE_WRITE, latency(i));
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    // The first sample creates the thread's block, which is not what is measured
+    diagnostics_record_latency(DIAG_STAGE_WRITE, 0);
+
+    int64_t start = diagnostics_now_ns();
+    for (uint32_t i = 0; i < SAMPLES; i++)
+    {
+        diagnostics_record_latency(DIAG_STAGE_DECODE, latency(i));
+    }
+    const double record_ns = per_sample_ns(start);
+
+    start = diagnostics_now_ns();
+    int64_t last_ns = start;
+    for (uint32_t i = 0; i < SAMPLES; i++)
+    {
+        const int64_t now_ns = diagnostics_now_ns();
+        diagnostics_record_latency(DIAG_STAGE_LOOKUP, now_ns - last_ns);
+        last_ns = now_ns;
+    }
+    const double clock_ns = per_sample_ns(start);
+
+    pthread_t threads[THREADS];
+    start = diagnostics_now_ns();
+    for (size_t i = 0; i < THREADS; i++)
+    {
+        if (0 != pthread_create(&threads[i], NULL, record, NULL))
+        {
+            fprintf(stderr, "Failed to start a thread\n");
+            return EXIT_FAILURE;
+        }
+    }
+    for (size_t i = 0; i < THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    const double threads_ns = per_sample_ns(start);
+
+    const double p50 = diagnostics_latency_percentile(DIAG_STAGE_WRITE, 50.0) * 1000000.0;
+    printf("record:                  %6.1f ns/sample\n", record_ns);
+    printf("clock read and record:   %6.1f ns/sample\n", clock_ns);
+    printf("%d threads, wall time:    %6.1f ns/sample per thread\n", THREADS, threads_ns);
+    printf("write p50 %.0f ns\n", p50);
+
+    if (!diagnostics_latency_dump("bench/latency.json"))
+    {
+        return EXIT_FAILURE;
+    }
+    diagnostics_latency_reset();
+    if (0.0 != diagnostics_latency_percentile(DIAG_STAGE_WRITE, 50.0))
+    {
+        fprintf(stderr, "Reset did not clear the histograms\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,210 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * History append and HistoryRead of SAMPLES samples per channel, for a
+ * temperature and for a port with and without delta encoding. The reads go
+ * through the same HistoryDatabase callbacks as the server's, all values are
+ * fetched with continuation points.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "opcua_history.h"
+
+#define SAMPLES 100000
+#define AT_TIMES 1000
+#define SAMPLE_INTERVAL UA_DATETIME_MSEC
+
+static channels_t channels;
+static UA_ServerConfig config;
+static UA_DateTime start;
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static double append_all(void)
+{
+    const double begin = now_ms();
+    for (size_t i = 0; i < SAMPLES; i++)
+    {
+        const UA_DateTime time = start + (UA_DateTime)i * SAMPLE_INTERVAL;
+        history_append_temp(&channels.slots[0], time, 20.0 + (i % 1000) * 0.01);
+        history_append_port(&channels.slots[1], time, i & 1);
+    }
+    return now_ms() - begin;
+}
+
+static UA_HistoryData *read_once(
+    const UA_NodeId *node_id,
+    UA_ByteString *continuation,
+    const UA_ReadRawModifiedDetails *details)
+{
+    UA_HistoryReadValueId node;
+    UA_HistoryReadValueId_init(&node);
+    node.nodeId = *node_id;
+    node.continuationPoint = *continuation;
+
+    UA_HistoryReadResponse response;
+    UA_HistoryReadResponse_init(&response);
+    response.results = UA_Array_new(1, &UA_TYPES[UA_TYPES_HISTORYREADRESULT]);
+    response.resultsSize = 1;
+    UA_HistoryData *data = UA_HistoryData_new();
+    UA_HistoryData *const history_data[] = {data};
+
+    config.historyDatabase.readRaw(
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        details,
+        UA_TIMESTAMPSTORETURN_SOURCE,
+        false,
+        1,
+        &node,
+        &response,
+        history_data);
+
+    UA_ByteString_clear(continuation);
+    *continuation = response.results[0].continuationPoint;
+    UA_ByteString_init(&response.results[0].continuationPoint);
+    UA_HistoryReadResponse_clear(&response);
+    return data;
+}
+
+static double read_all(const channel_t *channel, size_t *values)
+{
+    UA_ReadRawModifiedDetails details;
+    UA_ReadRawModifiedDetails_init(&details);
+    details.startTime = start;
+    details.endTime = start + (UA_DateTime)SAMPLES * SAMPLE_INTERVAL;
+    UA_ByteString continuation = UA_BYTESTRING_NULL;
+
+    *values = 0;
+    const double begin = now_ms();
+    do
+    {
+        UA_HistoryData *data = read_once(&channel->node_id, &continuation, &details);
+        *values += data->dataValuesSize;
+        UA_HistoryData_delete(data);
+    } while (0 < continuation.length);
+    return now_ms() - begin;
+}
+
+static double read_at_times(const channel_t *channel)
+{
+    UA_DateTime times[AT_TIMES];
+    for (size_t i = 0; i < AT_TIMES; i++)
+    {
+        // Between two samples, so that temperatures are interpolated
+        times[i] = start + (UA_DateTime)(i * (SAMPLES / AT_TIMES)) * SAMPLE_INTERVAL + SAMPLE_INTERVAL / 2;
+    }
+    UA_ReadAtTimeDetails details;
+    UA_ReadAtTimeDetails_init(&details);
+    details.reqTimes = times;
+    details.reqTimesSize = AT_TIMES;
+
+    UA_HistoryReadValueId node;
+    UA_HistoryReadValueId_init(&node);
+    node.nodeId = channel->node_id;
+    UA_HistoryReadResponse response;
+    UA_HistoryReadResponse_init(&response);
+    response.results = UA_Array_new(1, &UA_TYPES[UA_TYPES_HISTORYREADRESULT]);
+    response.resultsSize = 1;
+    UA_HistoryData *data = UA_HistoryData_new();
+    UA_HistoryData *const history_data[] = {data};
+
+    const double begin = now_ms();
+    config.historyDatabase.readAtTime(
+        NULL, NULL, NULL, NULL, NULL, &details, UA_TIMESTAMPSTORETURN_SOURCE, false, 1, &node, &response, history_data);
+    const double elapsed = now_ms() - begin;
+
+    UA_HistoryData_delete(data);
+    UA_HistoryReadResponse_clear(&response);
+    return elapsed;
+}
+
+static void run(const bool port_delta, const bool persist)
+{
+    const history_config_t history_config = {
+        .budget = 2 * SAMPLES * 16,
+        .port_delta = port_delta,
+        .persist = persist,
+    };
+    history_set_config(&history_config);
+    history_reset(&channels);
+
+    const double append_ms = append_all();
+    history_stats_t stats;
+    history_get_stats(&stats);
+    printf(
+        "port delta %-3s persist %-3s: %7.0f k appends/s, %zu bytes for %llu samples\n",
+        port_delta ? "yes" : "no",
+        persist ? "yes" : "no",
+        2 * SAMPLES / append_ms,
+        stats.bytes,
+        (unsigned long long)stats.samples);
+
+    for (size_t i = 0; i < channels.size; i++)
+    {
+        size_t values;
+        const double read_ms = read_all(&channels.slots[i], &values);
+        printf(
+            "  %-13s HistoryRead raw %zu values in %6.2f ms, at %u times in %6.2f ms\n",
+            channels.slots[i].label,
+            values,
+            read_ms,
+            AT_TIMES,
+            read_at_times(&channels.slots[i]));
+    }
+    history_cleanup();
+}
+
+int main(void)
+{
+    // The history file goes to localdata in the current directory
+    char dir[] = "/tmp/bench_history.XXXXXX";
+    if (NULL == mkdtemp(dir) || 0 != chdir(dir) || 0 != mkdir("localdata", 0700))
+    {
+        fprintf(stderr, "Failed to create a directory for the history file\n");
+        return EXIT_FAILURE;
+    }
+
+    channels_init(&channels, 2);
+    channels_add(&channels, CHANNEL_TEMP, 0);
+    channels_add(&channels, CHANNEL_PORT, 0);
+    history_attach(&config);
+    start = UA_DateTime_now() - (UA_DateTime)SAMPLES * SAMPLE_INTERVAL;
+
+    run(false, false);
+    run(true, false);
+    run(true, true);
+
+    channels_free(&channels);
+    (void)unlink(HISTORY_FILE);
+    (void)rmdir("localdata");
+    (void)rmdir(dir);
+    return EXIT_SUCCESS;
+}
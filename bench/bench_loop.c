@@ -0,0 +1,363 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Cost of running the server on its own thread (singleLoop=no) against in the
+ * GLib main loop (singleLoop=yes), on a plain Linux host. For each, opcuaserver
+ * runs against the mock device services on a private D-Bus bus. Reports the
+ * server's CPU use and wakeups (voluntary context switches of all its threads)
+ * per second while idle, and while subscribers follow all temperatures at a
+ * low signal rate, with the notifications they receive.
+ */
+
+#include <open62541/client_highlevel.h>
+#include <open62541/client_subscriptions.h>
+
+#include <dirent.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mock_device.h"
+
+#define CONNECT_TIMEOUT_S 10
+#define ITERATE_TIMEOUT_MS 10
+#define EMIT_PERIOD_US 1000
+#define NODEID_TEMP_BASE 1000
+
+static gint temps = 32;
+static gint rate = 200;
+static gint clients = 4;
+static gint duration = 5;
+static gint interval = 100;
+static gint ua_port = 48420;
+static gchar *server_path = "bench/opcuaserver";
+static gchar *server_log = "bench/opcuaserver.log";
+
+static const GOptionEntry entries[] = {
+    {"temps", 't', 0, G_OPTION_ARG_INT, &temps, "Number of temperature sensors (32)", "N"},
+    {"rate", 'r', 0, G_OPTION_ARG_INT, &rate, "Temperature signals per second, over all sensors (200)", "N"},
+    {"clients", 'c', 0, G_OPTION_ARG_INT, &clients, "Subscribers following all temperatures (4)", "N"},
+    {"duration", 'd', 0, G_OPTION_ARG_INT, &duration, "Seconds per measurement (5)", "S"},
+    {"interval", 'i', 0, G_OPTION_ARG_INT, &interval, "Publishing interval in ms (100)", "MS"},
+    {"port", 'p', 0, G_OPTION_ARG_INT, &ua_port, "OPC UA server port (48420)", "PORT"},
+    {"server", 0, 0, G_OPTION_ARG_FILENAME, &server_path, "opcuaserver to run", "PATH"},
+    {"server-log", 0, 0, G_OPTION_ARG_FILENAME, &server_log, "Where to write the server's output", "PATH"},
+    {NULL, 0, 0, 0, NULL, NULL, NULL}};
+
+typedef struct
+{
+    GThread *thread;
+    UA_Client *client;
+    bench_counter_t counter;
+    bool failed;
+} subscriber_t;
+
+/* CPU time and voluntary context switches of a process */
+typedef struct
+{
+    double cpu_s;
+    guint64 wakeups;
+} usage_t;
+
+static atomic_bool emitting;
+static atomic_bool subscribing;
+static atomic_bool counting;
+static atomic_int ready;
+
+/* A thread blocks for every wakeup, the sum over all threads counts them */
+static guint64 get_wakeups(GPid pid)
+{
+    gchar *path = g_strdup_printf("/proc/%d/task", pid);
+    DIR *dir = opendir(path);
+    g_free(path);
+    if (NULL == dir)
+    {
+        return 0;
+    }
+    guint64 total = 0;
+    const struct dirent *entry;
+    while (NULL != (entry = readdir(dir)))
+    {
+        if ('.' == entry->d_name[0])
+        {
+            continue;
+        }
+        gchar *status_path = g_strdup_printf("/proc/%d/task/%s/status", pid, entry->d_name);
+        gchar *status = NULL;
+        if (g_file_get_contents(status_path, &status, NULL, NULL))
+        {
+            const gchar *line = strstr(status, "voluntary_ctxt_switches:");
+            unsigned long long switches = 0;
+            if (NULL != line && 1 == sscanf(line, "voluntary_ctxt_switches: %llu", &switches))
+            {
+                total += switches;
+            }
+            g_free(status);
+        }
+        g_free(status_path);
+    }
+    closedir(dir);
+    return total;
+}
+
+static void get_usage(GPid pid, usage_t *usage)
+{
+    usage->cpu_s = bench_get_cpu_s(pid);
+    usage->wakeups = get_wakeups(pid);
+}
+
+static gpointer emit_temps(gpointer data)
+{
+    (void)data;
+    const gint64 start = g_get_monotonic_time();
+    guint64 count = 0;
+    while (atomic_load(&emitting))
+    {
+        const guint64 due = (guint64)((g_get_monotonic_time() - start) * (gint64)rate / G_USEC_PER_SEC);
+        for (; count < due; count++)
+        {
+            mock_device_emit_temp(count % temps, 20.0 + (double)(count % 1000) / 100.0);
+        }
+        g_usleep(EMIT_PERIOD_US);
+    }
+    return NULL;
+}
+
+static bool subscribe_all(subscriber_t *subscriber)
+{
+    UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+    request.requestedPublishingInterval = interval;
+    request.maxNotificationsPerPublish = 0;
+    UA_CreateSubscriptionResponse subscription =
+        UA_Client_Subscriptions_create(subscriber->client, request, NULL, NULL, NULL);
+    if (UA_STATUSCODE_GOOD != subscription.responseHeader.serviceResult)
+    {
+        fprintf(
+            stderr,
+            "Failed to create subscription (%s)\n",
+            UA_StatusCode_name(subscription.responseHeader.serviceResult));
+        return false;
+    }
+
+    bool ok = true;
+    for (gint i = 0; i < temps && ok; i++)
+    {
+        UA_MonitoredItemCreateRequest item =
+            UA_MonitoredItemCreateRequest_default(UA_NODEID_NUMERIC(1, NODEID_TEMP_BASE + i));
+        UA_MonitoredItemCreateResult result = UA_Client_MonitoredItems_createDataChange(
+            subscriber->client,
+            subscription.subscriptionId,
+            UA_TIMESTAMPSTORETURN_BOTH,
+            item,
+            &subscriber->counter,
+            bench_count_data_change,
+            NULL);
+        ok = UA_STATUSCODE_GOOD == result.statusCode;
+        if (!ok)
+        {
+            fprintf(stderr, "Failed to monitor temperature %d (%s)\n", i, UA_StatusCode_name(result.statusCode));
+        }
+    }
+    return ok;
+}
+
+static gpointer run_subscriber(gpointer data)
+{
+    subscriber_t *subscriber = data;
+    subscriber->client = bench_connect_client(ua_port, CONNECT_TIMEOUT_S);
+    subscriber->failed = NULL == subscriber->client || !subscribe_all(subscriber);
+    atomic_fetch_add(&ready, 1);
+    while (!subscriber->failed && atomic_load(&subscribing))
+    {
+        UA_Client_run_iterate(subscriber->client, ITERATE_TIMEOUT_MS);
+    }
+    if (NULL != subscriber->client)
+    {
+        UA_Client_disconnect(subscriber->client);
+        UA_Client_delete(subscriber->client);
+    }
+    return NULL;
+}
+
+/* Server CPU in %, wakeups and notifications per second, without or with subscribers and signals */
+static bool measure(GPid pid, const bool load, double *cpu, double *wakeups, double *received)
+{
+    const gint count = load ? clients : 0;
+    subscriber_t *subscribers = g_new0(subscriber_t, MAX(count, 1));
+    atomic_store(&subscribing, true);
+    atomic_store(&counting, false);
+    atomic_store(&ready, 0);
+    for (gint i = 0; i < count; i++)
+    {
+        subscribers[i].counter.counting = &counting;
+        subscribers[i].thread = g_thread_new("subscriber", run_subscriber, &subscribers[i]);
+    }
+    while (atomic_load(&ready) < count)
+    {
+        g_usleep(1000);
+    }
+
+    // Let the initial values arrive and the server settle before measuring
+    GThread *emitter = NULL;
+    atomic_store(&emitting, load);
+    if (load)
+    {
+        emitter = g_thread_new("emitter", emit_temps, NULL);
+    }
+    g_usleep(G_USEC_PER_SEC);
+    usage_t before, after;
+    get_usage(pid, &before);
+    const gint64 start = g_get_monotonic_time();
+    atomic_store(&counting, true);
+    g_usleep((gulong)duration * G_USEC_PER_SEC);
+    atomic_store(&counting, false);
+    const double elapsed = (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+    get_usage(pid, &after);
+    atomic_store(&emitting, false);
+    if (NULL != emitter)
+    {
+        g_thread_join(emitter);
+    }
+    atomic_store(&subscribing, false);
+
+    bool ok = true;
+    guint64 total = 0;
+    for (gint i = 0; i < count; i++)
+    {
+        g_thread_join(subscribers[i].thread);
+        total += atomic_load(&subscribers[i].counter.received);
+        ok = ok && !subscribers[i].failed;
+    }
+    g_free(subscribers);
+    *cpu = 100.0 * (after.cpu_s - before.cpu_s) / elapsed;
+    *wakeups = (after.wakeups - before.wakeups) / elapsed;
+    *received = total / elapsed;
+    return ok;
+}
+
+static GSubprocess *spawn_server(const gchar *address, const bool single_loop)
+{
+    GError *error = NULL;
+    gchar *port = g_strdup_printf("%d", ua_port);
+    gchar *min_interval = g_strdup_printf("%d", interval);
+    GSubprocessLauncher *launcher = g_subprocess_launcher_new(G_SUBPROCESS_FLAGS_STDERR_MERGE);
+    g_subprocess_launcher_setenv(launcher, "DBUS_SYSTEM_BUS_ADDRESS", address, TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_port", port, TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_singleLoop", single_loop ? "yes" : "no", TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_serverMinPublishingInterval", min_interval, TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_enumerateInterval", "0", FALSE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_logLevel", "warning", FALSE);
+    g_subprocess_launcher_set_stdout_file_path(launcher, server_log);
+
+    GSubprocess *server = g_subprocess_launcher_spawn(launcher, &error, server_path, NULL);
+    if (NULL == server)
+    {
+        fprintf(stderr, "Failed to start %s (%s)\n", server_path, error->message);
+        g_error_free(error);
+    }
+    g_object_unref(launcher);
+    g_free(port);
+    g_free(min_interval);
+    return server;
+}
+
+static bool run_mode(const gchar *address, const bool single_loop)
+{
+    GSubprocess *server = spawn_server(address, single_loop);
+    if (NULL == server)
+    {
+        return false;
+    }
+    const GPid pid = atoi(g_subprocess_get_identifier(server));
+
+    // Wait until the server is up
+    UA_Client *client = bench_connect_client(ua_port, CONNECT_TIMEOUT_S);
+    if (NULL == client)
+    {
+        bench_stop_server(server);
+        return false;
+    }
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+
+    double idle_cpu, idle_wakeups, load_cpu, load_wakeups, received;
+    double unused;
+    const bool ok = measure(pid, false, &idle_cpu, &idle_wakeups, &unused) &&
+                    measure(pid, true, &load_cpu, &load_wakeups, &received);
+    bench_stop_server(server);
+    if (!ok)
+    {
+        fprintf(stderr, "Failed to measure with singleLoop=%s\n", single_loop ? "yes" : "no");
+        return false;
+    }
+    printf(
+        "%-8s %10.2f %10.0f %10.2f %10.0f %12.0f\n",
+        single_loop ? "loop" : "thread",
+        idle_cpu,
+        idle_wakeups,
+        load_cpu,
+        load_wakeups,
+        received);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    GError *error = NULL;
+    GOptionContext *options = g_option_context_new("- cost of a server thread against the main loop");
+    g_option_context_add_main_entries(options, entries, NULL);
+    if (!g_option_context_parse(options, &argc, &argv, &error))
+    {
+        fprintf(stderr, "%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free(options);
+    if (0 >= temps || 0 >= rate || 0 >= clients || 0 >= duration || 0 >= interval)
+    {
+        fprintf(stderr, "Invalid options\n");
+        return EXIT_FAILURE;
+    }
+
+    // A private bus in place of the system bus
+    GTestDBus *bus = g_test_dbus_new(G_TEST_DBUS_NONE);
+    g_test_dbus_up(bus);
+    bool ok = mock_device_start(g_test_dbus_get_bus_address(bus), temps, 0, 0);
+    if (ok)
+    {
+        printf(
+            "%d temperatures, %d subscribers at %d signals/s, %d ms publishing, %d s per measurement\n",
+            temps,
+            clients,
+            rate,
+            interval,
+            duration);
+        printf(
+            "%-8s %10s %10s %10s %10s %12s\n",
+            "server",
+            "idle cpu %",
+            "wakeups/s",
+            "cpu %",
+            "wakeups/s",
+            "notif/s");
+        ok = run_mode(g_test_dbus_get_bus_address(bus), false) && run_mode(g_test_dbus_get_bus_address(bus), true);
+    }
+    mock_device_stop();
+    g_test_dbus_down(bus);
+    g_object_unref(bus);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,299 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Cost of the two ways of serving channel values, on a plain Linux host:
+ * nodes written with every update (pullValues=no) against data source nodes
+ * that read a snapshot (pullValues=yes). For each, opcuaserver runs against
+ * the mock device services on a private D-Bus bus while temperature signals
+ * are emitted at a fixed rate. Reports the server CPU time per update without
+ * clients, and the read throughput of clients reading all temperatures while
+ * the updates go on.
+ */
+
+#include <open62541/client_highlevel.h>
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mock_device.h"
+
+#define CONNECT_TIMEOUT_S 10
+#define NODEID_TEMP_BASE 1000
+#define EMIT_PERIOD_US 1000
+
+static gint temps = 32;
+static gint rate = 20000;
+static gint clients = 4;
+static gint duration = 3;
+static gint ua_port = 48420;
+static gchar *server_path = "bench/opcuaserver";
+static gchar *server_log = "bench/opcuaserver.log";
+
+static const GOptionEntry entries[] = {
+    {"temps", 't', 0, G_OPTION_ARG_INT, &temps, "Number of temperature sensors, read per request (32)", "N"},
+    {"rate", 'r', 0, G_OPTION_ARG_INT, &rate, "Temperature signals per second, over all sensors (20000)", "N"},
+    {"clients", 'c', 0, G_OPTION_ARG_INT, &clients, "Clients reading at once (4)", "N"},
+    {"duration", 'd', 0, G_OPTION_ARG_INT, &duration, "Seconds per measurement (3)", "S"},
+    {"port", 'p', 0, G_OPTION_ARG_INT, &ua_port, "OPC UA server port (48420)", "PORT"},
+    {"server", 0, 0, G_OPTION_ARG_FILENAME, &server_path, "opcuaserver to run", "PATH"},
+    {"server-log", 0, 0, G_OPTION_ARG_FILENAME, &server_log, "Where to write the server's output", "PATH"},
+    {NULL, 0, 0, 0, NULL, NULL, NULL}};
+
+typedef struct
+{
+    GThread *thread;
+    UA_Client *client;
+    guint64 reads;
+    bool failed;
+} reader_t;
+
+static atomic_bool emitting;
+static atomic_uint_fast64_t emitted;
+static atomic_bool reading;
+static atomic_int ready;
+
+/* Emits rate signals per second in steps of EMIT_PERIOD_US, with a new value every time */
+static gpointer emit_temps(gpointer data)
+{
+    (void)data;
+    const gint64 start = g_get_monotonic_time();
+    guint64 count = 0;
+    while (atomic_load(&emitting))
+    {
+        const guint64 due = (guint64)((g_get_monotonic_time() - start) * (gint64)rate / G_USEC_PER_SEC);
+        for (; count < due; count++)
+        {
+            mock_device_emit_temp(count % temps, 20.0 + (double)(count % 1000) / 100.0);
+        }
+        atomic_store(&emitted, count);
+        g_usleep(EMIT_PERIOD_US);
+    }
+    return NULL;
+}
+
+static gpointer read_values(gpointer data)
+{
+    reader_t *reader = data;
+    UA_ReadValueId *ids = g_new0(UA_ReadValueId, temps);
+    for (gint i = 0; i < temps; i++)
+    {
+        UA_ReadValueId_init(&ids[i]);
+        ids[i].nodeId = UA_NODEID_NUMERIC(1, NODEID_TEMP_BASE + i);
+        ids[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.nodesToRead = ids;
+    request.nodesToReadSize = temps;
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+
+    atomic_fetch_add(&ready, 1);
+    while (!atomic_load(&reading))
+    {
+        g_usleep(1000);
+    }
+    while (atomic_load(&reading))
+    {
+        UA_ReadResponse response = UA_Client_Service_read(reader->client, request);
+        const bool ok = UA_STATUSCODE_GOOD == response.responseHeader.serviceResult &&
+                        (size_t)temps == response.resultsSize && response.results[0].hasValue;
+        UA_ReadResponse_clear(&response);
+        if (!ok)
+        {
+            reader->failed = true;
+            break;
+        }
+        reader->reads++;
+    }
+    g_free(ids);
+    return NULL;
+}
+
+/* Server CPU in %, signals emitted and reads per second for duration seconds, with or without updates and readers */
+static bool measure(GPid pid, const bool updates, const gint nbr_readers, double *cpu, double *signals, double *reads)
+{
+    reader_t *readers = g_new0(reader_t, MAX(nbr_readers, 1));
+    bool ok = true;
+    for (gint i = 0; i < nbr_readers && ok; i++)
+    {
+        readers[i].client = bench_connect_client(ua_port, CONNECT_TIMEOUT_S);
+        ok = NULL != readers[i].client;
+    }
+    atomic_store(&reading, false);
+    atomic_store(&ready, 0);
+    for (gint i = 0; i < nbr_readers && ok; i++)
+    {
+        readers[i].thread = g_thread_new("reader", read_values, &readers[i]);
+    }
+    while (ok && atomic_load(&ready) < nbr_readers)
+    {
+        g_usleep(1000);
+    }
+
+    GThread *emitter = NULL;
+    atomic_store(&emitted, 0);
+    atomic_store(&emitting, ok && updates);
+    if (ok && updates)
+    {
+        emitter = g_thread_new("emitter", emit_temps, NULL);
+    }
+    const double cpu_before = bench_get_cpu_s(pid);
+    const gint64 start = g_get_monotonic_time();
+    atomic_store(&reading, ok);
+    g_usleep((gulong)duration * G_USEC_PER_SEC);
+    atomic_store(&reading, false);
+    atomic_store(&emitting, false);
+    const double elapsed = (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+    const double cpu_after = bench_get_cpu_s(pid);
+    if (NULL != emitter)
+    {
+        g_thread_join(emitter);
+    }
+
+    guint64 count = 0;
+    for (gint i = 0; i < nbr_readers; i++)
+    {
+        if (NULL != readers[i].thread)
+        {
+            g_thread_join(readers[i].thread);
+        }
+        if (NULL != readers[i].client)
+        {
+            UA_Client_disconnect(readers[i].client);
+            UA_Client_delete(readers[i].client);
+        }
+        count += readers[i].reads;
+        ok = ok && !readers[i].failed;
+    }
+    g_free(readers);
+    *cpu = 100.0 * (cpu_after - cpu_before) / elapsed;
+    *signals = (double)atomic_load(&emitted);
+    *reads = count / elapsed;
+    return ok;
+}
+
+static GSubprocess *spawn_server(const gchar *address, const bool pull)
+{
+    GError *error = NULL;
+    gchar *port = g_strdup_printf("%d", ua_port);
+    GSubprocessLauncher *launcher = g_subprocess_launcher_new(G_SUBPROCESS_FLAGS_STDERR_MERGE);
+    g_subprocess_launcher_setenv(launcher, "DBUS_SYSTEM_BUS_ADDRESS", address, TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_port", port, TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_pullValues", pull ? "yes" : "no", TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_logLevel", "warning", FALSE);
+    g_subprocess_launcher_set_stdout_file_path(launcher, server_log);
+
+    GSubprocess *server = g_subprocess_launcher_spawn(launcher, &error, server_path, NULL);
+    if (NULL == server)
+    {
+        fprintf(stderr, "Failed to start %s (%s)\n", server_path, error->message);
+        g_error_free(error);
+    }
+    g_object_unref(launcher);
+    g_free(port);
+    return server;
+}
+
+static bool run_mode(const gchar *address, const bool pull)
+{
+    GSubprocess *server = spawn_server(address, pull);
+    if (NULL == server)
+    {
+        return false;
+    }
+    const GPid pid = atoi(g_subprocess_get_identifier(server));
+
+    // Wait until the server is up
+    UA_Client *client = bench_connect_client(ua_port, CONNECT_TIMEOUT_S);
+    if (NULL == client)
+    {
+        bench_stop_server(server);
+        return false;
+    }
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+
+    // Idle, updates only, reads only, then reads while updating
+    double idle_cpu, update_cpu, read_cpu;
+    double signals, idle_reads, reads;
+    double unused;
+    const bool ok = measure(pid, false, 0, &idle_cpu, &unused, &unused) &&
+                    measure(pid, true, 0, &update_cpu, &signals, &unused) &&
+                    measure(pid, false, clients, &unused, &unused, &idle_reads) &&
+                    measure(pid, true, clients, &read_cpu, &unused, &reads);
+    bench_stop_server(server);
+    if (!ok)
+    {
+        fprintf(stderr, "Failed to measure with pullValues=%s\n", pull ? "yes" : "no");
+        return false;
+    }
+
+    // CPU time per update above the idle server
+    const double update_us = 0 < signals ? (update_cpu - idle_cpu) / 100.0 * duration / signals * 1e6 : 0.0;
+    printf(
+        "%-6s %10.0f %10.1f %10.2f %12.0f %12.0f %10.1f\n",
+        pull ? "pull" : "write",
+        signals / duration,
+        update_cpu,
+        update_us,
+        idle_reads,
+        reads,
+        read_cpu);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    GError *error = NULL;
+    GOptionContext *options = g_option_context_new("- cost of written against pulled node values");
+    g_option_context_add_main_entries(options, entries, NULL);
+    if (!g_option_context_parse(options, &argc, &argv, &error))
+    {
+        fprintf(stderr, "%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free(options);
+    if (0 >= temps || 0 >= rate || 0 >= clients || 0 >= duration)
+    {
+        fprintf(stderr, "Invalid options\n");
+        return EXIT_FAILURE;
+    }
+
+    // A private bus in place of the system bus
+    GTestDBus *bus = g_test_dbus_new(G_TEST_DBUS_NONE);
+    g_test_dbus_up(bus);
+    bool ok = mock_device_start(g_test_dbus_get_bus_address(bus), temps, 0, 0);
+    if (ok)
+    {
+        printf("%d temperatures, %d clients reading all of them, %d s per measurement\n", temps, clients, duration);
+        printf(
+            "%-6s %10s %10s %10s %12s %12s %10s\n",
+            "nodes",
+            "signals/s",
+            "cpu %",
+            "us/update",
+            "reads/s",
+            "reads/s upd",
+            "cpu % upd");
+        ok = run_mode(g_test_dbus_get_bus_address(bus), false) && run_mode(g_test_dbus_get_bus_address(bus), true);
+    }
+    mock_device_stop();
+    g_test_dbus_down(bus);
+    g_object_unref(bus);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,248 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Read throughput benchmark on a plain Linux host. Runs opcuaserver (built
+ * with the axparameter stub) against the mock device services on a private
+ * D-Bus bus and lets a growing number of clients, each on its own thread and
+ * connection, read all temperatures as fast as the server answers. Reports the
+ * reads per second and the server's CPU use for every number of clients.
+ */
+
+#include <open62541/client_highlevel.h>
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mock_device.h"
+
+#define CONNECT_TIMEOUT_S 10
+#define NODEID_TEMP_BASE 1000
+#define MAX_STEPS 16
+
+static gint temps = 32;
+static gint duration = 3;
+static gint ua_port = 48410;
+static gchar *clients_list = "1,2,4,8,16";
+static gchar *server_path = "bench/opcuaserver";
+static gchar *server_log = "bench/opcuaserver.log";
+
+static const GOptionEntry entries[] = {
+    {"temps", 't', 0, G_OPTION_ARG_INT, &temps, "Number of temperature sensors, read per request (32)", "N"},
+    {"duration", 'd', 0, G_OPTION_ARG_INT, &duration, "Seconds to read per measurement (3)", "S"},
+    {"port", 'p', 0, G_OPTION_ARG_INT, &ua_port, "OPC UA server port (48410)", "PORT"},
+    {"clients", 'c', 0, G_OPTION_ARG_STRING, &clients_list, "Clients to measure (1,2,4,8,16)", "LIST"},
+    {"server", 0, 0, G_OPTION_ARG_FILENAME, &server_path, "opcuaserver to run", "PATH"},
+    {"server-log", 0, 0, G_OPTION_ARG_FILENAME, &server_log, "Where to write the server's output", "PATH"},
+    {NULL, 0, 0, 0, NULL, NULL, NULL}};
+
+typedef struct
+{
+    GThread *thread;
+    UA_Client *client;
+    guint64 reads;
+    bool failed;
+} reader_t;
+
+static atomic_bool reading;
+static atomic_int ready;
+
+static guint parse_list(const gchar *text, gint *values)
+{
+    gchar **items = g_strsplit(text, ",", -1);
+    guint count = 0;
+    for (gchar **item = items; NULL != *item && MAX_STEPS > count; item++)
+    {
+        const gint value = atoi(*item);
+        if (0 < value)
+        {
+            values[count++] = value;
+        }
+    }
+    g_strfreev(items);
+    return count;
+}
+
+static gpointer read_values(gpointer data)
+{
+    reader_t *reader = data;
+    UA_ReadValueId *ids = g_new0(UA_ReadValueId, temps);
+    for (gint i = 0; i < temps; i++)
+    {
+        UA_ReadValueId_init(&ids[i]);
+        ids[i].nodeId = UA_NODEID_NUMERIC(1, NODEID_TEMP_BASE + i);
+        ids[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.nodesToRead = ids;
+    request.nodesToReadSize = temps;
+
+    atomic_fetch_add(&ready, 1);
+    while (!atomic_load(&reading))
+    {
+        g_usleep(1000);
+    }
+    while (atomic_load(&reading))
+    {
+        UA_ReadResponse response = UA_Client_Service_read(reader->client, request);
+        const bool ok = UA_STATUSCODE_GOOD == response.responseHeader.serviceResult &&
+                        (size_t)temps == response.resultsSize && response.results[0].hasValue;
+        UA_ReadResponse_clear(&response);
+        if (!ok)
+        {
+            reader->failed = true;
+            break;
+        }
+        reader->reads++;
+    }
+    g_free(ids);
+    return NULL;
+}
+
+/* Reads per second of all clients together */
+static bool measure(GPid pid, const gint clients, double *rate, double *cpu)
+{
+    reader_t *readers = g_new0(reader_t, clients);
+    bool ok = true;
+    for (gint i = 0; i < clients && ok; i++)
+    {
+        readers[i].client = bench_connect_client(ua_port, CONNECT_TIMEOUT_S);
+        ok = NULL != readers[i].client;
+    }
+
+    atomic_store(&reading, false);
+    atomic_store(&ready, 0);
+    for (gint i = 0; i < clients && ok; i++)
+    {
+        readers[i].thread = g_thread_new("reader", read_values, &readers[i]);
+    }
+    while (ok && atomic_load(&ready) < clients)
+    {
+        g_usleep(1000);
+    }
+
+    const double cpu_before = bench_get_cpu_s(pid);
+    const gint64 start = g_get_monotonic_time();
+    atomic_store(&reading, ok);
+    g_usleep((gulong)duration * G_USEC_PER_SEC);
+    atomic_store(&reading, false);
+    const double elapsed = (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+    const double cpu_after = bench_get_cpu_s(pid);
+
+    guint64 reads = 0;
+    for (gint i = 0; i < clients; i++)
+    {
+        if (NULL != readers[i].thread)
+        {
+            g_thread_join(readers[i].thread);
+        }
+        if (NULL != readers[i].client)
+        {
+            UA_Client_disconnect(readers[i].client);
+            UA_Client_delete(readers[i].client);
+        }
+        reads += readers[i].reads;
+        ok = ok && !readers[i].failed;
+    }
+    g_free(readers);
+    *rate = reads / elapsed;
+    *cpu = 100.0 * (cpu_after - cpu_before) / elapsed;
+    return ok;
+}
+
+static GSubprocess *spawn_server(const gchar *address)
+{
+    GError *error = NULL;
+    gchar *port = g_strdup_printf("%d", ua_port);
+    GSubprocessLauncher *launcher = g_subprocess_launcher_new(G_SUBPROCESS_FLAGS_STDERR_MERGE);
+    g_subprocess_launcher_setenv(launcher, "DBUS_SYSTEM_BUS_ADDRESS", address, TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_port", port, TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_logLevel", "warning", FALSE);
+    g_subprocess_launcher_set_stdout_file_path(launcher, server_log);
+
+    GSubprocess *server = g_subprocess_launcher_spawn(launcher, &error, server_path, NULL);
+    if (NULL == server)
+    {
+        fprintf(stderr, "Failed to start %s (%s)\n", server_path, error->message);
+        g_error_free(error);
+    }
+    g_object_unref(launcher);
+    g_free(port);
+    return server;
+}
+
+static bool run(const gchar *address, const gint *clients, guint nbr_clients)
+{
+    if (!mock_device_start(address, temps, 0, 0))
+    {
+        return false;
+    }
+    GSubprocess *server = spawn_server(address);
+    if (NULL == server)
+    {
+        return false;
+    }
+    const GPid pid = atoi(g_subprocess_get_identifier(server));
+    printf("%d temperatures per read, %d s per measurement\n", temps, duration);
+    printf("%8s %12s %12s %10s\n", "clients", "reads/s", "values/s", "cpu %");
+    for (guint c = 0; c < nbr_clients; c++)
+    {
+        double rate;
+        double cpu;
+        if (!measure(pid, clients[c], &rate, &cpu))
+        {
+            fprintf(stderr, "Failed to read with %d clients\n", clients[c]);
+            bench_stop_server(server);
+            return false;
+        }
+        printf("%8d %12.0f %12.0f %10.1f\n", clients[c], rate, rate * temps, cpu);
+    }
+    bench_stop_server(server);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    GError *error = NULL;
+    GOptionContext *options = g_option_context_new("- read throughput of opcuaserver against the number of clients");
+    g_option_context_add_main_entries(options, entries, NULL);
+    if (!g_option_context_parse(options, &argc, &argv, &error))
+    {
+        fprintf(stderr, "%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free(options);
+
+    gint clients[MAX_STEPS];
+    const guint nbr_clients = parse_list(clients_list, clients);
+    if (0 >= temps || 0 >= duration || 0 == nbr_clients)
+    {
+        fprintf(stderr, "Invalid options\n");
+        return EXIT_FAILURE;
+    }
+
+    // A private bus in place of the system bus
+    GTestDBus *bus = g_test_dbus_new(G_TEST_DBUS_NONE);
+    g_test_dbus_up(bus);
+    const bool ok = run(g_test_dbus_get_bus_address(bus), clients, nbr_clients);
+    mock_device_stop();
+    g_test_dbus_down(bus);
+    g_object_unref(bus);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,122 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Compares the old subscription id lookup (linear scan over a label array and
+ * a string node id per write) with the channel registry (direct index and a
+ * precomputed numeric node id). The node id is hashed the way the nodestore
+ * does on every write.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "opcua_channels.h"
+
+#define DEFAULT_CHANNELS 512
+#define LOOKUPS 10000000
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* The lookup as it was done before the channel registry */
+static char *old_get_label_from_subscription(
+    const size_t size,
+    uint32_t *subid,
+    char **labels,
+    const uint32_t subscription_id)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        if (subid[i] == subscription_id)
+        {
+            return labels[i];
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    const size_t count = 1 < argc ? strtoul(argv[1], NULL, 10) : DEFAULT_CHANNELS;
+    assert(0 < count && CHANNELS_MAX_PER_TYPE >= count);
+
+    // Old layout: scattered label strings and a parallel subscription id array
+    uint32_t *subid = calloc(count, sizeof(uint32_t));
+    char **labels = calloc(count, sizeof(char *));
+    for (size_t i = 0; i < count; i++)
+    {
+        labels[i] = calloc(CHANNEL_LABEL_LEN, sizeof(char));
+        snprintf(labels[i], CHANNEL_LABEL_LEN, TEMP_LABEL_FMT, (unsigned)i);
+        subid[i] = i + 1;
+    }
+
+    // New layout: the channel registry
+    channels_t channels;
+    channels_init(&channels, count);
+    for (size_t i = 0; i < count; i++)
+    {
+        channel_t *channel = channels_add(&channels, CHANNEL_TEMP, i);
+        assert(NULL != channel);
+        channels_set_subscription(&channels, channel, i + 1);
+    }
+
+    // Same random sequence of subscription ids for both
+    uint32_t *ids = malloc(LOOKUPS * sizeof(uint32_t));
+    srand(1);
+    for (size_t i = 0; i < LOOKUPS; i++)
+    {
+        ids[i] = 1 + (uint32_t)(rand() % count);
+    }
+
+    UA_UInt32 sink = 0;
+    uint64_t start = now_ns();
+    for (size_t i = 0; i < LOOKUPS; i++)
+    {
+        char *label = old_get_label_from_subscription(count, subid, labels, ids[i]);
+        UA_NodeId node_id = UA_NODEID_STRING(1, label);
+        sink += UA_NodeId_hash(&node_id);
+    }
+    const uint64_t old_ns = now_ns() - start;
+
+    start = now_ns();
+    for (size_t i = 0; i < LOOKUPS; i++)
+    {
+        const channel_t *channel = channels_get_from_subscription(&channels, CHANNEL_TEMP, ids[i]);
+        sink += UA_NodeId_hash(&channel->node_id);
+    }
+    const uint64_t new_ns = now_ns() - start;
+
+    printf("channels: %zu, lookups: %d (checksum %u)\n", count, LOOKUPS, sink);
+    printf("linear scan + string node id: %8.1f ns/lookup\n", (double)old_ns / LOOKUPS);
+    printf("registry + numeric node id:   %8.1f ns/lookup\n", (double)new_ns / LOOKUPS);
+    printf("speedup:                      %8.1fx\n", (double)old_ns / (double)new_ns);
+
+    free(ids);
+    channels_free(&channels);
+    for (size_t i = 0; i < count; i++)
+    {
+        free(labels[i]);
+    }
+    free(labels);
+    free(subid);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,582 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Cost of the secure endpoints on a plain Linux host. Makes a self-signed
+ * server and client certificate with the openssl command, installs them in a
+ * scratch application directory and runs opcuaserver there against the mock
+ * device services on a private D-Bus bus. For every security policy, with
+ * SignAndEncrypt, it reports:
+ *
+ * - the client's wall time and the server's CPU time per OpenSecureChannel,
+ *   and per complete connect as open62541's client does it (GetEndpoints,
+ *   OpenSecureChannel, CreateSession and ActivateSession)
+ * - the notifications per second that subscribers following all temperatures
+ *   receive while the mock emits temperature signals, and the server's CPU use
+ *
+ * The server's CPU time per connect and CPU use per subscriber, scaled by how
+ * much slower the camera's cores are, bound how many secure clients it serves.
+ */
+
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/client_subscriptions.h>
+#include <open62541/plugin/pki_default.h>
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+
+#include "mock_device.h"
+
+#define CONNECT_TIMEOUT_S 10
+#define ITERATE_TIMEOUT_MS 10
+#define EMIT_PERIOD_US 1000
+#define MAX_STEPS 16
+#define NODEID_TEMP_BASE 1000
+
+// The subject alternative name URIs must match the application URIs of open62541's server and client
+#define SERVER_URI "urn:open62541.server.application"
+#define CLIENT_URI "urn:open62541.client.application"
+
+static gint temps = 32;
+static gint rate = 1000;
+static gint handshakes = 20;
+static gint duration = 5;
+static gint interval = 100;
+static gint key_bits = 2048;
+static gint ua_port = 48420;
+static gchar *subscribers_list = "1,4,16";
+static gchar *server_path = "bench/opcuaserver";
+static gchar *server_log = "bench/opcuaserver.log";
+
+static const GOptionEntry entries[] = {
+    {"temps", 't', 0, G_OPTION_ARG_INT, &temps, "Number of temperature sensors (32)", "N"},
+    {"rate", 'r', 0, G_OPTION_ARG_INT, &rate, "Temperature signals per second, over all sensors (1000)", "N"},
+    {"handshakes", 'n', 0, G_OPTION_ARG_INT, &handshakes, "Connects per policy for the handshake cost (20)", "N"},
+    {"subscribers", 's', 0, G_OPTION_ARG_STRING, &subscribers_list, "Subscribers to measure (1,4,16)", "LIST"},
+    {"duration", 'd', 0, G_OPTION_ARG_INT, &duration, "Seconds per publish measurement (5)", "S"},
+    {"interval", 'i', 0, G_OPTION_ARG_INT, &interval, "Publishing interval in ms (100)", "MS"},
+    {"key-bits", 'k', 0, G_OPTION_ARG_INT, &key_bits, "RSA key size of the certificates (2048)", "BITS"},
+    {"port", 'p', 0, G_OPTION_ARG_INT, &ua_port, "OPC UA server port (48420)", "PORT"},
+    {"server", 0, 0, G_OPTION_ARG_FILENAME, &server_path, "opcuaserver to run", "PATH"},
+    {"server-log", 0, 0, G_OPTION_ARG_FILENAME, &server_log, "Where to write the server's output", "PATH"},
+    {NULL, 0, 0, 0, NULL, NULL, NULL}};
+
+typedef struct
+{
+    const char *name;
+    const char *uri; // NULL for no security
+} policy_t;
+
+static const policy_t policies[] = {
+    {"None", NULL},
+    {"Basic256Sha256", "http://opcfoundation.org/UA/SecurityPolicy#Basic256Sha256"},
+    {"Aes128_Sha256_RsaOaep", "http://opcfoundation.org/UA/SecurityPolicy#Aes128_Sha256_RsaOaep"},
+    {"Aes256_Sha256_RsaPss", "http://opcfoundation.org/UA/SecurityPolicy#Aes256_Sha256_RsaPss"},
+};
+
+typedef struct
+{
+    GThread *thread;
+    UA_Client *client;
+    bench_counter_t counter;
+    bool failed;
+} subscriber_t;
+
+static UA_ByteString client_certificate;
+static UA_ByteString client_key;
+static atomic_bool emitting;
+static atomic_bool subscribing;
+static atomic_bool counting;
+static atomic_int ready;
+
+static bool run_command(const gchar *const *argv)
+{
+    GError *error = NULL;
+    gint status = 0;
+    gchar *output = NULL;
+    if (!g_spawn_sync(
+            NULL,
+            (gchar **)argv,
+            NULL,
+            G_SPAWN_SEARCH_PATH | G_SPAWN_STDOUT_TO_DEV_NULL,
+            NULL,
+            NULL,
+            NULL,
+            &output,
+            &status,
+            &error))
+    {
+        fprintf(stderr, "Failed to run %s (%s)\n", argv[0], error->message);
+        g_error_free(error);
+        return false;
+    }
+    const bool ok = WIFEXITED(status) && 0 == WEXITSTATUS(status);
+    if (!ok)
+    {
+        fprintf(stderr, "%s failed:\n%s", argv[0], output);
+    }
+    g_free(output);
+    return ok;
+}
+
+/* A self-signed certificate in DER and its private key in PEM, both are read by open62541 */
+static bool make_certificate(const gchar *name, const gchar *uri, const gchar *certificate, const gchar *key)
+{
+    gchar *newkey = g_strdup_printf("rsa:%d", key_bits);
+    gchar *subject = g_strdup_printf("/CN=%s", name);
+    gchar *san = g_strdup_printf("subjectAltName=URI:%s,DNS:localhost", uri);
+    const gchar *argv[] = {
+        "openssl",
+        "req",
+        "-x509",
+        "-newkey",
+        newkey,
+        "-nodes",
+        "-sha256",
+        "-days",
+        "1",
+        "-subj",
+        subject,
+        "-addext",
+        san,
+        "-addext",
+        "keyUsage=critical,digitalSignature,nonRepudiation,keyEncipherment,dataEncipherment,keyCertSign",
+        "-addext",
+        "extendedKeyUsage=serverAuth,clientAuth",
+        "-keyout",
+        key,
+        "-outform",
+        "DER",
+        "-out",
+        certificate,
+        NULL};
+    const bool ok = run_command(argv);
+    g_free(newkey);
+    g_free(subject);
+    g_free(san);
+    return ok;
+}
+
+static bool read_bytes(const gchar *path, UA_ByteString *bytes)
+{
+    gchar *data = NULL;
+    gsize length = 0;
+    if (!g_file_get_contents(path, &data, &length, NULL))
+    {
+        fprintf(stderr, "Failed to read %s\n", path);
+        return false;
+    }
+    bool ok = UA_STATUSCODE_GOOD == UA_ByteString_allocBuffer(bytes, length);
+    if (ok)
+    {
+        memcpy(bytes->data, data, length);
+    }
+    g_free(data);
+    return ok;
+}
+
+/* The server's certificate and key in the application directory, the client's certificate in its trust list */
+static bool make_pki(const gchar *dir)
+{
+    gchar *trusted = g_build_filename(dir, "localdata", "pki", "trusted", NULL);
+    gchar *server_certificate = g_build_filename(dir, "localdata", "pki", "server.crt", NULL);
+    gchar *server_key = g_build_filename(dir, "localdata", "pki", "server.key", NULL);
+    gchar *certificate = g_build_filename(trusted, "client.der", NULL);
+    gchar *key = g_build_filename(dir, "client.key", NULL);
+    bool ok = 0 == g_mkdir_with_parents(trusted, 0700) &&
+              make_certificate("opcuaserver", SERVER_URI, server_certificate, server_key) &&
+              make_certificate("bench_secure", CLIENT_URI, certificate, key) &&
+              read_bytes(certificate, &client_certificate) && read_bytes(key, &client_key);
+    g_free(trusted);
+    g_free(server_certificate);
+    g_free(server_key);
+    g_free(certificate);
+    g_free(key);
+    return ok;
+}
+
+static UA_Client *new_client(const policy_t *policy)
+{
+    UA_Client *client = UA_Client_new();
+    UA_ClientConfig *config = UA_Client_getConfig(client);
+    if (NULL == policy->uri)
+    {
+        UA_ClientConfig_setDefault(config);
+        return client;
+    }
+#ifdef UA_ENABLE_ENCRYPTION
+    UA_ClientConfig_setDefaultEncryption(config, client_certificate, client_key, NULL, 0, NULL, 0);
+    // The server's certificate is self-signed and not in a trust list
+    config->certificateVerification.clear(&config->certificateVerification);
+    UA_CertificateVerification_AcceptAll(&config->certificateVerification);
+    config->securityMode = UA_MESSAGESECURITYMODE_SIGNANDENCRYPT;
+    config->securityPolicyUri = UA_STRING_ALLOC(policy->uri);
+#endif
+    return client;
+}
+
+static UA_Client *connect_client(const policy_t *policy, const gint timeout_s)
+{
+    gchar *url = g_strdup_printf("opc.tcp://localhost:%d", ua_port);
+    UA_Client *client = new_client(policy);
+
+    // The server is up when all sensors have been enumerated
+    const gint64 deadline = g_get_monotonic_time() + timeout_s * G_USEC_PER_SEC;
+    UA_StatusCode status;
+    while (UA_STATUSCODE_GOOD != (status = UA_Client_connect(client, url)))
+    {
+        if (g_get_monotonic_time() > deadline)
+        {
+            fprintf(stderr, "Failed to connect to %s with %s (%s)\n", url, policy->name, UA_StatusCode_name(status));
+            UA_Client_delete(client);
+            client = NULL;
+            break;
+        }
+        g_usleep(100 * 1000);
+    }
+    g_free(url);
+    return client;
+}
+
+/* Mean client wall time and server CPU time in ms of handshakes connects, of the channel only or a full connect */
+static bool measure_connects(GPid pid, const policy_t *policy, const bool session, double *wall_ms, double *cpu_ms)
+{
+    gchar *url = g_strdup_printf("opc.tcp://localhost:%d", ua_port);
+    bool ok = true;
+    gint64 wall = 0;
+    const double cpu_before = bench_get_cpu_s(pid);
+    for (gint i = 0; i < handshakes && ok; i++)
+    {
+        UA_Client *client = new_client(policy);
+        const gint64 start = g_get_monotonic_time();
+        const UA_StatusCode status =
+            session ? UA_Client_connect(client, url) : UA_Client_connectSecureChannel(client, url);
+        wall += g_get_monotonic_time() - start;
+        ok = UA_STATUSCODE_GOOD == status;
+        if (!ok)
+        {
+            fprintf(stderr, "Failed to connect with %s (%s)\n", policy->name, UA_StatusCode_name(status));
+        }
+        UA_Client_disconnect(client);
+        UA_Client_delete(client);
+    }
+    const double cpu_after = bench_get_cpu_s(pid);
+    g_free(url);
+    *wall_ms = wall / 1000.0 / handshakes;
+    *cpu_ms = (cpu_after - cpu_before) * 1000.0 / handshakes;
+    return ok;
+}
+
+static gpointer emit_temps(gpointer data)
+{
+    (void)data;
+    const gint64 start = g_get_monotonic_time();
+    guint64 count = 0;
+    while (atomic_load(&emitting))
+    {
+        const guint64 due = (guint64)((g_get_monotonic_time() - start) * (gint64)rate / G_USEC_PER_SEC);
+        for (; count < due; count++)
+        {
+            mock_device_emit_temp(count % temps, 20.0 + (double)(count % 1000) / 100.0);
+        }
+        g_usleep(EMIT_PERIOD_US);
+    }
+    return NULL;
+}
+
+static bool subscribe_all(subscriber_t *subscriber)
+{
+    UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+    request.requestedPublishingInterval = interval;
+    request.maxNotificationsPerPublish = 0;
+    UA_CreateSubscriptionResponse subscription =
+        UA_Client_Subscriptions_create(subscriber->client, request, NULL, NULL, NULL);
+    if (UA_STATUSCODE_GOOD != subscription.responseHeader.serviceResult)
+    {
+        fprintf(
+            stderr,
+            "Failed to create subscription (%s)\n",
+            UA_StatusCode_name(subscription.responseHeader.serviceResult));
+        return false;
+    }
+
+    bool ok = true;
+    for (gint i = 0; i < temps && ok; i++)
+    {
+        UA_MonitoredItemCreateRequest item =
+            UA_MonitoredItemCreateRequest_default(UA_NODEID_NUMERIC(1, NODEID_TEMP_BASE + i));
+        UA_MonitoredItemCreateResult result = UA_Client_MonitoredItems_createDataChange(
+            subscriber->client,
+            subscription.subscriptionId,
+            UA_TIMESTAMPSTORETURN_BOTH,
+            item,
+            &subscriber->counter,
+            bench_count_data_change,
+            NULL);
+        ok = UA_STATUSCODE_GOOD == result.statusCode;
+        if (!ok)
+        {
+            fprintf(stderr, "Failed to monitor temperature %d (%s)\n", i, UA_StatusCode_name(result.statusCode));
+        }
+    }
+    return ok;
+}
+
+static gpointer run_subscriber(gpointer data)
+{
+    subscriber_t *subscriber = data;
+    subscriber->failed = !subscribe_all(subscriber);
+    atomic_fetch_add(&ready, 1);
+    while (!subscriber->failed && atomic_load(&subscribing))
+    {
+        UA_Client_run_iterate(subscriber->client, ITERATE_TIMEOUT_MS);
+    }
+    return NULL;
+}
+
+/* Notifications per second over all subscribers and server CPU in % while temperatures are emitted */
+static bool measure_publish(GPid pid, const policy_t *policy, const gint count, double *received, double *cpu)
+{
+    subscriber_t *subscribers = g_new0(subscriber_t, count);
+    bool ok = true;
+    for (gint i = 0; i < count && ok; i++)
+    {
+        subscribers[i].client = connect_client(policy, CONNECT_TIMEOUT_S);
+        ok = NULL != subscribers[i].client;
+    }
+    atomic_store(&subscribing, true);
+    atomic_store(&counting, false);
+    atomic_store(&ready, 0);
+    for (gint i = 0; i < count && ok; i++)
+    {
+        subscribers[i].counter.counting = &counting;
+        subscribers[i].thread = g_thread_new("subscriber", run_subscriber, &subscribers[i]);
+    }
+    while (ok && atomic_load(&ready) < count)
+    {
+        g_usleep(1000);
+    }
+
+    // Let the initial values arrive before counting
+    atomic_store(&emitting, true);
+    GThread *emitter = g_thread_new("emitter", emit_temps, NULL);
+    g_usleep(G_USEC_PER_SEC);
+    const double cpu_before = bench_get_cpu_s(pid);
+    const gint64 start = g_get_monotonic_time();
+    atomic_store(&counting, true);
+    g_usleep((gulong)duration * G_USEC_PER_SEC);
+    atomic_store(&counting, false);
+    const double elapsed = (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+    const double cpu_after = bench_get_cpu_s(pid);
+    atomic_store(&emitting, false);
+    g_thread_join(emitter);
+    atomic_store(&subscribing, false);
+
+    guint64 total = 0;
+    for (gint i = 0; i < count; i++)
+    {
+        if (NULL != subscribers[i].thread)
+        {
+            g_thread_join(subscribers[i].thread);
+        }
+        if (NULL != subscribers[i].client)
+        {
+            UA_Client_disconnect(subscribers[i].client);
+            UA_Client_delete(subscribers[i].client);
+        }
+        total += atomic_load(&subscribers[i].counter.received);
+        ok = ok && !subscribers[i].failed;
+    }
+    g_free(subscribers);
+    *received = total / elapsed;
+    *cpu = 100.0 * (cpu_after - cpu_before) / elapsed;
+    return ok;
+}
+
+static GSubprocess *spawn_server(const gchar *address, const gchar *dir)
+{
+    GError *error = NULL;
+    gchar *port = g_strdup_printf("%d", ua_port);
+    gchar *min_interval = g_strdup_printf("%d", interval);
+    gchar *path = g_canonicalize_filename(server_path, NULL);
+    gchar *log = g_canonicalize_filename(server_log, NULL);
+    GSubprocessLauncher *launcher = g_subprocess_launcher_new(G_SUBPROCESS_FLAGS_STDERR_MERGE);
+    g_subprocess_launcher_set_cwd(launcher, dir);
+    g_subprocess_launcher_setenv(launcher, "DBUS_SYSTEM_BUS_ADDRESS", address, TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_port", port, TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_serverMinPublishingInterval", min_interval, TRUE);
+    g_subprocess_launcher_setenv(launcher, "AXPARAMETER_logLevel", "warning", FALSE);
+    g_subprocess_launcher_set_stdout_file_path(launcher, log);
+
+    GSubprocess *server = g_subprocess_launcher_spawn(launcher, &error, path, NULL);
+    if (NULL == server)
+    {
+        fprintf(stderr, "Failed to start %s (%s)\n", path, error->message);
+        g_error_free(error);
+    }
+    g_object_unref(launcher);
+    g_free(port);
+    g_free(min_interval);
+    g_free(path);
+    g_free(log);
+    return server;
+}
+
+/* Handshake and publish figures for a policy, false if the server does not offer it */
+static bool run_policy(GPid pid, const policy_t *policy, const gint *steps, const gint nbr_steps)
+{
+    UA_Client *client = connect_client(policy, 1);
+    if (NULL == client)
+    {
+        printf("%-22s not offered by the server\n", policy->name);
+        return false;
+    }
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+
+    double channel_ms, channel_cpu_ms, connect_ms, connect_cpu_ms;
+    if (!measure_connects(pid, policy, false, &channel_ms, &channel_cpu_ms) ||
+        !measure_connects(pid, policy, true, &connect_ms, &connect_cpu_ms))
+    {
+        return false;
+    }
+    printf("%-22s %12.2f %12.2f %12.2f %12.2f\n", policy->name, channel_ms, channel_cpu_ms, connect_ms, connect_cpu_ms);
+
+    for (gint i = 0; i < nbr_steps; i++)
+    {
+        double received, cpu;
+        if (!measure_publish(pid, policy, steps[i], &received, &cpu))
+        {
+            fprintf(stderr, "Failed to measure %d subscribers with %s\n", steps[i], policy->name);
+            return false;
+        }
+        printf("%-22s %12d %12.0f %12.1f\n", "", steps[i], received, cpu);
+    }
+    return true;
+}
+
+static gint parse_steps(gint *steps)
+{
+    gchar **parts = g_strsplit(subscribers_list, ",", MAX_STEPS + 1);
+    gint count = 0;
+    for (gint i = 0; NULL != parts[i] && count < MAX_STEPS; i++)
+    {
+        const gint value = atoi(parts[i]);
+        if (0 >= value)
+        {
+            count = 0;
+            break;
+        }
+        steps[count++] = value;
+    }
+    g_strfreev(parts);
+    return count;
+}
+
+static bool run(const gchar *address, const gchar *dir, const gint *steps, const gint nbr_steps)
+{
+    GSubprocess *server = spawn_server(address, dir);
+    if (NULL == server)
+    {
+        return false;
+    }
+    const GPid pid = atoi(g_subprocess_get_identifier(server));
+
+    // Wait until the server is up
+    UA_Client *client = connect_client(&policies[0], CONNECT_TIMEOUT_S);
+    if (NULL == client)
+    {
+        bench_stop_server(server);
+        return false;
+    }
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+
+    printf("%-22s %12s %12s %12s %12s\n", "policy", "channel ms", "server ms", "connect ms", "server ms");
+    printf("%-22s %12s %12s %12s\n", "", "subscribers", "notif/s", "cpu %");
+    gint offered = 0;
+    for (size_t i = 0; i < sizeof(policies) / sizeof(policies[0]); i++)
+    {
+        offered += run_policy(pid, &policies[i], steps, nbr_steps) ? 1 : 0;
+    }
+    bench_stop_server(server);
+    return 1 < offered;
+}
+
+int main(int argc, char **argv)
+{
+    GError *error = NULL;
+    GOptionContext *options = g_option_context_new("- cost of secure channels and encrypted publishing");
+    g_option_context_add_main_entries(options, entries, NULL);
+    if (!g_option_context_parse(options, &argc, &argv, &error))
+    {
+        fprintf(stderr, "%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free(options);
+    gint steps[MAX_STEPS];
+    const gint nbr_steps = parse_steps(steps);
+    if (0 >= temps || 0 >= rate || 0 >= handshakes || 0 >= duration || 0 >= interval || 1024 > key_bits ||
+        0 == nbr_steps)
+    {
+        fprintf(stderr, "Invalid options\n");
+        return EXIT_FAILURE;
+    }
+#ifndef UA_ENABLE_ENCRYPTION
+    fprintf(stderr, "open62541 is built without encryption\n");
+    return EXIT_FAILURE;
+#endif
+
+    gchar *dir = g_dir_make_tmp("bench_secure-XXXXXX", &error);
+    if (NULL == dir)
+    {
+        fprintf(stderr, "%s\n", error->message);
+        g_error_free(error);
+        return EXIT_FAILURE;
+    }
+    bool ok = make_pki(dir);
+
+    // A private bus in place of the system bus
+    GTestDBus *bus = g_test_dbus_new(G_TEST_DBUS_NONE);
+    g_test_dbus_up(bus);
+    ok = ok && mock_device_start(g_test_dbus_get_bus_address(bus), temps, 0, 0);
+    if (ok)
+    {
+        printf(
+            "%d temperatures at %d signals/s, %d bit keys, %d connects per policy, %d ms publishing, %d s per count\n",
+            temps,
+            rate,
+            key_bits,
+            handshakes,
+            interval,
+            duration);
+        ok = run(g_test_dbus_get_bus_address(bus), dir, steps, nbr_steps);
+    }
+    mock_device_stop();
+    g_test_dbus_down(bus);
+    g_object_unref(bus);
+
+    const gchar *rm[] = {"rm", "-rf", dir, NULL};
+    (void)run_command(rm);
+    g_free(dir);
+    UA_ByteString_clear(&client_certificate);
+    UA_ByteString_clear(&client_key);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
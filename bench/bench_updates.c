@@ -0,0 +1,155 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Throughput of the update queue with the D-Bus side and the server thread on
+ * their own threads, and checks of its statistics: a queue the consumer keeps
+ * empty must report a small high-water mark, and a known backlog must be
+ * reported as such.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "opcua_updates.h"
+
+#define UPDATES 20000000
+#define BACKLOG 100
+
+static updates_t updates;
+static atomic_bool producing;
+static uint64_t consumed;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void count(const update_t *update, void *user_data)
+{
+    (void)update;
+    (*(uint64_t *)user_data)++;
+}
+
+static void *consume(void *data)
+{
+    (void)data;
+    // Yield rather than spin when empty, the producer may share the core
+    while (0 < updates_drain(&updates, count, &consumed, UPDATES_CAPACITY) || atomic_load(&producing))
+    {
+        (void)sched_yield();
+    }
+    return NULL;
+}
+
+static bool check(const bool ok, const char *what, const updates_stats_t *stats)
+{
+    if (!ok)
+    {
+        fprintf(
+            stderr,
+            "%s: depth %zu high_water %zu overflows %llu\n",
+            what,
+            stats->depth,
+            stats->high_water,
+            (unsigned long long)stats->overflows);
+    }
+    return ok;
+}
+
+int main(void)
+{
+    const update_t update = {0};
+    updates_stats_t stats;
+    uint64_t drained = 0;
+    bool ok = true;
+
+    // Every update taken right after it was queued
+    updates_init(&updates);
+    for (size_t i = 0; i < 10 * UPDATES_CAPACITY; i++)
+    {
+        (void)updates_push(&updates, &update);
+        (void)updates_drain(&updates, count, &drained, UPDATES_CAPACITY);
+    }
+    updates_get_stats(&updates, &stats);
+    ok = check(0 == stats.depth && 1 == stats.high_water && 0 == stats.overflows, "Drained queue", &stats) && ok;
+
+    // A known backlog, then drained again
+    updates_init(&updates);
+    for (size_t i = 0; i < BACKLOG; i++)
+    {
+        (void)updates_push(&updates, &update);
+    }
+    updates_get_stats(&updates, &stats);
+    ok = check(BACKLOG == stats.depth, "Backlog depth", &stats) && ok;
+    (void)updates_drain(&updates, count, &drained, UPDATES_CAPACITY);
+    for (size_t i = 0; i < UPDATES_CAPACITY; i++)
+    {
+        (void)updates_push(&updates, &update);
+        (void)updates_drain(&updates, count, &drained, UPDATES_CAPACITY);
+    }
+    updates_get_stats(&updates, &stats);
+    ok = check(0 == stats.depth && BACKLOG == stats.high_water, "Backlog high-water", &stats) && ok;
+
+    // A full queue
+    updates_init(&updates);
+    for (size_t i = 0; i < UPDATES_CAPACITY + 1; i++)
+    {
+        (void)updates_push(&updates, &update);
+    }
+    (void)updates_drain(&updates, count, &drained, UPDATES_CAPACITY);
+    updates_get_stats(&updates, &stats);
+    ok = check(UPDATES_CAPACITY == stats.high_water && 1 == stats.overflows, "Full queue", &stats) && ok;
+
+    // Throughput between two threads, retrying when the queue is full
+    updates_init(&updates);
+    atomic_store(&producing, true);
+    pthread_t consumer;
+    if (0 != pthread_create(&consumer, NULL, consume, NULL))
+    {
+        fprintf(stderr, "Failed to create the consumer thread\n");
+        return EXIT_FAILURE;
+    }
+    const uint64_t start = now_ns();
+    for (size_t i = 0; i < UPDATES; i++)
+    {
+        while (!updates_push(&updates, &update))
+        {
+            (void)sched_yield();
+        }
+    }
+    atomic_store(&producing, false);
+    pthread_join(consumer, NULL);
+    const uint64_t elapsed_ns = now_ns() - start;
+    updates_get_stats(&updates, &stats);
+    ok = check(UPDATES == consumed && 0 == stats.depth, "Threads", &stats) && ok;
+
+    printf(
+        "%d updates: %.1f ns/update, high-water %zu of %u, full %llu times\n",
+        UPDATES,
+        (double)elapsed_ns / UPDATES,
+        stats.high_water,
+        UPDATES_CAPACITY,
+        (unsigned long long)stats.overflows);
+    printf("statistics checks: %s\n", ok ? "passed" : "FAILED");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,470 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <open62541/client_config_default.h>
+
+#include <assert.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mock_device.h"
+
+#define TEMP_DBUS_SERVICE "com.axis.TemperatureController"
+#define TEMP_DBUS_OBJECT "/com/axis/TemperatureController"
+#define TEMP_DBUS_INTERFACE "com.axis.TemperatureController"
+
+#define PORTS_DBUS_SERVICE "com.axis.IOControl.State"
+#define PORTS_DBUS_OBJECT "/com/axis/IOControl/State"
+#define PORTS_DBUS_INTERFACE "com.axis.IOControl.State"
+
+/* Subscription id handed out for sensor n is n + MOCK_SUBID_BASE */
+#define MOCK_SUBID_BASE 1
+
+#define CALL_TIMEOUT_MS 5000
+
+static const gchar introspection_xml[] =
+    "<node>"
+    "  <interface name='" TEMP_DBUS_INTERFACE "'>"
+    "    <method name='GetNbrOfTemperatureSensors'>"
+    "      <arg type='i' direction='out'/>"
+    "    </method>"
+    "    <method name='GetTemperature'>"
+    "      <arg type='i' direction='in'/>"
+    "      <arg type='s' direction='in'/>"
+    "      <arg type='d' direction='out'/>"
+    "    </method>"
+    "    <method name='RegisterForTemperatureChangeSignal'>"
+    "      <arg type='i' direction='in'/>"
+    "      <arg type='d' direction='in'/>"
+    "      <arg type='i' direction='out'/>"
+    "    </method>"
+    "    <method name='UnregisterForTemperatureChangeSignal'>"
+    "      <arg type='i' direction='in'/>"
+    "    </method>"
+    "    <signal name='TemperatureChangeSignal'>"
+    "      <arg type='i'/>"
+    "      <arg type='d'/>"
+    "    </signal>"
+    "  </interface>"
+    "  <interface name='" PORTS_DBUS_INTERFACE "'>"
+    "    <method name='GetNbrPorts'>"
+    "      <arg type='u' direction='out'/>"
+    "      <arg type='u' direction='out'/>"
+    "    </method>"
+    "    <method name='GetState'>"
+    "      <arg type='u' direction='in'/>"
+    "      <arg type='b' direction='out'/>"
+    "    </method>"
+    "    <method name='SetState'>"
+    "      <arg type='u' direction='in'/>"
+    "      <arg type='b' direction='in'/>"
+    "    </method>"
+    "    <signal name='PortChanged'>"
+    "      <arg type='i'/>"
+    "      <arg type='b'/>"
+    "      <arg type='b'/>"
+    "      <arg type='b'/>"
+    "      <arg type='b'/>"
+    "      <arg type='b'/>"
+    "      <arg type='b'/>"
+    "    </signal>"
+    "  </interface>"
+    "</node>";
+
+static GDBusConnection *connection;
+static GDBusNodeInfo *introspection;
+static GMainContext *context;
+static GMainLoop *loop;
+static GThread *thread;
+static guint object_ids[2];
+
+static guint nbr_temps;
+static guint nbr_inputs;
+static guint nbr_outputs;
+static gint registrations;
+static gint unregistrations;
+
+/* Last emitted values, returned by GetTemperature and GetState */
+static GMutex values_lock;
+static double *temp_values;
+static gboolean *port_states;
+
+/* Monotonic time of the last SetState of each port */
+static gint64 *set_times;
+
+static void on_temp_call(
+    GDBusConnection *conn,
+    const gchar *sender,
+    const gchar *object_path,
+    const gchar *interface_name,
+    const gchar *method_name,
+    GVariant *parameters,
+    GDBusMethodInvocation *invocation,
+    gpointer user_data)
+{
+    (void)conn;
+    (void)sender;
+    (void)object_path;
+    (void)interface_name;
+    (void)user_data;
+    gint32 sensor = 0;
+
+    if (0 == g_strcmp0(method_name, "GetNbrOfTemperatureSensors"))
+    {
+        g_dbus_method_invocation_return_value(invocation, g_variant_new("(i)", nbr_temps));
+        return;
+    }
+    g_variant_get_child(parameters, 0, "i", &sensor);
+    if (0 == g_strcmp0(method_name, "UnregisterForTemperatureChangeSignal"))
+    {
+        g_atomic_int_inc(&unregistrations);
+        g_dbus_method_invocation_return_value(invocation, NULL);
+        return;
+    }
+    if (0 > sensor || nbr_temps <= (guint)sensor)
+    {
+        g_dbus_method_invocation_return_error(
+            invocation, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS, "No temperature sensor %i", sensor);
+        return;
+    }
+    if (0 == g_strcmp0(method_name, "GetTemperature"))
+    {
+        g_mutex_lock(&values_lock);
+        const double value = temp_values[sensor];
+        g_mutex_unlock(&values_lock);
+        g_dbus_method_invocation_return_value(invocation, g_variant_new("(d)", value));
+    }
+    else
+    {
+        g_atomic_int_inc(&registrations);
+        g_dbus_method_invocation_return_value(invocation, g_variant_new("(i)", sensor + MOCK_SUBID_BASE));
+    }
+}
+
+static void on_ports_call(
+    GDBusConnection *conn,
+    const gchar *sender,
+    const gchar *object_path,
+    const gchar *interface_name,
+    const gchar *method_name,
+    GVariant *parameters,
+    GDBusMethodInvocation *invocation,
+    gpointer user_data)
+{
+    (void)conn;
+    (void)sender;
+    (void)object_path;
+    (void)interface_name;
+    (void)user_data;
+    guint32 port = 0;
+
+    if (0 == g_strcmp0(method_name, "GetNbrPorts"))
+    {
+        g_dbus_method_invocation_return_value(invocation, g_variant_new("(uu)", nbr_inputs, nbr_outputs));
+        return;
+    }
+    g_variant_get_child(parameters, 0, "u", &port);
+    if (nbr_inputs + nbr_outputs <= port)
+    {
+        g_dbus_method_invocation_return_error(
+            invocation, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS, "No port %u", port);
+        return;
+    }
+    if (0 == g_strcmp0(method_name, "SetState"))
+    {
+        gboolean state = FALSE;
+        if (port < nbr_inputs)
+        {
+            g_dbus_method_invocation_return_error(
+                invocation, G_DBUS_ERROR, G_DBUS_ERROR_ACCESS_DENIED, "Port %u is an input", port);
+            return;
+        }
+        g_variant_get_child(parameters, 1, "b", &state);
+        g_mutex_lock(&values_lock);
+        set_times[port] = g_get_monotonic_time();
+        g_mutex_unlock(&values_lock);
+        g_dbus_method_invocation_return_value(invocation, NULL);
+        mock_device_emit_port(port, state);
+        return;
+    }
+    g_mutex_lock(&values_lock);
+    const gboolean state = port_states[port];
+    g_mutex_unlock(&values_lock);
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(b)", state));
+}
+
+static const GDBusInterfaceVTable temp_vtable = {on_temp_call, NULL, NULL, {0}};
+static const GDBusInterfaceVTable ports_vtable = {on_ports_call, NULL, NULL, {0}};
+
+static bool request_name(const gchar *name)
+{
+    GError *error = NULL;
+    GVariant *result = g_dbus_connection_call_sync(
+        connection,
+        "org.freedesktop.DBus",
+        "/org/freedesktop/DBus",
+        "org.freedesktop.DBus",
+        "RequestName",
+        g_variant_new("(su)", name, 0x4 /* DBUS_NAME_FLAG_DO_NOT_QUEUE */),
+        G_VARIANT_TYPE("(u)"),
+        G_DBUS_CALL_FLAGS_NONE,
+        CALL_TIMEOUT_MS,
+        NULL,
+        &error);
+    if (NULL == result)
+    {
+        fprintf(stderr, "Failed to own %s (%s)\n", name, error->message);
+        g_error_free(error);
+        return false;
+    }
+    guint32 reply;
+    g_variant_get(result, "(u)", &reply);
+    g_variant_unref(result);
+    return 1 == reply; // DBUS_REQUEST_NAME_REPLY_PRIMARY_OWNER
+}
+
+static guint register_object(const gchar *path, guint interface, const GDBusInterfaceVTable *vtable)
+{
+    GError *error = NULL;
+    guint id = g_dbus_connection_register_object(
+        connection, path, introspection->interfaces[interface], vtable, NULL, NULL, &error);
+    if (0 == id)
+    {
+        fprintf(stderr, "Failed to register %s (%s)\n", path, error->message);
+        g_error_free(error);
+    }
+    return id;
+}
+
+static gpointer run(gpointer data)
+{
+    (void)data;
+    g_main_context_push_thread_default(context);
+    g_main_loop_run(loop);
+    g_main_context_pop_thread_default(context);
+    return NULL;
+}
+
+bool mock_device_start(const gchar *address, guint temps, guint inputs, guint outputs)
+{
+    assert(NULL != address);
+    assert(NULL == connection);
+    GError *error = NULL;
+
+    nbr_temps = temps;
+    nbr_inputs = inputs;
+    nbr_outputs = outputs;
+    g_atomic_int_set(&registrations, 0);
+    g_atomic_int_set(&unregistrations, 0);
+    temp_values = g_new(double, MAX(temps, 1));
+    for (guint i = 0; i < temps; i++)
+    {
+        temp_values[i] = MOCK_INITIAL_TEMP;
+    }
+    port_states = g_new0(gboolean, MAX(inputs + outputs, 1));
+    set_times = g_new0(gint64, MAX(inputs + outputs, 1));
+
+    // Method calls are dispatched in the context that is thread default when the objects are registered
+    context = g_main_context_new();
+    loop = g_main_loop_new(context, FALSE);
+    g_main_context_push_thread_default(context);
+    connection = g_dbus_connection_new_for_address_sync(
+        address,
+        G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT | G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+        NULL,
+        NULL,
+        &error);
+    if (NULL == connection)
+    {
+        fprintf(stderr, "Failed to connect to %s (%s)\n", address, error->message);
+        g_error_free(error);
+        g_main_context_pop_thread_default(context);
+        return false;
+    }
+    introspection = g_dbus_node_info_new_for_xml(introspection_xml, NULL);
+    assert(NULL != introspection);
+    object_ids[0] = register_object(TEMP_DBUS_OBJECT, 0, &temp_vtable);
+    object_ids[1] = register_object(PORTS_DBUS_OBJECT, 1, &ports_vtable);
+    g_main_context_pop_thread_default(context);
+
+    if (0 == object_ids[0] || 0 == object_ids[1] || !request_name(TEMP_DBUS_SERVICE) ||
+        !request_name(PORTS_DBUS_SERVICE))
+    {
+        mock_device_stop();
+        return false;
+    }
+
+    thread = g_thread_new("mock_device", run, NULL);
+    return true;
+}
+
+void mock_device_stop(void)
+{
+    if (NULL != thread)
+    {
+        g_main_loop_quit(loop);
+        g_thread_join(thread);
+        thread = NULL;
+    }
+    for (guint i = 0; i < G_N_ELEMENTS(object_ids); i++)
+    {
+        if (0 != object_ids[i])
+        {
+            g_dbus_connection_unregister_object(connection, object_ids[i]);
+            object_ids[i] = 0;
+        }
+    }
+    g_clear_object(&connection);
+    g_clear_pointer(&introspection, g_dbus_node_info_unref);
+    g_clear_pointer(&loop, g_main_loop_unref);
+    g_clear_pointer(&context, g_main_context_unref);
+    g_clear_pointer(&temp_values, g_free);
+    g_clear_pointer(&port_states, g_free);
+    g_clear_pointer(&set_times, g_free);
+}
+
+/* Number of RegisterForTemperatureChangeSignal calls so far */
+guint mock_device_get_registrations(void)
+{
+    return g_atomic_int_get(&registrations);
+}
+
+/* Number of UnregisterForTemperatureChangeSignal calls so far */
+guint mock_device_get_unregistrations(void)
+{
+    return g_atomic_int_get(&unregistrations);
+}
+
+/* Monotonic time in us of the last SetState of a port, 0 if never set */
+gint64 mock_device_get_set_time(guint port)
+{
+    assert(NULL != connection);
+    assert(port < nbr_inputs + nbr_outputs);
+    g_mutex_lock(&values_lock);
+    const gint64 time = set_times[port];
+    g_mutex_unlock(&values_lock);
+    return time;
+}
+
+void mock_device_emit_temp(guint sensor, double value)
+{
+    assert(NULL != connection);
+    assert(sensor < nbr_temps);
+    g_mutex_lock(&values_lock);
+    temp_values[sensor] = value;
+    g_mutex_unlock(&values_lock);
+    (void)g_dbus_connection_emit_signal(
+        connection,
+        NULL,
+        TEMP_DBUS_OBJECT,
+        TEMP_DBUS_INTERFACE,
+        "TemperatureChangeSignal",
+        g_variant_new("(id)", sensor + MOCK_SUBID_BASE, value),
+        NULL);
+}
+
+void mock_device_emit_port(guint port, bool state)
+{
+    assert(NULL != connection);
+    assert(port < nbr_inputs + nbr_outputs);
+    g_mutex_lock(&values_lock);
+    port_states[port] = state;
+    g_mutex_unlock(&values_lock);
+    const gboolean input = port < nbr_inputs;
+    (void)g_dbus_connection_emit_signal(
+        connection,
+        NULL,
+        PORTS_DBUS_OBJECT,
+        PORTS_DBUS_INTERFACE,
+        "PortChanged",
+        g_variant_new("(ibbbbbb)", port, FALSE, FALSE, input, FALSE, state, FALSE),
+        NULL);
+}
+
+double bench_get_cpu_s(GPid pid)
+{
+    gchar *path = g_strdup_printf("/proc/%d/stat", pid);
+    gchar *stat = NULL;
+    bool ok = g_file_get_contents(path, &stat, NULL, NULL);
+    g_free(path);
+    if (!ok)
+    {
+        return 0.0;
+    }
+
+    // utime and stime are the 12th and 13th fields after the command name
+    unsigned long utime = 0;
+    unsigned long stime = 0;
+    const gchar *fields = strrchr(stat, ')');
+    if (NULL != fields)
+    {
+        (void)sscanf(fields + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime);
+    }
+    g_free(stat);
+    return (double)(utime + stime) / sysconf(_SC_CLK_TCK);
+}
+
+UA_Client *bench_connect_client(gint port, gint timeout_s)
+{
+    gchar *url = g_strdup_printf("opc.tcp://localhost:%d", port);
+    UA_Client *client = UA_Client_new();
+    UA_ClientConfig_setDefault(UA_Client_getConfig(client));
+
+    // The server is up when all sensors and ports have been enumerated
+    const gint64 deadline = g_get_monotonic_time() + timeout_s * G_USEC_PER_SEC;
+    while (UA_STATUSCODE_GOOD != UA_Client_connect(client, url))
+    {
+        if (g_get_monotonic_time() > deadline)
+        {
+            fprintf(stderr, "Failed to connect to %s\n", url);
+            UA_Client_delete(client);
+            client = NULL;
+            break;
+        }
+        g_usleep(100 * 1000);
+    }
+    g_free(url);
+    return client;
+}
+
+void bench_stop_server(GSubprocess *server)
+{
+    g_subprocess_send_signal(server, SIGTERM);
+    (void)g_subprocess_wait(server, NULL, NULL);
+    g_object_unref(server);
+}
+
+void bench_count_data_change(
+    UA_Client *client,
+    UA_UInt32 sub_id,
+    void *sub_context,
+    UA_UInt32 mon_id,
+    void *mon_context,
+    UA_DataValue *value)
+{
+    (void)client;
+    (void)sub_id;
+    (void)sub_context;
+    (void)mon_id;
+    (void)value;
+    bench_counter_t *counter = mon_context;
+    if (atomic_load(counter->counting))
+    {
+        atomic_fetch_add(&counter->received, 1);
+    }
+}
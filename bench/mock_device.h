@@ -0,0 +1,66 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Stand-in for the com.axis.TemperatureController and com.axis.IOControl.State
+ * services of a camera, for running opcuaserver on a host. The services are
+ * served on their own thread and the signals can be emitted from any thread.
+ * SetState of an output port emits PortChanged, as on a camera.
+ */
+
+#ifndef _MOCK_DEVICE_H_
+#define _MOCK_DEVICE_H_
+
+#include <gio/gio.h>
+#include <open62541/client.h>
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+/* Value returned by GetTemperature until the first emitted value */
+#define MOCK_INITIAL_TEMP -1.0
+
+bool mock_device_start(const gchar *address, guint temps, guint inputs, guint outputs);
+void mock_device_stop(void);
+guint mock_device_get_registrations(void);
+guint mock_device_get_unregistrations(void);
+gint64 mock_device_get_set_time(guint port);
+void mock_device_emit_temp(guint sensor, double value);
+void mock_device_emit_port(guint port, bool state);
+
+/*
+ * Helpers the benchmarks share. A bench_counter_t as the context of monitored
+ * items counts their data changes with bench_count_data_change while the flag
+ * it points to is set.
+ */
+typedef struct
+{
+    const atomic_bool *counting;
+    atomic_uint_fast64_t received;
+} bench_counter_t;
+
+double bench_get_cpu_s(GPid pid);
+UA_Client *bench_connect_client(gint port, gint timeout_s);
+void bench_stop_server(GSubprocess *server);
+void bench_count_data_change(
+    UA_Client *client,
+    UA_UInt32 sub_id,
+    void *sub_context,
+    UA_UInt32 mon_id,
+    void *mon_context,
+    UA_DataValue *value);
+
+#endif /* _MOCK_DEVICE_H_ */
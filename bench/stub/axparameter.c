@@ -0,0 +1,108 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+
+#include "axparameter.h"
+
+#define MANIFEST_PATH "manifest.json"
+#define ENV_PREFIX "AXPARAMETER_"
+
+/* One paramConfig entry per line, as in the repository's manifest.json */
+#define PARAM_CONFIG_REGEX "\"name\":\\s*\"([^\"]+)\"[^}]*\"default\":\\s*\"([^\"]*)\""
+
+struct _AXParameter
+{
+    GHashTable *defaults;
+};
+
+static GHashTable *read_defaults(GError **error)
+{
+    const gchar *path = g_getenv("AXPARAMETER_MANIFEST");
+    gchar *manifest = NULL;
+    if (!g_file_get_contents(NULL != path ? path : MANIFEST_PATH, &manifest, NULL, error))
+    {
+        return NULL;
+    }
+
+    GHashTable *defaults = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    GRegex *regex = g_regex_new(PARAM_CONFIG_REGEX, 0, 0, NULL);
+    GMatchInfo *match;
+    g_regex_match(regex, manifest, 0, &match);
+    while (g_match_info_matches(match))
+    {
+        g_hash_table_insert(defaults, g_match_info_fetch(match, 1), g_match_info_fetch(match, 2));
+        g_match_info_next(match, NULL);
+    }
+    g_match_info_free(match);
+    g_regex_unref(regex);
+    g_free(manifest);
+    return defaults;
+}
+
+AXParameter *ax_parameter_new(const gchar *app_name, GError **error)
+{
+    (void)app_name;
+    GHashTable *defaults = read_defaults(error);
+    if (NULL == defaults)
+    {
+        return NULL;
+    }
+    AXParameter *parameter = g_new0(AXParameter, 1);
+    parameter->defaults = defaults;
+    return parameter;
+}
+
+void ax_parameter_free(AXParameter *parameter)
+{
+    if (NULL == parameter)
+    {
+        return;
+    }
+    g_hash_table_unref(parameter->defaults);
+    g_free(parameter);
+}
+
+gboolean ax_parameter_register_callback(
+    AXParameter *parameter,
+    const gchar *name,
+    AXParameterCallback callback,
+    gpointer userdata,
+    GError **error)
+{
+    (void)parameter;
+    (void)name;
+    (void)callback;
+    (void)userdata;
+    (void)error;
+    return TRUE;
+}
+
+gboolean ax_parameter_get(AXParameter *parameter, const gchar *name, gchar **value, GError **error)
+{
+    gchar *env_name = g_strconcat(ENV_PREFIX, name, NULL);
+    const gchar *env_value = g_getenv(env_name);
+    g_free(env_name);
+
+    const gchar *result = NULL != env_value ? env_value : g_hash_table_lookup(parameter->defaults, name);
+    if (NULL == result)
+    {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_NOENT, "No parameter %s", name);
+        return FALSE;
+    }
+    *value = g_strdup(result);
+    return TRUE;
+}
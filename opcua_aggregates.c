@@ -0,0 +1,596 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "opcua_aggregates.h"
+#include "opcua_common.h"
+
+/* Recompute mean and variance from the samples this often, removals add up rounding errors */
+#define RECOMPUTE_INTERVAL 65536
+
+#define SAMPLES_INITIAL 64
+
+enum
+{
+    STAT_MIN,
+    STAT_MAX,
+    STAT_MEAN,
+    STAT_STDDEV
+};
+
+static const char *stat_names[AGGREGATES_STATS] = {"min", "max", "mean", "stddev"};
+
+typedef struct
+{
+    int64_t time; // monotonic time in ns
+    double value;
+} sample_t;
+
+/* Sample numbers in the window, in the order they were added, with the same capacity as the samples */
+typedef struct
+{
+    uint64_t *items;
+    uint64_t front;
+    uint64_t back; // one past the newest item
+} deque_t;
+
+/*
+ * One sliding window. A sample stays in the window until the next sample is
+ * older than the window, i.e. the value in effect at the start of the window
+ * counts too, so that a sensor that has not changed for a while still has
+ * aggregates.
+ */
+typedef struct
+{
+    int64_t span; // ns
+    uint64_t first; // number of the oldest sample in the window
+    double mean;
+    double m2; // sum of squared differences from the mean (Welford)
+    deque_t min; // increasing values, the front is the minimum
+    deque_t max; // decreasing values, the front is the maximum
+} window_t;
+
+/* All samples that are still in some window of one sensor, numbered from the first one */
+typedef struct
+{
+    const channel_t *channel;
+    sample_t *samples;
+    size_t capacity; // a power of two
+    uint64_t oldest;
+    uint64_t next;
+    uint64_t recompute; // samples added until the next recompute
+    bool dirty;
+    window_t windows[AGGREGATES_WINDOWS_MAX];
+} series_t;
+
+/* Set from the GLib main loop, applied by the UA server thread in aggregates_sync */
+static pthread_mutex_t pending_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t pending_windows[AGGREGATES_WINDOWS_MAX] = {60, 900, 3600};
+static size_t pending_count = 3;
+static bool pending_changed;
+
+/* Only touched by the UA server thread, or while it is not running */
+static uint32_t windows_s[AGGREGATES_WINDOWS_MAX];
+static size_t windows_count;
+static series_t *series; // indexed by channel slot, only temperature channels are used
+static size_t series_size;
+static int64_t last_publish;
+
+static const sample_t *sample_at(const series_t *s, const uint64_t number)
+{
+    return &s->samples[number & (s->capacity - 1)];
+}
+
+static uint64_t deque_front(const series_t *s, const deque_t *d)
+{
+    return d->items[d->front & (s->capacity - 1)];
+}
+
+static uint64_t deque_back(const series_t *s, const deque_t *d)
+{
+    return d->items[(d->back - 1) & (s->capacity - 1)];
+}
+
+static void deque_push(const series_t *s, deque_t *d, const uint64_t number, const bool is_min)
+{
+    const double value = sample_at(s, number)->value;
+
+    // Drop the samples that can no longer be the minimum (maximum) while this one is in the window
+    while (d->front != d->back)
+    {
+        const double back = sample_at(s, deque_back(s, d))->value;
+        if (is_min ? back < value : back > value)
+        {
+            break;
+        }
+        d->back--;
+    }
+    d->items[d->back & (s->capacity - 1)] = number;
+    d->back++;
+}
+
+static void window_push(const series_t *s, window_t *w, const uint64_t number)
+{
+    const double value = sample_at(s, number)->value;
+    const double count = (double)(number + 1 - w->first);
+    const double delta = value - w->mean;
+    w->mean += delta / count;
+    w->m2 += delta * (value - w->mean);
+    deque_push(s, &w->min, number, true);
+    deque_push(s, &w->max, number, false);
+}
+
+static void window_pop(const series_t *s, window_t *w)
+{
+    const double value = sample_at(s, w->first)->value;
+    const double count = (double)(s->next - w->first - 1);
+    if (0 < count)
+    {
+        const double delta = value - w->mean;
+        w->mean -= delta / count;
+        w->m2 -= delta * (value - w->mean);
+    }
+    else
+    {
+        w->mean = 0.0;
+        w->m2 = 0.0;
+    }
+    if (w->min.front != w->min.back && deque_front(s, &w->min) == w->first)
+    {
+        w->min.front++;
+    }
+    if (w->max.front != w->max.back && deque_front(s, &w->max) == w->first)
+    {
+        w->max.front++;
+    }
+    w->first++;
+}
+
+static void window_recompute(const series_t *s, window_t *w)
+{
+    double mean = 0.0;
+    double m2 = 0.0;
+    double count = 0.0;
+    for (uint64_t number = w->first; number < s->next; number++)
+    {
+        const double value = sample_at(s, number)->value;
+        count += 1.0;
+        const double delta = value - mean;
+        mean += delta / count;
+        m2 += delta * (value - mean);
+    }
+    w->mean = mean;
+    w->m2 = m2;
+}
+
+/* Move everything to arrays of twice the size, the sample numbers stay the same */
+static bool series_grow(series_t *s)
+{
+    const size_t capacity = s->capacity * 2;
+    const size_t mask = capacity - 1;
+    sample_t *samples = malloc(capacity * sizeof(sample_t));
+    if (NULL == samples)
+    {
+        return false;
+    }
+    uint64_t *items[AGGREGATES_WINDOWS_MAX][2];
+    for (size_t i = 0; i < windows_count; i++)
+    {
+        items[i][0] = malloc(capacity * sizeof(uint64_t));
+        items[i][1] = malloc(capacity * sizeof(uint64_t));
+        if (NULL == items[i][0] || NULL == items[i][1])
+        {
+            for (size_t j = 0; j <= i; j++)
+            {
+                free(items[j][0]);
+                free(items[j][1]);
+            }
+            free(samples);
+            return false;
+        }
+    }
+
+    for (uint64_t number = s->oldest; number < s->next; number++)
+    {
+        samples[number & mask] = *sample_at(s, number);
+    }
+    for (size_t i = 0; i < windows_count; i++)
+    {
+        deque_t *deques[2] = {&s->windows[i].min, &s->windows[i].max};
+        for (size_t j = 0; j < 2; j++)
+        {
+            for (uint64_t pos = deques[j]->front; pos < deques[j]->back; pos++)
+            {
+                items[i][j][pos & mask] = deques[j]->items[pos & (s->capacity - 1)];
+            }
+            free(deques[j]->items);
+            deques[j]->items = items[i][j];
+        }
+    }
+    free(s->samples);
+    s->samples = samples;
+    s->capacity = capacity;
+    return true;
+}
+
+static void series_free(series_t *s)
+{
+    for (size_t i = 0; i < AGGREGATES_WINDOWS_MAX; i++)
+    {
+        free(s->windows[i].min.items);
+        free(s->windows[i].max.items);
+    }
+    free(s->samples);
+    memset(s, 0, sizeof(*s));
+}
+
+/* Drop the samples that are out of all windows */
+static void series_expire(series_t *s, const int64_t now)
+{
+    uint64_t oldest = s->next;
+    for (size_t i = 0; i < windows_count; i++)
+    {
+        window_t *w = &s->windows[i];
+        const int64_t start = now - w->span;
+        while (w->first + 1 < s->next && sample_at(s, w->first + 1)->time <= start)
+        {
+            window_pop(s, w);
+            s->dirty = true;
+        }
+        oldest = w->first < oldest ? w->first : oldest;
+    }
+    s->oldest = oldest;
+}
+
+/* Set up the windows from the samples that are left, e.g. after the windows were changed */
+static bool series_init_windows(series_t *s)
+{
+    for (size_t i = 0; i < windows_count; i++)
+    {
+        window_t *w = &s->windows[i];
+        free(w->min.items);
+        free(w->max.items);
+        memset(w, 0, sizeof(*w));
+        w->span = (int64_t)windows_s[i] * 1000000000;
+        w->first = s->oldest;
+        w->min.front = w->min.back = s->oldest;
+        w->max.front = w->max.back = s->oldest;
+        w->min.items = malloc(s->capacity * sizeof(uint64_t));
+        w->max.items = malloc(s->capacity * sizeof(uint64_t));
+        if (NULL == w->min.items || NULL == w->max.items)
+        {
+            return false;
+        }
+        for (uint64_t number = s->oldest; number < s->next; number++)
+        {
+            window_push(s, w, number);
+        }
+    }
+    for (size_t i = windows_count; i < AGGREGATES_WINDOWS_MAX; i++)
+    {
+        free(s->windows[i].min.items);
+        free(s->windows[i].max.items);
+        memset(&s->windows[i], 0, sizeof(window_t));
+    }
+    s->recompute = RECOMPUTE_INTERVAL;
+    s->dirty = true;
+    return true;
+}
+
+static bool series_init(series_t *s, const channel_t *channel)
+{
+    s->channel = channel;
+    s->capacity = SAMPLES_INITIAL;
+    s->samples = malloc(s->capacity * sizeof(sample_t));
+    if (NULL == s->samples || !series_init_windows(s))
+    {
+        series_free(s);
+        return false;
+    }
+    return true;
+}
+
+static void series_add(series_t *s, const int64_t time, const double value)
+{
+    if (s->next - s->oldest == s->capacity && (AGGREGATES_SAMPLES_MAX <= s->capacity || !series_grow(s)))
+    {
+        // Full, the oldest sample leaves the windows early
+        for (size_t i = 0; i < windows_count; i++)
+        {
+            if (s->windows[i].first == s->oldest)
+            {
+                window_pop(s, &s->windows[i]);
+            }
+        }
+        s->oldest++;
+    }
+
+    const uint64_t number = s->next++;
+    s->samples[number & (s->capacity - 1)] = (sample_t){time, value};
+    for (size_t i = 0; i < windows_count; i++)
+    {
+        window_push(s, &s->windows[i], number);
+    }
+    if (0 == --s->recompute)
+    {
+        for (size_t i = 0; i < windows_count; i++)
+        {
+            window_recompute(s, &s->windows[i]);
+        }
+        s->recompute = RECOMPUTE_INTERVAL;
+    }
+    series_expire(s, time);
+    s->dirty = true;
+}
+
+static UA_NodeId stat_node_id(const channel_t *channel, const size_t window, const size_t stat)
+{
+    return UA_NODEID_NUMERIC(
+        CHANNEL_NAMESPACE, AGGREGATES_NODEID_BASE + channel->index * 100 + window * AGGREGATES_STATS + stat);
+}
+
+/* E.g. "1h", "15min" or "90s" */
+static void format_window(char *buf, const size_t size, const uint32_t seconds)
+{
+    if (0 == seconds % 3600)
+    {
+        snprintf(buf, size, "%uh", seconds / 3600);
+    }
+    else if (0 == seconds % 60)
+    {
+        snprintf(buf, size, "%umin", seconds / 60);
+    }
+    else
+    {
+        snprintf(buf, size, "%us", seconds);
+    }
+}
+
+static void add_series_nodes(UA_Server *server, const series_t *s)
+{
+    for (size_t i = 0; i < windows_count; i++)
+    {
+        char window[16];
+        format_window(window, sizeof(window), windows_s[i]);
+        for (size_t stat = 0; stat < AGGREGATES_STATS; stat++)
+        {
+            char label[32];
+            snprintf(label, sizeof(label), "%s %s", stat_names[stat], window);
+
+            UA_VariableAttributes attr = UA_VariableAttributes_default;
+            attr.description = UA_LOCALIZEDTEXT("en-US", label);
+            attr.displayName = UA_LOCALIZEDTEXT("en-US", label);
+            attr.dataType = UA_TYPES[UA_TYPES_DOUBLE].typeId;
+            attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+            UA_StatusCode status = UA_Server_addVariableNode(
+                server,
+                stat_node_id(s->channel, i, stat),
+                s->channel->node_id,
+                UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                UA_QUALIFIEDNAME(CHANNEL_NAMESPACE, label),
+                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                attr,
+                NULL,
+                NULL);
+            if (UA_STATUSCODE_GOOD != status)
+            {
+                LOG_E(
+                    "%s/%s: Failed to add %s of %s (%s)",
+                    __FILE__,
+                    __FUNCTION__,
+                    label,
+                    s->channel->label,
+                    UA_StatusCode_name(status));
+            }
+        }
+    }
+}
+
+static void delete_series_nodes(UA_Server *server, const series_t *s, const size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        for (size_t stat = 0; stat < AGGREGATES_STATS; stat++)
+        {
+            (void)UA_Server_deleteNode(server, stat_node_id(s->channel, i, stat), true);
+        }
+    }
+}
+
+static void write_stat(UA_Server *server, const series_t *s, const size_t window, const size_t stat, UA_Double value)
+{
+    UA_Variant variant;
+    UA_Variant_setScalar(&variant, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
+    (void)UA_Server_writeValue(server, stat_node_id(s->channel, window, stat), variant);
+}
+
+static series_t *series_get(const channel_t *channel)
+{
+    assert(NULL != channel);
+    if (channel->slot >= series_size || NULL == series[channel->slot].channel)
+    {
+        return NULL;
+    }
+    return &series[channel->slot];
+}
+
+static void load_pending(void)
+{
+    pthread_mutex_lock(&pending_mutex);
+    memcpy(windows_s, pending_windows, sizeof(windows_s));
+    windows_count = pending_count;
+    pending_changed = false;
+    pthread_mutex_unlock(&pending_mutex);
+}
+
+/* Called from the GLib main loop, the windows are changed by the UA server thread */
+void aggregates_set_windows(const uint32_t *seconds, size_t count)
+{
+    assert(NULL != seconds || 0 == count);
+    assert(AGGREGATES_WINDOWS_MAX >= count);
+    pthread_mutex_lock(&pending_mutex);
+    memcpy(pending_windows, seconds, count * sizeof(uint32_t));
+    pending_count = count;
+    pending_changed = true;
+    pthread_mutex_unlock(&pending_mutex);
+}
+
+/* Start over for a new set of channels, must not be called while the UA server thread runs */
+void aggregates_reset(const channels_t *channels)
+{
+    assert(NULL != channels);
+    aggregates_cleanup();
+    load_pending();
+
+    // Room for the channels that are added while the server runs
+    series = calloc(channels->capacity, sizeof(series_t));
+    series_size = NULL != series ? channels->capacity : 0;
+    for (size_t i = 0; i < channels->size && i < series_size; i++)
+    {
+        aggregates_add_channel(&channels->slots[i]);
+    }
+}
+
+/* Apply new windows, called on the UA server thread */
+void aggregates_sync(UA_Server *server)
+{
+    pthread_mutex_lock(&pending_mutex);
+    const bool changed = pending_changed;
+    pthread_mutex_unlock(&pending_mutex);
+    if (!changed)
+    {
+        return;
+    }
+
+    const size_t old_count = windows_count;
+    load_pending();
+    for (size_t i = 0; i < series_size; i++)
+    {
+        series_t *s = &series[i];
+        if (NULL == s->channel)
+        {
+            continue;
+        }
+        delete_series_nodes(server, s, old_count);
+        if (!series_init_windows(s))
+        {
+            LOG_E("%s/%s: No memory for the aggregates of %s", __FILE__, __FUNCTION__, s->channel->label);
+            series_free(s);
+            continue;
+        }
+        add_series_nodes(server, s);
+    }
+    LOG_I("%s/%s: %zu aggregate windows per temperature sensor", __FILE__, __FUNCTION__, windows_count);
+}
+
+void aggregates_cleanup(void)
+{
+    for (size_t i = 0; i < series_size; i++)
+    {
+        series_free(&series[i]);
+    }
+    free(series);
+    series = NULL;
+    series_size = 0;
+}
+
+/* Start the series of a temperature channel, before its nodes are added */
+void aggregates_add_channel(const channel_t *channel)
+{
+    assert(NULL != channel);
+    if (CHANNEL_TEMP != channel->type || channel->slot >= series_size || NULL != series[channel->slot].channel)
+    {
+        return;
+    }
+    if (!series_init(&series[channel->slot], channel))
+    {
+        LOG_E("%s/%s: No memory for the aggregates of %s", __FILE__, __FUNCTION__, channel->label);
+    }
+}
+
+/* Delete the aggregate variables and samples of a channel that is gone, called on the UA server thread */
+void aggregates_remove_channel(UA_Server *server, const channel_t *channel)
+{
+    series_t *s = series_get(channel);
+    if (NULL == s)
+    {
+        return;
+    }
+    delete_series_nodes(server, s, windows_count);
+    series_free(s);
+}
+
+/* Add the aggregate variables below the node of a temperature channel */
+void aggregates_add_nodes(UA_Server *server, const channel_t *channel)
+{
+    const series_t *s = series_get(channel);
+    if (NULL != s)
+    {
+        add_series_nodes(server, s);
+    }
+}
+
+/* A new value of a temperature channel, called on the UA server thread */
+void aggregates_add(const channel_t *channel, int64_t mono_ns, double value)
+{
+    series_t *s = series_get(channel);
+    if (NULL != s && 0 < windows_count)
+    {
+        series_add(s, mono_ns, value);
+    }
+}
+
+/* Write the aggregates that changed, at most every AGGREGATES_PUBLISH_MS */
+void aggregates_publish(UA_Server *server, int64_t mono_ns)
+{
+    if (mono_ns - last_publish < (int64_t)AGGREGATES_PUBLISH_MS * 1000000)
+    {
+        return;
+    }
+    last_publish = mono_ns;
+
+    for (size_t i = 0; i < series_size; i++)
+    {
+        series_t *s = &series[i];
+        if (NULL == s->channel || s->next == s->oldest)
+        {
+            continue;
+        }
+        // Windows also move without new samples
+        series_expire(s, mono_ns);
+        if (!s->dirty)
+        {
+            continue;
+        }
+        for (size_t j = 0; j < windows_count; j++)
+        {
+            const window_t *w = &s->windows[j];
+            const double samples = (double)(s->next - w->first);
+            const double variance = 1.0 < samples ? fmax(w->m2, 0.0) / (samples - 1.0) : 0.0;
+            write_stat(server, s, j, STAT_MIN, sample_at(s, deque_front(s, &w->min))->value);
+            write_stat(server, s, j, STAT_MAX, sample_at(s, deque_front(s, &w->max))->value);
+            write_stat(server, s, j, STAT_MEAN, w->mean);
+            write_stat(server, s, j, STAT_STDDEV, sqrt(variance));
+        }
+        s->dirty = false;
+    }
+}
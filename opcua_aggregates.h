@@ -0,0 +1,52 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _OPCUA_AGGREGATES_H_
+#define _OPCUA_AGGREGATES_H_
+
+#include <open62541/server.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "opcua_channels.h"
+
+/* Max number of windows and samples kept per sensor, older samples shorten the windows */
+#define AGGREGATES_WINDOWS_MAX 8
+#define AGGREGATES_SAMPLES_MAX 65536
+
+/* Window length limit in seconds */
+#define AGGREGATES_WINDOW_MAX_S 86400
+
+/* How often the aggregate nodes are written */
+#define AGGREGATES_PUBLISH_MS 250
+
+/* Aggregate variable of window w of sensor i is AGGREGATES_NODEID_BASE + i * 100 + w * AGGREGATES_STATS + stat */
+#define AGGREGATES_NODEID_BASE 10000
+#define AGGREGATES_STATS 4
+
+void aggregates_set_windows(const uint32_t *seconds, size_t count);
+void aggregates_reset(const channels_t *channels);
+void aggregates_sync(UA_Server *server);
+void aggregates_cleanup(void);
+void aggregates_add_channel(const channel_t *channel);
+void aggregates_remove_channel(UA_Server *server, const channel_t *channel);
+void aggregates_add_nodes(UA_Server *server, const channel_t *channel);
+void aggregates_add(const channel_t *channel, int64_t mono_ns, double value);
+void aggregates_publish(UA_Server *server, int64_t mono_ns);
+
+#endif /* _OPCUA_AGGREGATES_H_ */
@@ -0,0 +1,536 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+
+#include "opcua_alarms.h"
+#include "opcua_common.h"
+
+/*
+ * An ExclusiveLevelAlarm condition per temperature sensor with limits. The
+ * level is tracked here, with hysteresis, and the condition is only changed
+ * and its event sent when the level changes. Without alarms and conditions in
+ * open62541 the level changes are only logged.
+ */
+
+typedef enum
+{
+    LEVEL_LOW_LOW,
+    LEVEL_LOW,
+    LEVEL_NORMAL,
+    LEVEL_HIGH,
+    LEVEL_HIGH_HIGH
+} level_t;
+
+typedef struct
+{
+    const char *name;
+    const char *text; // for the message
+    UA_UInt32 state_id; // state of the ExclusiveLimitStateMachineType
+    UA_UInt16 severity;
+} level_info_t;
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+static const level_info_t levels[] = {
+    [LEVEL_LOW_LOW] = {"LowLow", "below low low limit", UA_NS0ID_EXCLUSIVELIMITSTATEMACHINETYPE_LOWLOW, 800},
+    [LEVEL_LOW] = {"Low", "below low limit", UA_NS0ID_EXCLUSIVELIMITSTATEMACHINETYPE_LOW, 500},
+    [LEVEL_NORMAL] = {"Normal", "back within limits", 0, 100},
+    [LEVEL_HIGH] = {"High", "above high limit", UA_NS0ID_EXCLUSIVELIMITSTATEMACHINETYPE_HIGH, 500},
+    [LEVEL_HIGH_HIGH] = {"HighHigh", "above high high limit", UA_NS0ID_EXCLUSIVELIMITSTATEMACHINETYPE_HIGHHIGH, 800}};
+#else
+static const level_info_t levels[] = {
+    [LEVEL_LOW_LOW] = {"LowLow", "below low low limit", 0, 800},
+    [LEVEL_LOW] = {"Low", "below low limit", 0, 500},
+    [LEVEL_NORMAL] = {"Normal", "back within limits", 0, 100},
+    [LEVEL_HIGH] = {"High", "above high limit", 0, 500},
+    [LEVEL_HIGH_HIGH] = {"HighHigh", "above high high limit", 0, 800}};
+#endif
+
+typedef struct
+{
+    const channel_t *channel;
+    alarm_limits_t limits;
+    level_t level;
+    bool created; // the condition nodes exist
+    bool has_value;
+    double value; // last value, to check new limits against
+    UA_DateTime time;
+} sensor_t;
+
+/* Set from the GLib main loop, applied by the UA server thread in alarms_sync */
+static pthread_mutex_t pending_mutex = PTHREAD_MUTEX_INITIALIZER;
+static alarm_limits_t *pending_limits;
+static size_t pending_count;
+static bool pending_changed;
+
+/* Only touched by the UA server thread, or while it is not running */
+static alarm_limits_t *limits;
+static size_t limits_count;
+static sensor_t *sensors; // indexed by channel slot, only temperature channels are used
+static size_t sensors_size;
+
+static bool has_limits(const alarm_limits_t *l)
+{
+    return !isnan(l->low_low) || !isnan(l->low) || !isnan(l->high) || !isnan(l->high_high);
+}
+
+/* Sensors past the end of the limits use the last ones */
+static alarm_limits_t limits_for(const uint32_t index)
+{
+    if (0 == limits_count)
+    {
+        return (alarm_limits_t){NAN, NAN, NAN, NAN, 0.0};
+    }
+    return limits[MIN(index, limits_count - 1)];
+}
+
+/* A limit that is crossed, or still within the hysteresis of one that was crossed */
+static bool beyond_high(const double limit, const double hysteresis, const bool was_beyond, const double value)
+{
+    return !isnan(limit) && (value >= limit || (was_beyond && value > limit - hysteresis));
+}
+
+static bool beyond_low(const double limit, const double hysteresis, const bool was_beyond, const double value)
+{
+    return !isnan(limit) && (value <= limit || (was_beyond && value < limit + hysteresis));
+}
+
+static level_t next_level(const alarm_limits_t *l, const level_t current, const double value)
+{
+    if (beyond_high(l->high_high, l->hysteresis, LEVEL_HIGH_HIGH == current, value))
+    {
+        return LEVEL_HIGH_HIGH;
+    }
+    if (beyond_high(l->high, l->hysteresis, LEVEL_HIGH <= current, value))
+    {
+        return LEVEL_HIGH;
+    }
+    if (beyond_low(l->low_low, l->hysteresis, LEVEL_LOW_LOW == current, value))
+    {
+        return LEVEL_LOW_LOW;
+    }
+    if (beyond_low(l->low, l->hysteresis, LEVEL_LOW >= current, value))
+    {
+        return LEVEL_LOW;
+    }
+    return LEVEL_NORMAL;
+}
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+static UA_NodeId condition_id(const channel_t *channel)
+{
+    return UA_NODEID_NUMERIC(CHANNEL_NAMESPACE, ALARMS_NODEID_BASE + channel->index);
+}
+
+static void set_field(UA_Server *server, const sensor_t *s, const char *field, void *value, const UA_DataType *type)
+{
+    UA_Variant variant;
+    UA_Variant_setScalar(&variant, value, type);
+    UA_StatusCode status =
+        UA_Server_setConditionField(server, condition_id(s->channel), &variant, UA_QUALIFIEDNAME(0, (char *)field));
+    if (UA_STATUSCODE_GOOD != status)
+    {
+        LOG_E(
+            "%s/%s: Failed to set %s of %s (%s)",
+            __FILE__,
+            __FUNCTION__,
+            field,
+            s->channel->label,
+            UA_StatusCode_name(status));
+    }
+}
+
+/* The Id of a two state variable, e.g. ActiveState */
+static void set_state_id(UA_Server *server, const sensor_t *s, const char *field, UA_Boolean id)
+{
+    UA_Variant variant;
+    UA_Variant_setScalar(&variant, &id, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    UA_StatusCode status = UA_Server_setConditionVariableFieldProperty(
+        server, condition_id(s->channel), &variant, UA_QUALIFIEDNAME(0, (char *)field), UA_QUALIFIEDNAME(0, "Id"));
+    if (UA_STATUSCODE_GOOD != status)
+    {
+        LOG_E(
+            "%s/%s: Failed to set %s of %s (%s)",
+            __FILE__,
+            __FUNCTION__,
+            field,
+            s->channel->label,
+            UA_StatusCode_name(status));
+    }
+}
+
+static void set_state(UA_Server *server, const sensor_t *s, const char *field, const bool id, const char *text)
+{
+    UA_LocalizedText name = UA_LOCALIZEDTEXT("en-US", (char *)text);
+    set_field(server, s, field, &name, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    set_state_id(server, s, field, id);
+}
+
+static void set_limit(UA_Server *server, const sensor_t *s, const char *field, double limit)
+{
+    if (isnan(limit))
+    {
+        return;
+    }
+    UA_StatusCode status = UA_Server_addConditionOptionalField(
+        server,
+        condition_id(s->channel),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_EXCLUSIVELEVELALARMTYPE),
+        UA_QUALIFIEDNAME(0, (char *)field),
+        NULL);
+    if (UA_STATUSCODE_GOOD != status)
+    {
+        LOG_E(
+            "%s/%s: Failed to add %s of %s (%s)",
+            __FILE__,
+            __FUNCTION__,
+            field,
+            s->channel->label,
+            UA_StatusCode_name(status));
+        return;
+    }
+    set_field(server, s, field, &limit, &UA_TYPES[UA_TYPES_DOUBLE]);
+}
+
+/* The current state of the LimitState sub state machine, which is two levels below the condition */
+static void set_limit_state(UA_Server *server, const sensor_t *s)
+{
+    UA_QualifiedName path[3] = {
+        UA_QUALIFIEDNAME(0, "LimitState"), UA_QUALIFIEDNAME(0, "CurrentState"), UA_QUALIFIEDNAME(0, "Id")};
+    UA_LocalizedText name = UA_LOCALIZEDTEXT("en-US", (char *)levels[s->level].name);
+    UA_NodeId id = UA_NODEID_NUMERIC(0, levels[s->level].state_id);
+    UA_Variant values[2];
+    UA_Variant_setScalar(&values[0], &name, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    UA_Variant_setScalar(&values[1], &id, &UA_TYPES[UA_TYPES_NODEID]);
+
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+    {
+        UA_BrowsePathResult result =
+            UA_Server_browseSimplifiedBrowsePath(server, condition_id(s->channel), i + 2, path);
+        if (UA_STATUSCODE_GOOD == result.statusCode && 0 < result.targetsSize)
+        {
+            (void)UA_Server_writeValue(server, result.targets[0].targetId.nodeId, values[i]);
+        }
+        UA_BrowsePathResult_clear(&result);
+    }
+}
+
+static bool add_condition(UA_Server *server, const sensor_t *s)
+{
+    // The events of a condition reach the subscribers of the Server object through its source
+    UA_StatusCode status = UA_Server_addReference(
+        server,
+        UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_HASEVENTSOURCE),
+        UA_EXPANDEDNODEID_NODEID(s->channel->node_id),
+        true);
+    // Already there when the condition is added again with new limits
+    if (UA_STATUSCODE_GOOD != status && UA_STATUSCODE_BADDUPLICATEREFERENCENOTALLOWED != status)
+    {
+        LOG_E(
+            "%s/%s: Failed to make %s an event source (%s)",
+            __FILE__,
+            __FUNCTION__,
+            s->channel->label,
+            UA_StatusCode_name(status));
+        return false;
+    }
+
+    UA_NodeId id;
+    status = UA_Server_createCondition(
+        server,
+        condition_id(s->channel),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_EXCLUSIVELEVELALARMTYPE),
+        UA_QUALIFIEDNAME(CHANNEL_NAMESPACE, "limit alarm"),
+        s->channel->node_id,
+        UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+        &id);
+    if (UA_STATUSCODE_GOOD != status)
+    {
+        LOG_E(
+            "%s/%s: Failed to add the limit alarm of %s (%s)",
+            __FILE__,
+            __FUNCTION__,
+            s->channel->label,
+            UA_StatusCode_name(status));
+        return false;
+    }
+
+    UA_String condition_name = UA_STRING("limit alarm");
+    UA_String source_name = UA_STRING((char *)s->channel->label);
+    UA_Boolean retain = false;
+    set_field(server, s, "ConditionName", &condition_name, &UA_TYPES[UA_TYPES_STRING]);
+    set_field(server, s, "SourceName", &source_name, &UA_TYPES[UA_TYPES_STRING]);
+    set_field(server, s, "Retain", &retain, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    set_limit(server, s, "LowLowLimit", s->limits.low_low);
+    set_limit(server, s, "LowLimit", s->limits.low);
+    set_limit(server, s, "HighLimit", s->limits.high);
+    set_limit(server, s, "HighHighLimit", s->limits.high_high);
+    set_state(server, s, "EnabledState", true, "Enabled");
+    set_state(server, s, "ActiveState", false, "Inactive");
+    set_state(server, s, "AckedState", true, "Acknowledged");
+    return true;
+}
+
+/* Change the condition to the sensor's level and send its event */
+static void report_level(UA_Server *server, const sensor_t *s)
+{
+    const bool active = LEVEL_NORMAL != s->level;
+    char text[96];
+    snprintf(text, sizeof(text), "%s %s at %.1f", s->channel->label, levels[s->level].text, s->value);
+    UA_LocalizedText message = UA_LOCALIZEDTEXT("en-US", text);
+    UA_UInt16 severity = levels[s->level].severity;
+    UA_DateTime time = s->time;
+    UA_Boolean retain = active;
+
+    set_field(server, s, "Message", &message, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    set_field(server, s, "Severity", &severity, &UA_TYPES[UA_TYPES_UINT16]);
+    set_field(server, s, "Time", &time, &UA_TYPES[UA_TYPES_DATETIME]);
+    set_field(server, s, "Retain", &retain, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    set_state(server, s, "ActiveState", active, active ? "Active" : "Inactive");
+    if (active)
+    {
+        set_limit_state(server, s);
+        set_state(server, s, "AckedState", false, "Unacknowledged");
+    }
+
+    UA_StatusCode status = UA_Server_triggerConditionEvent(server, condition_id(s->channel), s->channel->node_id, NULL);
+    if (UA_STATUSCODE_GOOD != status)
+    {
+        LOG_E(
+            "%s/%s: Failed to send the limit alarm of %s (%s)",
+            __FILE__,
+            __FUNCTION__,
+            s->channel->label,
+            UA_StatusCode_name(status));
+    }
+}
+#endif
+
+static void update_level(UA_Server *server, sensor_t *s)
+{
+    const level_t level = next_level(&s->limits, s->level, s->value);
+    if (level == s->level)
+    {
+        return;
+    }
+    s->level = level;
+    LOG_I("%s/%s: %s %s at %.1f", __FILE__, __FUNCTION__, s->channel->label, levels[level].text, s->value);
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+    if (s->created)
+    {
+        report_level(server, s);
+    }
+#else
+    (void)server;
+#endif
+}
+
+static sensor_t *sensor_get(const channel_t *channel)
+{
+    assert(NULL != channel);
+    if (channel->slot >= sensors_size || NULL == sensors[channel->slot].channel)
+    {
+        return NULL;
+    }
+    return &sensors[channel->slot];
+}
+
+static void load_pending(void)
+{
+    pthread_mutex_lock(&pending_mutex);
+    free(limits);
+    limits = NULL;
+    limits_count = 0;
+    if (0 < pending_count)
+    {
+        limits = malloc(pending_count * sizeof(alarm_limits_t));
+        if (NULL != limits)
+        {
+            memcpy(limits, pending_limits, pending_count * sizeof(alarm_limits_t));
+            limits_count = pending_count;
+        }
+    }
+    pending_changed = false;
+    pthread_mutex_unlock(&pending_mutex);
+}
+
+/* Called from the GLib main loop, limits of the sensors from 0, the last ones apply to the rest */
+void alarms_set_limits(const alarm_limits_t *new_limits, size_t count)
+{
+    assert(NULL != new_limits || 0 == count);
+    alarm_limits_t *copy = NULL;
+    if (0 < count)
+    {
+        copy = malloc(count * sizeof(alarm_limits_t));
+        if (NULL == copy)
+        {
+            LOG_E("%s/%s: No memory for %zu alarm limits", __FILE__, __FUNCTION__, count);
+            return;
+        }
+        memcpy(copy, new_limits, count * sizeof(alarm_limits_t));
+    }
+#ifndef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+    if (0 < count)
+    {
+        LOG_W(
+            "%s/%s: open62541 is built without alarms and conditions, limits are only logged", __FILE__, __FUNCTION__);
+    }
+#endif
+    pthread_mutex_lock(&pending_mutex);
+    free(pending_limits);
+    pending_limits = copy;
+    pending_count = count;
+    pending_changed = true;
+    pthread_mutex_unlock(&pending_mutex);
+}
+
+/* Start over for a new set of channels, must not be called while the UA server thread runs */
+void alarms_reset(const channels_t *channels)
+{
+    assert(NULL != channels);
+    alarms_cleanup();
+    load_pending();
+
+    // Room for the channels that are added while the server runs
+    sensors = calloc(channels->capacity, sizeof(sensor_t));
+    sensors_size = NULL != sensors ? channels->capacity : 0;
+    for (size_t i = 0; i < channels->size && i < sensors_size; i++)
+    {
+        alarms_add_channel(&channels->slots[i]);
+    }
+}
+
+/* Apply new limits to the conditions, called on the UA server thread */
+void alarms_sync(UA_Server *server)
+{
+    pthread_mutex_lock(&pending_mutex);
+    const bool changed = pending_changed;
+    pthread_mutex_unlock(&pending_mutex);
+    if (!changed)
+    {
+        return;
+    }
+
+    load_pending();
+    for (size_t i = 0; i < sensors_size; i++)
+    {
+        sensor_t *s = &sensors[i];
+        const alarm_limits_t l = NULL != s->channel ? limits_for(s->channel->index) : s->limits;
+        if (NULL == s->channel || 0 == memcmp(&l, &s->limits, sizeof(l)))
+        {
+            continue;
+        }
+
+        // A condition with other limits is added again, and its event sent if the level is not normal
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+        if (s->created)
+        {
+            (void)UA_Server_deleteCondition(server, condition_id(s->channel), s->channel->node_id);
+        }
+        s->limits = l;
+        s->level = LEVEL_NORMAL;
+        s->created = has_limits(&l) && add_condition(server, s);
+#else
+        s->limits = l;
+        s->level = LEVEL_NORMAL;
+#endif
+        if (s->has_value)
+        {
+            update_level(server, s);
+        }
+    }
+    LOG_I("%s/%s: Alarm limits for %zu temperature sensors", __FILE__, __FUNCTION__, limits_count);
+}
+
+void alarms_cleanup(void)
+{
+    free(sensors);
+    sensors = NULL;
+    sensors_size = 0;
+}
+
+/* Watch the limits of a temperature channel, before its nodes are added */
+void alarms_add_channel(const channel_t *channel)
+{
+    assert(NULL != channel);
+    if (CHANNEL_TEMP != channel->type || channel->slot >= sensors_size)
+    {
+        return;
+    }
+    sensor_t *s = &sensors[channel->slot];
+    memset(s, 0, sizeof(*s));
+    s->channel = channel;
+    s->limits = limits_for(channel->index);
+    s->level = LEVEL_NORMAL;
+}
+
+/* Delete the limit alarm of a channel that is gone, called on the UA server thread */
+void alarms_remove_channel(UA_Server *server, const channel_t *channel)
+{
+    sensor_t *s = sensor_get(channel);
+    if (NULL == s)
+    {
+        return;
+    }
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+    if (s->created)
+    {
+        (void)UA_Server_deleteCondition(server, condition_id(s->channel), s->channel->node_id);
+    }
+#else
+    (void)server;
+#endif
+    memset(s, 0, sizeof(*s));
+}
+
+/* Add the limit alarm below the node of a temperature channel, if it has limits */
+void alarms_add_nodes(UA_Server *server, const channel_t *channel)
+{
+    sensor_t *s = sensor_get(channel);
+    if (NULL == s || !has_limits(&s->limits))
+    {
+        return;
+    }
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+    s->created = add_condition(server, s) || s->created;
+#else
+    (void)server;
+#endif
+}
+
+/* A new value of a temperature channel, called on the UA server thread */
+void alarms_check(UA_Server *server, const channel_t *channel, double value, UA_DateTime time)
+{
+    sensor_t *s = sensor_get(channel);
+    if (NULL == s)
+    {
+        return;
+    }
+    s->value = value;
+    s->time = time;
+    s->has_value = true;
+    if (has_limits(&s->limits))
+    {
+        update_level(server, s);
+    }
+}
@@ -0,0 +1,49 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _OPCUA_ALARMS_H_
+#define _OPCUA_ALARMS_H_
+
+#include <open62541/server.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "opcua_channels.h"
+
+/* Condition of temperature sensor i is ALARMS_NODEID_BASE + i */
+#define ALARMS_NODEID_BASE 4000
+
+/* Limits of one temperature sensor in °C, NAN for none */
+typedef struct
+{
+    double low_low;
+    double low;
+    double high;
+    double high_high;
+    double hysteresis; // a limit is left when the value is this far back from it
+} alarm_limits_t;
+
+void alarms_set_limits(const alarm_limits_t *limits, size_t count);
+void alarms_reset(const channels_t *channels);
+void alarms_sync(UA_Server *server);
+void alarms_cleanup(void);
+void alarms_add_channel(const channel_t *channel);
+void alarms_remove_channel(UA_Server *server, const channel_t *channel);
+void alarms_add_nodes(UA_Server *server, const channel_t *channel);
+void alarms_check(UA_Server *server, const channel_t *channel, double value, UA_DateTime time);
+
+#endif /* _OPCUA_ALARMS_H_ */
@@ -0,0 +1,223 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "opcua_channels.h"
+
+void channels_init(channels_t *channels, const size_t capacity)
+{
+    assert(NULL != channels);
+    channels->size = 0;
+    channels->capacity = capacity;
+    channels->slots = calloc(capacity, sizeof(channel_t));
+    for (int i = 0; i < CHANNEL_TYPES; i++)
+    {
+        channels->subids[i].size = 0;
+        channels->subids[i].slot = NULL;
+        channels->subids[i].sparse = NULL;
+    }
+}
+
+void channels_free(channels_t *channels)
+{
+    if (NULL != channels)
+    {
+        for (int i = 0; i < CHANNEL_TYPES; i++)
+        {
+            free(channels->subids[i].slot);
+            channels->subids[i].slot = NULL;
+            channels->subids[i].size = 0;
+            if (NULL != channels->subids[i].sparse)
+            {
+                g_hash_table_destroy(channels->subids[i].sparse);
+                channels->subids[i].sparse = NULL;
+            }
+        }
+        free(channels->slots);
+        channels->slots = NULL;
+        channels->size = 0;
+        channels->capacity = 0;
+    }
+}
+
+channel_t *channels_add(channels_t *channels, const channel_type_t type, const uint32_t index)
+{
+    assert(NULL != channels);
+    assert(NULL != channels->slots);
+    assert(CHANNEL_TYPES > type);
+
+    // A channel that was removed comes back in its old slot
+    channel_t *channel = channels_find(channels, type, index);
+    if (NULL != channel)
+    {
+        if (!channel->removed)
+        {
+            return NULL;
+        }
+        channel->removed = false;
+        return channel;
+    }
+
+    if (channels->size >= channels->capacity || CHANNELS_MAX_PER_TYPE <= index)
+    {
+        return NULL;
+    }
+
+    channel = &channels->slots[channels->size];
+    channel->type = type;
+    channel->index = index;
+    channel->slot = channels->size;
+    channel->subscribed = false;
+    channel->output = false;
+    channel->removed = false;
+    if (CHANNEL_TEMP == type)
+    {
+        snprintf(channel->label, CHANNEL_LABEL_LEN, TEMP_LABEL_FMT, index);
+        channel->node_id = UA_NODEID_NUMERIC(CHANNEL_NAMESPACE, CHANNEL_NODEID_TEMP_BASE + index);
+    }
+    else
+    {
+        snprintf(channel->label, CHANNEL_LABEL_LEN, PORT_LABEL_FMT, index);
+        channel->node_id = UA_NODEID_NUMERIC(CHANNEL_NAMESPACE, CHANNEL_NODEID_PORT_BASE + index);
+    }
+    channels->size++;
+    return channel;
+}
+
+channel_t *channels_find(const channels_t *channels, const channel_type_t type, const uint32_t index)
+{
+    assert(NULL != channels);
+    for (size_t i = 0; i < channels->size; i++)
+    {
+        if (type == channels->slots[i].type && index == channels->slots[i].index)
+        {
+            return &channels->slots[i];
+        }
+    }
+    return NULL;
+}
+
+/* Slot + 1 of an id beyond the table, 0 if it is not mapped */
+static uint32_t sparse_lookup(GHashTable *sparse, const uint32_t subscription_id)
+{
+    if (NULL == sparse)
+    {
+        return 0;
+    }
+    const gpointer slot = g_hash_table_lookup(sparse, GUINT_TO_POINTER(subscription_id));
+    return GPOINTER_TO_UINT(slot);
+}
+
+/* Drop the mapping of the channel's subscription id, unless another channel has taken the id */
+static void unmap_subscription(channels_t *channels, const channel_t *channel)
+{
+    if (!channel->subscribed)
+    {
+        return;
+    }
+    uint32_t *map = channels->subids[channel->type].slot;
+    GHashTable *sparse = channels->subids[channel->type].sparse;
+    if (channel->subid < channels->subids[channel->type].size)
+    {
+        if (channel->slot + 1 == map[channel->subid])
+        {
+            map[channel->subid] = 0;
+        }
+    }
+    else if (channel->slot + 1 == sparse_lookup(sparse, channel->subid))
+    {
+        (void)g_hash_table_remove(sparse, GUINT_TO_POINTER(channel->subid));
+    }
+}
+
+/* Drop the channel's subscription id, so that its signals are no longer delivered */
+void channels_remove(channels_t *channels, channel_t *channel)
+{
+    assert(NULL != channels);
+    assert(NULL != channel);
+
+    unmap_subscription(channels, channel);
+    channel->subscribed = false;
+    channel->removed = true;
+}
+
+bool channels_set_subscription(channels_t *channels, channel_t *channel, const uint32_t subscription_id)
+{
+    assert(NULL != channels);
+    assert(NULL != channel);
+
+    // Ids beyond the table are hashed, so that a few large ids do not blow up the table
+    if (CHANNELS_DIRECT_SUBIDS <= subscription_id)
+    {
+        GHashTable **sparse = &channels->subids[channel->type].sparse;
+        if (NULL == *sparse)
+        {
+            *sparse = g_hash_table_new(g_direct_hash, g_direct_equal);
+        }
+        unmap_subscription(channels, channel);
+        g_hash_table_insert(*sparse, GUINT_TO_POINTER(subscription_id), GUINT_TO_POINTER(channel->slot + 1));
+        channel->subid = subscription_id;
+        channel->subscribed = true;
+        return true;
+    }
+
+    // Grow the lookup table to cover the new id, lookups stay a plain index
+    uint32_t **map = &channels->subids[channel->type].slot;
+    size_t *map_size = &channels->subids[channel->type].size;
+    if (subscription_id >= *map_size)
+    {
+        size_t new_size = 0 < *map_size ? *map_size : 16;
+        while (subscription_id >= new_size)
+        {
+            new_size *= 2;
+        }
+        uint32_t *new_map = realloc(*map, new_size * sizeof(uint32_t));
+        if (NULL == new_map)
+        {
+            return false;
+        }
+        for (size_t i = *map_size; i < new_size; i++)
+        {
+            new_map[i] = 0;
+        }
+        *map = new_map;
+        *map_size = new_size;
+    }
+
+    // Drop the mapping of a previous subscription for this channel
+    unmap_subscription(channels, channel);
+
+    (*map)[subscription_id] = channel->slot + 1;
+    channel->subid = subscription_id;
+    channel->subscribed = true;
+    return true;
+}
+
+channel_t *channels_get_from_subscription(
+    const channels_t *channels,
+    const channel_type_t type,
+    const uint32_t subscription_id)
+{
+    assert(NULL != channels);
+    assert(CHANNEL_TYPES > type);
+
+    const uint32_t slot = subscription_id < channels->subids[type].size
+                              ? channels->subids[type].slot[subscription_id]
+                              : sparse_lookup(channels->subids[type].sparse, subscription_id);
+    return 0 < slot ? &channels->slots[slot - 1] : NULL;
+}
@@ -0,0 +1,92 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _OPCUA_CHANNELS_H_
+#define _OPCUA_CHANNELS_H_
+
+#include <glib.h>
+#include <open62541/types.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define CHANNEL_LABEL_LEN 16
+#define TEMP_LABEL_FMT "temperature %u"
+#define PORT_LABEL_FMT "port %u"
+
+/* Numeric node ids in namespace 1: temperature sensor i is 1000+i, port i is 2000+i */
+#define CHANNEL_NAMESPACE 1
+#define CHANNEL_NODEID_TEMP_BASE 1000
+#define CHANNEL_NODEID_PORT_BASE 2000
+#define CHANNELS_MAX_PER_TYPE 1000
+
+/* Subscription ids below this are looked up in a table, larger ones in a hash table */
+#define CHANNELS_DIRECT_SUBIDS 65536
+
+typedef enum
+{
+    CHANNEL_TEMP,
+    CHANNEL_PORT,
+    CHANNEL_TYPES
+} channel_type_t;
+
+/* One temperature sensor or IO port and its node in the UA server */
+typedef struct
+{
+    channel_type_t type;
+    uint32_t index; // sensor or port number on the device
+    uint32_t slot;  // position in the registry
+    uint32_t subid;
+    bool subscribed;
+    bool output;  // output port, set by clients
+    bool removed; // gone from the device, the slot is kept for when it comes back
+    UA_NodeId node_id;
+    char label[CHANNEL_LABEL_LEN];
+} channel_t;
+
+/*
+ * All channels live in one contiguous array that is allocated once, so that
+ * channel pointers stay valid for the registry's lifetime. Subscription ids
+ * map directly to slots through one table per channel type, and the rare ids
+ * beyond CHANNELS_DIRECT_SUBIDS through a hash table. A removed channel keeps
+ * its slot, and gets it back when it is added again.
+ */
+typedef struct
+{
+    size_t size;
+    size_t capacity;
+    channel_t *slots;
+    struct
+    {
+        size_t size;
+        uint32_t *slot;     // slot + 1, 0 means unused
+        GHashTable *sparse; // slot + 1 by id, created for the first id beyond the table
+    } subids[CHANNEL_TYPES];
+} channels_t;
+
+void channels_init(channels_t *channels, const size_t capacity);
+void channels_free(channels_t *channels);
+channel_t *channels_add(channels_t *channels, const channel_type_t type, const uint32_t index);
+channel_t *channels_find(const channels_t *channels, const channel_type_t type, const uint32_t index);
+void channels_remove(channels_t *channels, channel_t *channel);
+bool channels_set_subscription(channels_t *channels, channel_t *channel, const uint32_t subscription_id);
+channel_t *channels_get_from_subscription(
+    const channels_t *channels,
+    const channel_type_t type,
+    const uint32_t subscription_id);
+
+#endif /* _OPCUA_CHANNELS_H_ */
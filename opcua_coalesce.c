@@ -0,0 +1,218 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "opcua_coalesce.h"
+#include "opcua_common.h"
+#include "opcua_diagnostics.h"
+#include "opcua_open62541.h"
+
+/* Delay before retrying a value that did not fit in the update queue */
+#define COALESCE_RETRY_MS 10
+
+/*
+ * Everything in here runs on the GLib main loop, i.e. the same thread as the
+ * D-Bus signal handlers, so the per-node state needs no locking.
+ */
+
+typedef struct
+{
+    const channel_t *channel;
+    gint64 last_sent; // monotonic time in us of the last forwarded value
+    bool has_sent;
+    bool has_pending;
+    guint timer_id;
+    guint min_interval_ms; // per node window, the larger of this and the global window is used
+    update_time_t received; // when the pending value arrived
+    union
+    {
+        double temp;
+        bool state;
+    } sent, pending;
+} node_t;
+
+static node_t *nodes = NULL; // indexed by channel slot
+static size_t nodes_size = 0;
+static guint window_ms = 0;
+static bool port_edges = false;
+
+static node_t *node_get(const channel_t *channel)
+{
+    assert(NULL != channel);
+    assert(channel->slot < nodes_size);
+
+    node_t *node = &nodes[channel->slot];
+    node->channel = channel;
+    return node;
+}
+
+static bool node_pending_is_sent(const node_t *node)
+{
+    if (!node->has_sent)
+    {
+        return false;
+    }
+    if (CHANNEL_TEMP == node->channel->type)
+    {
+        return node->pending.temp == node->sent.temp;
+    }
+    return node->pending.state == node->sent.state;
+}
+
+static gboolean on_window_end(gpointer user_data);
+
+static void node_forward(node_t *node, const gint64 now)
+{
+    bool queued;
+
+    if (node_pending_is_sent(node))
+    {
+        // Nothing changed since the last value we passed on
+        node->has_pending = false;
+        return;
+    }
+
+    if (CHANNEL_TEMP == node->channel->type)
+    {
+        queued = ua_server_update_temp(node->channel, node->pending.temp, &node->received);
+    }
+    else
+    {
+        queued = ua_server_update_port(node->channel, node->pending.state, &node->received);
+    }
+    if (!queued)
+    {
+        // Keep the value pending so that it is not lost when the queue is full
+        node->has_pending = true;
+        if (0 == node->timer_id)
+        {
+            node->timer_id = g_timeout_add(COALESCE_RETRY_MS, on_window_end, node);
+        }
+        return;
+    }
+    node->sent = node->pending;
+    node->has_sent = true;
+    node->has_pending = false;
+    node->last_sent = now;
+    diagnostics_count(DIAG_UPDATES_FORWARDED);
+}
+
+static gboolean on_window_end(gpointer user_data)
+{
+    node_t *node = user_data;
+    node->timer_id = 0;
+    if (node->has_pending)
+    {
+        node_forward(node, g_get_monotonic_time());
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static void node_update(node_t *node)
+{
+    const gint64 now = g_get_monotonic_time();
+    const gint64 window = (gint64)MAX(window_ms, node->min_interval_ms) * 1000;
+
+    // In edge mode every port transition goes straight through
+    const bool is_edge = port_edges && CHANNEL_PORT == node->channel->type && !node_pending_is_sent(node);
+
+    if (0 == window || is_edge || !node->has_sent || now - node->last_sent >= window)
+    {
+        g_clear_handle_id(&node->timer_id, g_source_remove);
+        node_forward(node, now);
+        return;
+    }
+
+    // Within the window: last value wins, flushed when the window ends
+    if (node->has_pending)
+    {
+        diagnostics_count(DIAG_UPDATES_COALESCED);
+    }
+    node->has_pending = true;
+    if (0 == node->timer_id)
+    {
+        const guint remaining = (guint)((node->last_sent + window - now + 999) / 1000);
+        node->timer_id = g_timeout_add(remaining, on_window_end, node);
+    }
+}
+
+void coalesce_reset(const size_t capacity)
+{
+    coalesce_cleanup();
+    nodes = g_new0(node_t, capacity);
+    nodes_size = capacity;
+}
+
+void coalesce_cleanup(void)
+{
+    for (size_t i = 0; i < nodes_size; i++)
+    {
+        g_clear_handle_id(&nodes[i].timer_id, g_source_remove);
+    }
+    g_free(nodes);
+    nodes = NULL;
+    nodes_size = 0;
+}
+
+void coalesce_set_window(guint window)
+{
+    window_ms = window;
+}
+
+void coalesce_set_port_edges(bool edges)
+{
+    port_edges = edges;
+}
+
+void coalesce_set_min_interval(const channel_t *channel, guint interval_ms)
+{
+    node_get(channel)->min_interval_ms = interval_ms;
+}
+
+/* Forget a channel that is gone, along with its pending value */
+void coalesce_remove(const channel_t *channel)
+{
+    node_t *node = node_get(channel);
+    g_clear_handle_id(&node->timer_id, g_source_remove);
+    memset(node, 0, sizeof(*node));
+}
+
+void coalesce_temp(const channel_t *channel, double value, const update_time_t *received)
+{
+    assert(NULL != received);
+    node_t *node = node_get(channel);
+    node->pending.temp = value;
+    node->received = *received;
+    node_update(node);
+}
+
+void coalesce_port(const channel_t *channel, bool state, const update_time_t *received)
+{
+    assert(NULL != received);
+    node_t *node = node_get(channel);
+    node->pending.state = state;
+    node->received = *received;
+    node_update(node);
+}
+
+void coalesce_get_stats(coalesce_stats_t *out)
+{
+    assert(NULL != out);
+    out->forwarded = diagnostics_get(DIAG_UPDATES_FORWARDED);
+    out->coalesced = diagnostics_get(DIAG_UPDATES_COALESCED);
+}
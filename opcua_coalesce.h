@@ -0,0 +1,44 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _OPCUA_COALESCE_H_
+#define _OPCUA_COALESCE_H_
+
+#include <glib.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "opcua_channels.h"
+#include "opcua_updates.h"
+
+typedef struct
+{
+    uint64_t forwarded;
+    uint64_t coalesced;
+} coalesce_stats_t;
+
+void coalesce_reset(const size_t capacity);
+void coalesce_cleanup(void);
+void coalesce_set_window(guint window_ms);
+void coalesce_set_port_edges(bool port_edges);
+void coalesce_set_min_interval(const channel_t *channel, guint interval_ms);
+void coalesce_remove(const channel_t *channel);
+void coalesce_temp(const channel_t *channel, double value, const update_time_t *received);
+void coalesce_port(const channel_t *channel, bool state, const update_time_t *received);
+void coalesce_get_stats(coalesce_stats_t *stats);
+
+#endif /* _OPCUA_COALESCE_H_ */
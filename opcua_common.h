@@ -20,10 +20,24 @@
 #include <stdio.h>
 #include <syslog.h>
 
+#include "opcua_log.h"
+
+/* Log levels above this are compiled out, e.g. -DLOG_COMPILED_LEVEL=LOG_DEBUG to keep debug messages */
+#ifndef LOG_COMPILED_LEVEL
+#define LOG_COMPILED_LEVEL LOG_INFO
+#endif
+
 // clang-format off
-#define LOG(type, fmt, args...) { syslog(type, fmt, ##args); printf(fmt, ##args); printf("\n"); }
+#define LOG(type, fmt, args...) { static log_site_t log_site_; log_write(&log_site_, type, fmt, ##args); }
 #define LOG_I(fmt, args...) { LOG(LOG_INFO, fmt, ##args) }
+#define LOG_W(fmt, args...) { LOG(LOG_WARNING, fmt, ##args) }
 #define LOG_E(fmt, args...) { LOG(LOG_ERR, fmt, ##args) }
+#if LOG_COMPILED_LEVEL >= LOG_DEBUG
+#define LOG_D(fmt, args...) { LOG(LOG_DEBUG, fmt, ##args) }
+#else
+/* Still type checks the arguments but generates no code */
+#define LOG_D(fmt, args...) { if (0) { printf(fmt, ##args); } }
+#endif
 // clang-format on
 
 #endif /* _OPCUA_COMMON_H_ */
@@ -19,7 +19,8 @@
 #include "opcua_common.h"
 #include "opcua_dbus.h"
 
-#define NO_TIMEOUT -1
+/* Max time to wait for a reply, so that a hung service cannot block us forever */
+#define CALL_TIMEOUT_MS 5000
 #define TEMP_DBUS_SERVICE "com.axis.TemperatureController"
 #define TEMP_DBUS_OBJECT "/com/axis/TemperatureController"
 #define TEMP_DBUS_INTERFACE "com.axis.TemperatureController"
@@ -30,9 +31,46 @@
 #define PORT_STATE_TRUE "true"
 #define PORT_STATE_FALSE "false"
 
+/* Signatures of the signal tuples */
+#define TEMP_SIGNAL_TYPE "(id)"
+#define PORT_SIGNAL_TYPE "(ibbbbbb)"
+
 static GDBusProxy *dbusproxy_temp;
 static GDBusProxy *dbusproxy_ports;
 
+/* Context of one asynchronous call */
+typedef struct
+{
+    GCallback callback;
+    gpointer user_data;
+    int id;
+} call_t;
+
+static call_t *call_new(GCallback callback, gpointer user_data, int id)
+{
+    call_t *call = g_new0(call_t, 1);
+    call->callback = callback;
+    call->user_data = user_data;
+    call->id = id;
+    return call;
+}
+
+/* Finish an asynchronous call, returns the reply's first value or NULL on failure */
+static GVariant *call_finish(GObject *source, GAsyncResult *res, const char *what, const int id)
+{
+    GError *error = NULL;
+    GVariant *result = g_dbus_proxy_call_finish(G_DBUS_PROXY(source), res, &error);
+    if (NULL == result)
+    {
+        LOG_E("%s/%s: Failed to %s for %i (%s)", __FILE__, __FUNCTION__, what, id, error->message);
+        g_error_free(error);
+        return NULL;
+    }
+    GVariant *value = g_variant_get_child_value(result, 0);
+    g_variant_unref(result);
+    return value;
+}
+
 static bool dbus_init(GDBusProxy **dbusproxy, const gchar *name, const gchar *object_path, const gchar *interface_name)
 {
     assert(NULL != dbusproxy);
@@ -81,7 +119,7 @@ bool dbus_temp_get_number_of_sensors(uint32_t *count)
     GError *error = NULL;
 
     GVariant *result = g_dbus_proxy_call_sync(
-        dbusproxy_temp, "GetNbrOfTemperatureSensors", NULL, G_DBUS_CALL_FLAGS_NONE, NO_TIMEOUT, NULL, &error);
+        dbusproxy_temp, "GetNbrOfTemperatureSensors", NULL, G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT_MS, NULL, &error);
     if (NULL == result)
     {
         LOG_E(
@@ -108,6 +146,36 @@ bool dbus_temp_get_number_of_sensors(uint32_t *count)
     return true;
 }
 
+static void on_temp_counted(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    call_t *call = user_data;
+    GVariant *value = call_finish(source, res, "get number of temperature sensors", call->id);
+    uint32_t count = 0;
+    if (NULL != value)
+    {
+        count = (uint32_t)MAX(g_variant_get_int32(value), 0);
+        g_variant_unref(value);
+    }
+    ((dbus_count_callback_t)call->callback)(NULL != value, count, call->user_data);
+    g_free(call);
+}
+
+void dbus_temp_get_number_of_sensors_async(dbus_count_callback_t callback, gpointer user_data)
+{
+    assert(NULL != dbusproxy_temp);
+    assert(NULL != callback);
+
+    g_dbus_proxy_call(
+        dbusproxy_temp,
+        "GetNbrOfTemperatureSensors",
+        NULL,
+        G_DBUS_CALL_FLAGS_NONE,
+        CALL_TIMEOUT_MS,
+        NULL,
+        on_temp_counted,
+        call_new(G_CALLBACK(callback), user_data, -1));
+}
+
 bool dbus_temp_get_value(int id, double *value)
 {
     assert(NULL != value);
@@ -119,7 +187,7 @@ bool dbus_temp_get_value(int id, double *value)
         "GetTemperature",
         g_variant_new("(is)", id, "celsius"),
         G_DBUS_CALL_FLAGS_NONE,
-        NO_TIMEOUT,
+        CALL_TIMEOUT_MS,
         NULL,
         &error);
     if (NULL == result)
@@ -144,6 +212,36 @@ bool dbus_temp_get_value(int id, double *value)
     return true;
 }
 
+static void on_temp_value(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    call_t *call = user_data;
+    GVariant *value = call_finish(source, res, "get temperature", call->id);
+    double temp = 0.0;
+    if (NULL != value)
+    {
+        temp = g_variant_get_double(value);
+        g_variant_unref(value);
+    }
+    ((dbus_value_callback_t)call->callback)(NULL != value, temp, call->user_data);
+    g_free(call);
+}
+
+void dbus_temp_get_value_async(int id, dbus_value_callback_t callback, gpointer user_data)
+{
+    assert(NULL != dbusproxy_temp);
+    assert(NULL != callback);
+
+    g_dbus_proxy_call(
+        dbusproxy_temp,
+        "GetTemperature",
+        g_variant_new("(is)", id, "celsius"),
+        G_DBUS_CALL_FLAGS_NONE,
+        CALL_TIMEOUT_MS,
+        NULL,
+        on_temp_value,
+        call_new(G_CALLBACK(callback), user_data, id));
+}
+
 bool dbus_temp_subscribe_to_change(uint32_t *subscription_id, uint32_t sensor_id, double d)
 {
     assert(NULL != dbusproxy_temp);
@@ -155,7 +253,7 @@ bool dbus_temp_subscribe_to_change(uint32_t *subscription_id, uint32_t sensor_id
         "RegisterForTemperatureChangeSignal",
         g_variant_new("(id)", sensor_id, d),
         G_DBUS_CALL_FLAGS_NONE,
-        NO_TIMEOUT,
+        CALL_TIMEOUT_MS,
         NULL,
         &error);
     if (NULL == result)
@@ -184,44 +282,118 @@ bool dbus_temp_subscribe_to_change(uint32_t *subscription_id, uint32_t sensor_id
     return true;
 }
 
+static void on_temp_subscribed(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    call_t *call = user_data;
+    GVariant *value = call_finish(source, res, "subscribe to temperature change signal", call->id);
+    uint32_t subscription_id = 0;
+    if (NULL != value)
+    {
+        subscription_id = g_variant_get_int32(value);
+        g_variant_unref(value);
+    }
+    ((dbus_subscription_callback_t)call->callback)(NULL != value, subscription_id, call->user_data);
+    g_free(call);
+}
+
+void dbus_temp_subscribe_to_change_async(
+    uint32_t sensor_id,
+    double d,
+    dbus_subscription_callback_t callback,
+    gpointer user_data)
+{
+    assert(NULL != dbusproxy_temp);
+    assert(NULL != callback);
+
+    g_dbus_proxy_call(
+        dbusproxy_temp,
+        "RegisterForTemperatureChangeSignal",
+        g_variant_new("(id)", sensor_id, d),
+        G_DBUS_CALL_FLAGS_NONE,
+        CALL_TIMEOUT_MS,
+        NULL,
+        on_temp_subscribed,
+        call_new(G_CALLBACK(callback), user_data, sensor_id));
+}
+
+static void on_temp_unsubscribed(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    call_t *call = user_data;
+    GError *error = NULL;
+    GVariant *result = g_dbus_proxy_call_finish(G_DBUS_PROXY(source), res, &error);
+    if (NULL == result)
+    {
+        LOG_E(
+            "%s/%s: Failed to unsubscribe %i from temperature change signal (%s)",
+            __FILE__,
+            __FUNCTION__,
+            call->id,
+            error->message);
+        g_error_free(error);
+    }
+    else
+    {
+        g_variant_unref(result);
+    }
+    ((dbus_done_callback_t)call->callback)(NULL != result, call->user_data);
+    g_free(call);
+}
+
+void dbus_temp_unsubscribe_async(uint32_t subscription_id, dbus_done_callback_t callback, gpointer user_data)
+{
+    assert(NULL != dbusproxy_temp);
+    assert(NULL != callback);
+
+    g_dbus_proxy_call(
+        dbusproxy_temp,
+        "UnregisterForTemperatureChangeSignal",
+        g_variant_new("(i)", subscription_id),
+        G_DBUS_CALL_FLAGS_NONE,
+        CALL_TIMEOUT_MS,
+        NULL,
+        on_temp_unsubscribed,
+        call_new(G_CALLBACK(callback), user_data, subscription_id));
+}
+
 bool dbus_temp_unpack_signal(GVariant *parameters, uint32_t *subscription_id, double *value)
 {
     assert(NULL != parameters);
     assert(NULL != subscription_id);
     assert(NULL != value);
 
-    GVariant *gvalue = g_variant_get_child_value(parameters, 0);
-    if (!gvalue)
+    /*
+     * GDBus builds the body as a tree of child values, which g_variant_get
+     * reads in one call. Reading the serialised data instead would make GLib
+     * serialise the tuple into a new buffer on every signal.
+     */
+    if (!g_variant_is_of_type(parameters, G_VARIANT_TYPE(TEMP_SIGNAL_TYPE)))
     {
-        LOG_E("%s/%s: Failed to extract id", __FILE__, __FUNCTION__);
+        LOG_E("%s/%s: Unexpected signal type %s", __FILE__, __FUNCTION__, g_variant_get_type_string(parameters));
         return false;
     }
-    *subscription_id = g_variant_get_int32(gvalue);
-    g_variant_unref(gvalue);
 
-    gvalue = g_variant_get_child_value(parameters, 1);
-    if (!gvalue)
-    {
-        LOG_E("%s/%s: Failed to extract value", __FILE__, __FUNCTION__);
-        return false;
-    }
-    *value = g_variant_get_double(gvalue);
-    g_variant_unref(gvalue);
+    gint32 id;
+    g_variant_get(parameters, TEMP_SIGNAL_TYPE, &id, value);
+    *subscription_id = id;
     return true;
 }
 
+/*
+ * Connect with the D-Bus signal name as detail, so that GLib dispatches on the
+ * signal's quark and the handler is only called for the signal it handles.
+ */
 void dbus_connect_temp_g_signal(GCallback func)
 {
     assert(NULL != dbusproxy_temp);
     assert(NULL != func);
-    g_signal_connect(dbusproxy_temp, "g-signal", func, NULL);
+    g_signal_connect(dbusproxy_temp, "g-signal::" TEMP_SIGNAL_NAME, func, NULL);
 }
 
 void dbus_connect_ports_g_signal(GCallback func)
 {
     assert(NULL != dbusproxy_ports);
     assert(NULL != func);
-    g_signal_connect(dbusproxy_ports, "g-signal", func, NULL);
+    g_signal_connect(dbusproxy_ports, "g-signal::" PORT_SIGNAL_NAME, func, NULL);
 }
 
 bool dbus_get_number_of_ioports(uint32_t *inputs, uint32_t *outputs)
@@ -232,8 +404,14 @@ bool dbus_get_number_of_ioports(uint32_t *inputs, uint32_t *outputs)
     GError *error = NULL;
     GVariant *ret_val = NULL;
 
-    ret_val =
-        g_dbus_proxy_call_sync(dbusproxy_ports, "GetNbrPorts", NULL, G_DBUS_CALL_FLAGS_NONE, NO_TIMEOUT, NULL, &error);
+    ret_val = g_dbus_proxy_call_sync(
+        dbusproxy_ports,
+        "GetNbrPorts",
+        NULL,
+        G_DBUS_CALL_FLAGS_NONE,
+        CALL_TIMEOUT_MS,
+        NULL,
+        &error);
     if (NULL == ret_val)
     {
         LOG_E("%s/%s: Failed to get number of ports from D-Bus (%s)", __FILE__, __FUNCTION__, error->message);
@@ -253,6 +431,43 @@ bool dbus_get_number_of_ioports(uint32_t *inputs, uint32_t *outputs)
     return true;
 }
 
+static void on_ports_counted(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    call_t *call = user_data;
+    GError *error = NULL;
+    uint32_t inputs = 0;
+    uint32_t outputs = 0;
+    GVariant *result = g_dbus_proxy_call_finish(G_DBUS_PROXY(source), res, &error);
+    if (NULL == result)
+    {
+        LOG_E("%s/%s: Failed to get number of ports (%s)", __FILE__, __FUNCTION__, error->message);
+        g_error_free(error);
+    }
+    else
+    {
+        g_variant_get(result, "(uu)", &inputs, &outputs);
+        g_variant_unref(result);
+    }
+    ((dbus_ports_callback_t)call->callback)(NULL != result, inputs, outputs, call->user_data);
+    g_free(call);
+}
+
+void dbus_get_number_of_ioports_async(dbus_ports_callback_t callback, gpointer user_data)
+{
+    assert(NULL != dbusproxy_ports);
+    assert(NULL != callback);
+
+    g_dbus_proxy_call(
+        dbusproxy_ports,
+        "GetNbrPorts",
+        NULL,
+        G_DBUS_CALL_FLAGS_NONE,
+        CALL_TIMEOUT_MS,
+        NULL,
+        on_ports_counted,
+        call_new(G_CALLBACK(callback), user_data, -1));
+}
+
 bool dbus_port_get_state(const int id, bool *state)
 {
     assert(NULL != state);
@@ -260,7 +475,7 @@ bool dbus_port_get_state(const int id, bool *state)
     GError *error = NULL;
 
     GVariant *result = g_dbus_proxy_call_sync(
-        dbusproxy_ports, "GetState", g_variant_new("(u)", id), G_DBUS_CALL_FLAGS_NONE, NO_TIMEOUT, NULL, &error);
+        dbusproxy_ports, "GetState", g_variant_new("(u)", id), G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT_MS, NULL, &error);
 
     if (NULL == result)
     {
@@ -287,97 +502,84 @@ bool dbus_port_get_state(const int id, bool *state)
     return true;
 }
 
-bool dbus_port_unpack_signal(
-    GVariant *parameters,
-    uint32_t *subscription_id,
-    gint *port,
-    gboolean *virtual,
-    gboolean *hidden,
-    gboolean *input,
-    gboolean *virtual_trig,
-    gboolean *state,
-    gboolean *activelow)
+static void on_port_state(GObject *source, GAsyncResult *res, gpointer user_data)
 {
-    assert(NULL != parameters);
-    assert(NULL != subscription_id);
-    assert(NULL != port);
-    assert(NULL != virtual);
-    assert(NULL != hidden);
-    assert(NULL != input);
-    assert(NULL != virtual_trig);
-    assert(NULL != state);
-    assert(NULL != activelow);
-
-    // subscription or port
-    GVariant *gvalue = g_variant_get_child_value(parameters, 0);
-    if (!gvalue)
+    call_t *call = user_data;
+    GVariant *value = call_finish(source, res, "get port state", call->id);
+    bool state = false;
+    if (NULL != value)
     {
-        LOG_E("%s/%s: Failed to extract id", __FILE__, __FUNCTION__);
-        return false;
+        state = g_variant_get_boolean(value);
+        g_variant_unref(value);
     }
-    *subscription_id = g_variant_get_int32(gvalue);
-    *port = g_variant_get_int32(gvalue);
-    g_variant_unref(gvalue);
+    ((dbus_state_callback_t)call->callback)(NULL != value, state, call->user_data);
+    g_free(call);
+}
 
-    // virtual
-    gvalue = g_variant_get_child_value(parameters, 1);
-    if (!gvalue)
-    {
-        LOG_E("%s/%s: Failed to extract value", __FILE__, __FUNCTION__);
-        return false;
-    }
-    *virtual = g_variant_get_boolean(gvalue);
-    g_variant_unref(gvalue);
+void dbus_port_get_state_async(const int id, dbus_state_callback_t callback, gpointer user_data)
+{
+    assert(NULL != dbusproxy_ports);
+    assert(NULL != callback);
 
-    // hidden
-    gvalue = g_variant_get_child_value(parameters, 2);
-    if (!gvalue)
-    {
-        LOG_E("%s/%s: Failed to extract value", __FILE__, __FUNCTION__);
-        return false;
-    }
-    *hidden = g_variant_get_boolean(gvalue);
-    g_variant_unref(gvalue);
+    g_dbus_proxy_call(
+        dbusproxy_ports,
+        "GetState",
+        g_variant_new("(u)", id),
+        G_DBUS_CALL_FLAGS_NONE,
+        CALL_TIMEOUT_MS,
+        NULL,
+        on_port_state,
+        call_new(G_CALLBACK(callback), user_data, id));
+}
 
-    // input
-    gvalue = g_variant_get_child_value(parameters, 3);
-    if (!gvalue)
-    {
-        LOG_E("%s/%s: Failed to extract value", __FILE__, __FUNCTION__);
-        return false;
-    }
-    *input = g_variant_get_boolean(gvalue);
-    g_variant_unref(gvalue);
+bool dbus_port_set_state(const int id, bool state)
+{
+    assert(NULL != dbusproxy_ports);
+    GError *error = NULL;
 
-    // virtual_trig
-    gvalue = g_variant_get_child_value(parameters, 4);
-    if (!gvalue)
+    GVariant *result = g_dbus_proxy_call_sync(
+        dbusproxy_ports,
+        "SetState",
+        g_variant_new("(ub)", id, state),
+        G_DBUS_CALL_FLAGS_NONE,
+        CALL_TIMEOUT_MS,
+        NULL,
+        &error);
+    if (NULL == result)
     {
-        LOG_E("%s/%s: Failed to extract value", __FILE__, __FUNCTION__);
+        LOG_E("%s/%s: Failed to set port state for %i (%s)", __FILE__, __FUNCTION__, id, error->message);
+        g_error_free(error);
         return false;
     }
-    *virtual_trig = g_variant_get_boolean(gvalue);
-    g_variant_unref(gvalue);
+    g_variant_unref(result);
+    return true;
+}
 
-    // state
-    gvalue = g_variant_get_child_value(parameters, 5);
-    if (!gvalue)
-    {
-        LOG_E("%s/%s: Failed to extract value", __FILE__, __FUNCTION__);
-        return false;
-    }
-    *state = g_variant_get_boolean(gvalue);
-    g_variant_unref(gvalue);
+bool dbus_port_unpack_signal(GVariant *parameters, dbus_port_signal_t *signal)
+{
+    assert(NULL != parameters);
+    assert(NULL != signal);
 
-    // activelow
-    gvalue = g_variant_get_child_value(parameters, 6);
-    if (!gvalue)
+    // Decoded like the temperature signal, see dbus_temp_unpack_signal
+    if (!g_variant_is_of_type(parameters, G_VARIANT_TYPE(PORT_SIGNAL_TYPE)))
     {
-        LOG_E("%s/%s: Failed to extract value", __FILE__, __FUNCTION__);
+        LOG_E("%s/%s: Unexpected signal type %s", __FILE__, __FUNCTION__, g_variant_get_type_string(parameters));
         return false;
     }
-    *activelow = g_variant_get_boolean(gvalue);
-    g_variant_unref(gvalue);
 
+    // The first value is the port, which is also what we use as subscription id
+    gint32 port;
+    g_variant_get(
+        parameters,
+        PORT_SIGNAL_TYPE,
+        &port,
+        &signal->virtual,
+        &signal->hidden,
+        &signal->input,
+        &signal->virtual_trig,
+        &signal->state,
+        &signal->activelow);
+    signal->subscription_id = port;
+    signal->port = port;
     return true;
 }
@@ -22,27 +22,53 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#define TEMP_SIGNAL_NAME "TemperatureChangeSignal"
+#define PORT_SIGNAL_NAME "PortChanged"
+
+/* Values of a PortChanged signal */
+typedef struct
+{
+    uint32_t subscription_id;
+    gint port;
+    gboolean virtual;
+    gboolean hidden;
+    gboolean input;
+    gboolean virtual_trig;
+    gboolean state;
+    gboolean activelow;
+} dbus_port_signal_t;
+
+/* Callbacks for the asynchronous calls, ok is false if the call failed or timed out */
+typedef void (*dbus_value_callback_t)(bool ok, double value, gpointer user_data);
+typedef void (*dbus_subscription_callback_t)(bool ok, uint32_t subscription_id, gpointer user_data);
+typedef void (*dbus_state_callback_t)(bool ok, bool state, gpointer user_data);
+typedef void (*dbus_done_callback_t)(bool ok, gpointer user_data);
+typedef void (*dbus_count_callback_t)(bool ok, uint32_t count, gpointer user_data);
+typedef void (*dbus_ports_callback_t)(bool ok, uint32_t inputs, uint32_t outputs, gpointer user_data);
+
 bool dbus_all_init(void);
 void dbus_all_cleanup(void);
 
 bool dbus_temp_get_number_of_sensors(uint32_t *count);
+void dbus_temp_get_number_of_sensors_async(dbus_count_callback_t callback, gpointer user_data);
 bool dbus_temp_get_value(int id, double *value);
+void dbus_temp_get_value_async(int id, dbus_value_callback_t callback, gpointer user_data);
 bool dbus_temp_subscribe_to_change(uint32_t *subscription_id, uint32_t sensor_id, double d);
+void dbus_temp_subscribe_to_change_async(
+    uint32_t sensor_id,
+    double d,
+    dbus_subscription_callback_t callback,
+    gpointer user_data);
+void dbus_temp_unsubscribe_async(uint32_t subscription_id, dbus_done_callback_t callback, gpointer user_data);
 bool dbus_temp_unpack_signal(GVariant *parameters, uint32_t *subscription_id, double *value);
 void dbus_connect_temp_g_signal(GCallback func);
 
 bool dbus_get_number_of_ioports(uint32_t *inputs, uint32_t *outputs);
+void dbus_get_number_of_ioports_async(dbus_ports_callback_t callback, gpointer user_data);
 bool dbus_port_get_state(const int id, bool *state);
-bool dbus_port_unpack_signal(
-    GVariant *parameters,
-    uint32_t *subscription_id,
-    gint *port,
-    gboolean *virtual,
-    gboolean *hidden,
-    gboolean *input,
-    gboolean *virtual_trig,
-    gboolean *state,
-    gboolean *activelow);
+void dbus_port_get_state_async(const int id, dbus_state_callback_t callback, gpointer user_data);
+bool dbus_port_set_state(const int id, bool state);
+bool dbus_port_unpack_signal(GVariant *parameters, dbus_port_signal_t *signal);
 void dbus_connect_ports_g_signal(GCallback func);
 
 #endif /* _OPCUA_DBUS_H_ */
@@ -0,0 +1,336 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "opcua_common.h"
+#include "opcua_diagnostics.h"
+
+/*
+ * Every thread that counts gets its own block on first use. When the thread
+ * exits, e.g. the server thread on a relaunch, its counts move to the retired
+ * block and its block is kept for the next thread.
+ */
+
+_Thread_local diag_block_t *diag_thread_block;
+
+static pthread_mutex_t blocks_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t block_key;
+static diag_block_t *active_blocks;
+static diag_block_t *free_blocks;
+static diag_block_t retired;
+static uint64_t baseline[DIAG_STAGES][DIAG_LATENCY_BUCKETS]; // latency counts at the last reset
+
+static const char *stage_names[DIAG_STAGES] = {
+    [DIAG_STAGE_DECODE] = "decode",
+    [DIAG_STAGE_LOOKUP] = "lookup",
+    [DIAG_STAGE_HOLD] = "hold",
+    [DIAG_STAGE_QUEUE] = "queue",
+    [DIAG_STAGE_WRITE] = "write",
+    [DIAG_STAGE_SAMPLE] = "sample",
+    [DIAG_STAGE_TOTAL] = "total"};
+
+static void add_block(diag_block_t *to, const diag_block_t *from)
+{
+    for (size_t i = 0; i < DIAG_COUNTERS; i++)
+    {
+        diag_bump(&to->counters[i], atomic_load_explicit(&from->counters[i], memory_order_relaxed));
+    }
+    for (size_t stage = 0; stage < DIAG_STAGES; stage++)
+    {
+        for (size_t i = 0; i < DIAG_LATENCY_BUCKETS; i++)
+        {
+            diag_bump(&to->latency[stage][i], atomic_load_explicit(&from->latency[stage][i], memory_order_relaxed));
+        }
+    }
+}
+
+static void retire_block(void *data)
+{
+    diag_block_t *block = data;
+    pthread_mutex_lock(&blocks_mutex);
+    add_block(&retired, block);
+    for (diag_block_t **link = &active_blocks; NULL != *link; link = &(*link)->next)
+    {
+        if (block == *link)
+        {
+            *link = block->next;
+            break;
+        }
+    }
+    block->next = free_blocks;
+    free_blocks = block;
+    pthread_mutex_unlock(&blocks_mutex);
+}
+
+static void create_key(void)
+{
+    if (0 != pthread_key_create(&block_key, retire_block))
+    {
+        LOG_E("%s/%s: Failed to create the thread key of the counters", __FILE__, __FUNCTION__);
+    }
+}
+
+/* The calling thread's block, NULL if there is no memory for it */
+diag_block_t *diagnostics_thread_block(void)
+{
+    (void)pthread_once(&key_once, create_key);
+
+    pthread_mutex_lock(&blocks_mutex);
+    diag_block_t *block = free_blocks;
+    if (NULL != block)
+    {
+        free_blocks = block->next;
+    }
+    else
+    {
+        block = aligned_alloc(DIAG_CACHELINE, sizeof(diag_block_t));
+    }
+    if (NULL != block)
+    {
+        memset(block, 0, sizeof(*block));
+        block->next = active_blocks;
+        active_blocks = block;
+    }
+    pthread_mutex_unlock(&blocks_mutex);
+
+    if (NULL != block)
+    {
+        (void)pthread_setspecific(block_key, block);
+        diag_thread_block = block;
+    }
+    return block;
+}
+
+/* Sum over all threads, from any thread */
+uint64_t diagnostics_get(diag_counter_t counter)
+{
+    assert(DIAG_COUNTERS > counter);
+    pthread_mutex_lock(&blocks_mutex);
+    uint64_t sum = atomic_load_explicit(&retired.counters[counter], memory_order_relaxed);
+    for (const diag_block_t *block = active_blocks; NULL != block; block = block->next)
+    {
+        sum += atomic_load_explicit(&block->counters[counter], memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&blocks_mutex);
+    return sum;
+}
+
+/* Lowest latency of a bucket in ns */
+static uint64_t bucket_low(const size_t bucket)
+{
+    if (DIAG_LATENCY_SUB > bucket)
+    {
+        return bucket;
+    }
+    const size_t octave = bucket / DIAG_LATENCY_SUB;
+    return (uint64_t)(DIAG_LATENCY_SUB + bucket % DIAG_LATENCY_SUB) << (octave - 1);
+}
+
+/* Counts of a stage since the last reset, called with blocks_mutex held */
+static uint64_t sum_latency(const diag_stage_t stage, uint64_t buckets[DIAG_LATENCY_BUCKETS])
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < DIAG_LATENCY_BUCKETS; i++)
+    {
+        buckets[i] = atomic_load_explicit(&retired.latency[stage][i], memory_order_relaxed);
+        for (const diag_block_t *block = active_blocks; NULL != block; block = block->next)
+        {
+            buckets[i] += atomic_load_explicit(&block->latency[stage][i], memory_order_relaxed);
+        }
+        buckets[i] -= baseline[stage][i];
+        total += buckets[i];
+    }
+    return total;
+}
+
+/* Latency in ns below which the given percentage of the samples were, the middle of its bucket */
+static uint64_t percentile(const uint64_t buckets[DIAG_LATENCY_BUCKETS], const uint64_t total, const double percent)
+{
+    if (0 == total)
+    {
+        return 0;
+    }
+    const uint64_t rank = (uint64_t)(percent / 100.0 * (double)(total - 1)) + 1;
+    uint64_t seen = 0;
+    size_t i = 0;
+    for (; i < DIAG_LATENCY_BUCKETS - 1; i++)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+        {
+            break;
+        }
+    }
+    const uint64_t low = bucket_low(i);
+    const uint64_t high = i + 1 < DIAG_LATENCY_BUCKETS ? bucket_low(i + 1) : low;
+    return (low + high) / 2;
+}
+
+/* Latency in ms of a stage below which the given percentage of the samples were, 0 without samples */
+double diagnostics_latency_percentile(diag_stage_t stage, double percent)
+{
+    assert(DIAG_STAGES > stage);
+    uint64_t buckets[DIAG_LATENCY_BUCKETS];
+
+    pthread_mutex_lock(&blocks_mutex);
+    const uint64_t total = sum_latency(stage, buckets);
+    pthread_mutex_unlock(&blocks_mutex);
+    const uint64_t ns = percentile(buckets, total, percent);
+    return (double)ns / 1000000.0;
+}
+
+/*
+ * The recording threads own their blocks, so a reset does not clear them but
+ * takes the current counts as the baseline that later reads subtract.
+ */
+void diagnostics_latency_reset(void)
+{
+    uint64_t buckets[DIAG_LATENCY_BUCKETS];
+
+    pthread_mutex_lock(&blocks_mutex);
+    for (size_t stage = 0; stage < DIAG_STAGES; stage++)
+    {
+        (void)sum_latency((diag_stage_t)stage, buckets);
+        for (size_t i = 0; i < DIAG_LATENCY_BUCKETS; i++)
+        {
+            baseline[stage][i] += buckets[i];
+        }
+    }
+    pthread_mutex_unlock(&blocks_mutex);
+    LOG_I("%s/%s: Latency histograms reset", __FILE__, __FUNCTION__);
+}
+
+static void dump_stage(FILE *file, const diag_stage_t stage, const uint64_t buckets[DIAG_LATENCY_BUCKETS])
+{
+    uint64_t total = 0;
+    size_t last = 0;
+    for (size_t i = 0; i < DIAG_LATENCY_BUCKETS; i++)
+    {
+        total += buckets[i];
+        last = 0 < buckets[i] ? i : last;
+    }
+    // The high end of the highest bucket that is not empty
+    const uint64_t max = 0 == total || last + 1 == DIAG_LATENCY_BUCKETS ? bucket_low(last) : bucket_low(last + 1) - 1;
+    fprintf(
+        file,
+        "    \"%s\": {\"count\": %llu, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"p99.9\": %llu, "
+        "\"max\": %llu, \"buckets\": [",
+        stage_names[stage],
+        (unsigned long long)total,
+        (unsigned long long)percentile(buckets, total, 50.0),
+        (unsigned long long)percentile(buckets, total, 90.0),
+        (unsigned long long)percentile(buckets, total, 99.0),
+        (unsigned long long)percentile(buckets, total, 99.9),
+        (unsigned long long)max);
+    const char *separator = "";
+    for (size_t i = 0; i < DIAG_LATENCY_BUCKETS; i++)
+    {
+        if (0 < buckets[i])
+        {
+            fprintf(
+                file,
+                "%s[%llu, %llu]",
+                separator,
+                (unsigned long long)bucket_low(i),
+                (unsigned long long)buckets[i]);
+            separator = ", ";
+        }
+    }
+    fprintf(file, "]}%s\n", stage + 1 < DIAG_STAGES ? "," : "");
+}
+
+/*
+ * Write the histograms since the last reset as JSON, with the low end in ns and
+ * the count of every bucket that is not empty. The file is replaced at once so
+ * that readers never see half of it.
+ */
+bool diagnostics_latency_dump(const char *path)
+{
+    assert(NULL != path);
+    static uint64_t buckets[DIAG_STAGES][DIAG_LATENCY_BUCKETS];
+    char tmp_path[PATH_MAX];
+
+    if ((int)sizeof(tmp_path) <= snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path))
+    {
+        LOG_E("%s/%s: Path %s is too long", __FILE__, __FUNCTION__, path);
+        return false;
+    }
+    FILE *file = fopen(tmp_path, "w");
+    if (NULL == file)
+    {
+        LOG_E("%s/%s: Failed to open %s: %s", __FILE__, __FUNCTION__, tmp_path, strerror(errno));
+        return false;
+    }
+
+    // Copy first, the file is written without holding the lock
+    pthread_mutex_lock(&blocks_mutex);
+    for (size_t stage = 0; stage < DIAG_STAGES; stage++)
+    {
+        (void)sum_latency((diag_stage_t)stage, buckets[stage]);
+    }
+    pthread_mutex_unlock(&blocks_mutex);
+
+    fprintf(file, "{\n  \"unit\": \"ns\",\n  \"stages\": {\n");
+    for (size_t stage = 0; stage < DIAG_STAGES; stage++)
+    {
+        dump_stage(file, (diag_stage_t)stage, buckets[stage]);
+    }
+    fprintf(file, "  }\n}\n");
+
+    const bool written = 0 == ferror(file);
+    if (0 != fclose(file) || !written || 0 != rename(tmp_path, path))
+    {
+        LOG_E("%s/%s: Failed to write %s: %s", __FILE__, __FUNCTION__, path, strerror(errno));
+        (void)unlink(tmp_path);
+        return false;
+    }
+    LOG_I("%s/%s: Latency histograms written to %s", __FILE__, __FUNCTION__, path);
+    return true;
+}
+
+bool diagnostics_get_process(diag_process_t *process)
+{
+    assert(NULL != process);
+    struct rusage usage;
+    if (0 != getrusage(RUSAGE_SELF, &usage))
+    {
+        return false;
+    }
+    process->cpu_s = (double)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+                     (double)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000000.0;
+
+    // Resident pages are the second field
+    unsigned long pages = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (NULL == statm)
+    {
+        return false;
+    }
+    const bool ok = 1 == fscanf(statm, "%*u %lu", &pages);
+    fclose(statm);
+    process->rss_kb = (uint64_t)pages * (uint64_t)sysconf(_SC_PAGESIZE) / 1024;
+    return ok;
+}
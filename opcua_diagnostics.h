@@ -0,0 +1,141 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _OPCUA_DIAGNOSTICS_H_
+#define _OPCUA_DIAGNOSTICS_H_
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#define DIAG_CACHELINE 64
+
+/* Where the latency histograms are written on SIGUSR1, relative to the application directory */
+#define DIAG_LATENCY_FILE "localdata/latency.json"
+
+/*
+ * Latency buckets in ns, log-linear like an HDR histogram: exact below 8 ns,
+ * then 8 per power of two (within 12.5%) up to 2^42 ns, about 73 minutes
+ */
+#define DIAG_LATENCY_SUB_BITS 3
+#define DIAG_LATENCY_SUB (1 << DIAG_LATENCY_SUB_BITS)
+#define DIAG_LATENCY_BUCKETS (DIAG_LATENCY_SUB * 40)
+
+typedef enum
+{
+    DIAG_SIGNALS_TEMP,
+    DIAG_SIGNALS_PORT,
+    DIAG_DECODE_FAILURES,
+    DIAG_UPDATES_FORWARDED,
+    DIAG_UPDATES_COALESCED,
+    DIAG_UPDATES_WRITTEN,
+    DIAG_MONITORED_ITEMS, // counted up and down
+    DIAG_COUNTERS
+} diag_counter_t;
+
+/* Stages of a value from its D-Bus signal to the clients, each with its own latency histogram */
+typedef enum
+{
+    DIAG_STAGE_DECODE, // signal received to decoded
+    DIAG_STAGE_LOOKUP, // decoded to its channel found
+    DIAG_STAGE_HOLD,   // signal received to queued for the server thread, including coalescing
+    DIAG_STAGE_QUEUE,  // queued to taken by the server thread
+    DIAG_STAGE_WRITE,  // written to the server, including the sampling of monitored items on writes
+    DIAG_STAGE_SAMPLE, // written to first read, by the sampling of a monitored item or a client
+    DIAG_STAGE_TOTAL,  // signal received to written
+    DIAG_STAGES
+} diag_stage_t;
+
+/*
+ * Counters of one thread. Only the owning thread writes them, so it needs no
+ * atomic read-modify-write, and readers sum the blocks of all threads.
+ */
+typedef struct diag_block
+{
+    alignas(DIAG_CACHELINE) atomic_uint_fast64_t counters[DIAG_COUNTERS];
+    atomic_uint_fast64_t latency[DIAG_STAGES][DIAG_LATENCY_BUCKETS];
+    struct diag_block *next;
+} diag_block_t;
+
+typedef struct
+{
+    double cpu_s; // user and system time of the process
+    uint64_t rss_kb;
+} diag_process_t;
+
+extern _Thread_local diag_block_t *diag_thread_block;
+
+diag_block_t *diagnostics_thread_block(void);
+uint64_t diagnostics_get(diag_counter_t counter);
+double diagnostics_latency_percentile(diag_stage_t stage, double percent);
+void diagnostics_latency_reset(void);
+bool diagnostics_latency_dump(const char *path);
+bool diagnostics_get_process(diag_process_t *process);
+
+static inline void diag_bump(atomic_uint_fast64_t *counter, uint64_t n)
+{
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+/* Add n, which may be negative, to a counter of the calling thread */
+static inline void diagnostics_add(diag_counter_t counter, int64_t n)
+{
+    diag_block_t *block = NULL != diag_thread_block ? diag_thread_block : diagnostics_thread_block();
+    if (NULL != block)
+    {
+        diag_bump(&block->counters[counter], (uint64_t)n);
+    }
+}
+
+static inline void diagnostics_count(diag_counter_t counter)
+{
+    diagnostics_add(counter, 1);
+}
+
+/* Monotonic time in ns, the clock of the stage boundaries */
+static inline int64_t diagnostics_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static inline size_t diag_latency_bucket(uint64_t ns)
+{
+    if (DIAG_LATENCY_SUB > ns)
+    {
+        return (size_t)ns;
+    }
+    const unsigned msb = 63 - (unsigned)__builtin_clzll(ns);
+    const size_t bucket = (size_t)(msb - DIAG_LATENCY_SUB_BITS + 1) * DIAG_LATENCY_SUB +
+                          ((ns >> (msb - DIAG_LATENCY_SUB_BITS)) & (DIAG_LATENCY_SUB - 1));
+    return bucket < DIAG_LATENCY_BUCKETS ? bucket : DIAG_LATENCY_BUCKETS - 1;
+}
+
+/* Record the time a value spent in a stage, cheap enough to always be on */
+static inline void diagnostics_record_latency(diag_stage_t stage, int64_t ns)
+{
+    diag_block_t *block = NULL != diag_thread_block ? diag_thread_block : diagnostics_thread_block();
+    if (NULL != block)
+    {
+        diag_bump(&block->latency[stage][diag_latency_bucket(0 < ns ? (uint64_t)ns : 0)], 1);
+    }
+}
+
+#endif /* _OPCUA_DIAGNOSTICS_H_ */
@@ -0,0 +1,164 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+
+#include "opcua_common.h"
+#include "opcua_events.h"
+
+/* Severity of a port transition, on the 1-1000 scale of BaseEventType */
+#define PORT_TRANSITION_SEVERITY 100
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+static void add_property(UA_Server *server, const UA_UInt32 id, const char *name, const UA_DataType *type)
+{
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", (char *)name);
+    attr.dataType = type->typeId;
+    attr.valueRank = UA_VALUERANK_SCALAR;
+    UA_StatusCode status = UA_Server_addVariableNode(
+        server,
+        UA_NODEID_NUMERIC(CHANNEL_NAMESPACE, id),
+        UA_NODEID_NUMERIC(CHANNEL_NAMESPACE, EVENTS_NODEID_PORT_TRANSITION),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY),
+        UA_QUALIFIEDNAME(CHANNEL_NAMESPACE, (char *)name),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_PROPERTYTYPE),
+        attr,
+        NULL,
+        NULL);
+    if (UA_STATUSCODE_GOOD == status)
+    {
+        // Mandatory, so that every event node gets the property
+        status = UA_Server_addReference(
+            server,
+            UA_NODEID_NUMERIC(CHANNEL_NAMESPACE, id),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_HASMODELLINGRULE),
+            UA_EXPANDEDNODEID_NUMERIC(0, UA_NS0ID_MODELLINGRULE_MANDATORY),
+            true);
+    }
+    if (UA_STATUSCODE_GOOD != status)
+    {
+        LOG_E("%s/%s: Failed to add event property %s (%s)", __FILE__, __FUNCTION__, name, UA_StatusCode_name(status));
+    }
+}
+
+static void write_property(
+    UA_Server *server,
+    const UA_NodeId event,
+    const UA_UInt16 ns,
+    const char *name,
+    const void *value,
+    const UA_DataType *type)
+{
+    UA_StatusCode status =
+        UA_Server_writeObjectProperty_scalar(server, event, UA_QUALIFIEDNAME(ns, (char *)name), value, type);
+    if (UA_STATUSCODE_GOOD != status)
+    {
+        LOG_E("%s/%s: Failed to set event field %s (%s)", __FILE__, __FUNCTION__, name, UA_StatusCode_name(status));
+    }
+}
+#endif
+
+/* Add the port transition event type, a BaseEventType with the port, the edge and the signal's flags */
+void events_add_types(UA_Server *server)
+{
+    assert(NULL != server);
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    UA_ObjectTypeAttributes attr = UA_ObjectTypeAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "PortTransitionEventType");
+    attr.description = UA_LOCALIZEDTEXT("en-US", "A change of the state of an I/O port");
+    UA_StatusCode status = UA_Server_addObjectTypeNode(
+        server,
+        UA_NODEID_NUMERIC(CHANNEL_NAMESPACE, EVENTS_NODEID_PORT_TRANSITION),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+        UA_QUALIFIEDNAME(CHANNEL_NAMESPACE, "PortTransitionEventType"),
+        attr,
+        NULL,
+        NULL);
+    if (UA_STATUSCODE_GOOD != status)
+    {
+        LOG_E("%s/%s: Failed to add port transition events (%s)", __FILE__, __FUNCTION__, UA_StatusCode_name(status));
+        return;
+    }
+    add_property(server, EVENTS_NODEID_PORT, "Port", &UA_TYPES[UA_TYPES_UINT32]);
+    add_property(server, EVENTS_NODEID_RISING, "Rising", &UA_TYPES[UA_TYPES_BOOLEAN]);
+    add_property(server, EVENTS_NODEID_ACTIVELOW, "ActiveLow", &UA_TYPES[UA_TYPES_BOOLEAN]);
+    add_property(server, EVENTS_NODEID_VIRTUAL, "Virtual", &UA_TYPES[UA_TYPES_BOOLEAN]);
+#endif
+}
+
+/*
+ * Send a port transition event from the Server object, called on the UA
+ * server thread. The source node is the port's node and the time is when the
+ * D-Bus signal was received.
+ */
+void events_port_transition(UA_Server *server, const update_t *update)
+{
+    assert(NULL != update);
+    assert(CHANNEL_PORT == update->channel->type);
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    const channel_t *channel = update->channel;
+    UA_UInt32 port = channel->index;
+    UA_Boolean rising = update->value.transition.state;
+    UA_Boolean activelow = update->value.transition.activelow;
+    UA_Boolean virtual = update->value.transition.virtual;
+    UA_DateTime time = UA_DATETIME_UNIX_EPOCH + update->received.real_ns / 100;
+    UA_UInt16 severity = PORT_TRANSITION_SEVERITY;
+    UA_String source_name = UA_STRING((char *)channel->label);
+    char text[64];
+    snprintf(text, sizeof(text), "%s %s", channel->label, rising ? "rising" : "falling");
+    UA_LocalizedText message = UA_LOCALIZEDTEXT("en-US", text);
+
+    UA_NodeId event;
+    UA_StatusCode status =
+        UA_Server_createEvent(server, UA_NODEID_NUMERIC(CHANNEL_NAMESPACE, EVENTS_NODEID_PORT_TRANSITION), &event);
+    if (UA_STATUSCODE_GOOD != status)
+    {
+        LOG_E(
+            "%s/%s: Failed to create event for %s (%s)",
+            __FILE__,
+            __FUNCTION__,
+            channel->label,
+            UA_StatusCode_name(status));
+        return;
+    }
+    write_property(server, event, 0, "Time", &time, &UA_TYPES[UA_TYPES_DATETIME]);
+    write_property(server, event, 0, "Severity", &severity, &UA_TYPES[UA_TYPES_UINT16]);
+    write_property(server, event, 0, "Message", &message, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    write_property(server, event, 0, "SourceName", &source_name, &UA_TYPES[UA_TYPES_STRING]);
+    write_property(server, event, 0, "SourceNode", &channel->node_id, &UA_TYPES[UA_TYPES_NODEID]);
+    write_property(server, event, CHANNEL_NAMESPACE, "Port", &port, &UA_TYPES[UA_TYPES_UINT32]);
+    write_property(server, event, CHANNEL_NAMESPACE, "Rising", &rising, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    write_property(server, event, CHANNEL_NAMESPACE, "ActiveLow", &activelow, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    write_property(server, event, CHANNEL_NAMESPACE, "Virtual", &virtual, &UA_TYPES[UA_TYPES_BOOLEAN]);
+
+    // Clients subscribe to events of the Server object, the event node is deleted once it is sent
+    status = UA_Server_triggerEvent(server, event, UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER), NULL, true);
+    if (UA_STATUSCODE_GOOD != status)
+    {
+        LOG_E(
+            "%s/%s: Failed to send event for %s (%s)",
+            __FILE__,
+            __FUNCTION__,
+            channel->label,
+            UA_StatusCode_name(status));
+    }
+#else
+    (void)server;
+#endif
+}
@@ -0,0 +1,44 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _OPCUA_EVENTS_H_
+#define _OPCUA_EVENTS_H_
+
+#include <open62541/server.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "opcua_updates.h"
+
+/* Without events in open62541 port transitions are not sent */
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+#define EVENTS_SUPPORTED true
+#else
+#define EVENTS_SUPPORTED false
+#endif
+
+/* Node ids in namespace 1 of the port transition event type and its properties */
+#define EVENTS_NODEID_PORT_TRANSITION 3300
+#define EVENTS_NODEID_PORT 3301
+#define EVENTS_NODEID_RISING 3302
+#define EVENTS_NODEID_ACTIVELOW 3303
+#define EVENTS_NODEID_VIRTUAL 3304
+
+void events_add_types(UA_Server *server);
+void events_port_transition(UA_Server *server, const update_t *update);
+
+#endif /* _OPCUA_EVENTS_H_ */
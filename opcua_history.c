@@ -0,0 +1,993 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "opcua_common.h"
+#include "opcua_history.h"
+
+#define HISTORY_ALIGN 64
+
+#define HISTORY_FILE_MAGIC 0x4f504855 /* "UHPO" */
+#define HISTORY_FILE_VERSION 1
+#define HISTORY_FILE_HEADER_SIZE 64
+#define HISTORY_FILE_MIN_RECORDS 1024
+
+/*
+ * A delta encoded port sample is 32 bits: the state in bit 0, the unit of the
+ * time since the previous sample in bit 1 (ms, or s when that does not fit)
+ * and that time in the remaining bits. The time of the oldest sample is kept
+ * in the ring, so only the rounding of one delta ends up in a timestamp.
+ */
+#define DELTA_STATE 0x1u
+#define DELTA_SECONDS 0x2u
+#define DELTA_SHIFT 2
+#define DELTA_MAX (UINT32_MAX >> DELTA_SHIFT)
+
+/* Delta rings keep the absolute time of every CHECKPOINT_INTERVAL:th entry, so a seek sums at most that many deltas */
+#define CHECKPOINT_INTERVAL 128
+
+/* DataValue info bits for an interpolated value, see OPC UA Part 11 */
+#define HISTORY_STATUS_INTERPOLATED 0x00000402
+
+typedef struct
+{
+    UA_DateTime time;
+    double value;
+} sample_t;
+
+/* Fixed size ring of the newest samples of one channel */
+typedef struct
+{
+    const channel_t *channel;
+    bool delta;
+    size_t capacity;
+    size_t size;
+    size_t head;            // where the next sample goes
+    uint64_t appended;      // sample number of the next sample, continuation points refer to these
+    UA_DateTime first_time;   // delta rings only, time of the oldest sample
+    UA_DateTime last_time;    // delta rings only, time of the newest sample
+    UA_DateTime *checkpoints; // delta rings only, indexed by entry position / CHECKPOINT_INTERVAL
+    union
+    {
+        sample_t *samples;
+        uint32_t *deltas;
+    } entries;
+} ring_t;
+
+/* Position in a ring, index 0 is the oldest sample */
+typedef struct
+{
+    const ring_t *ring;
+    size_t index;
+    UA_DateTime time;
+} cursor_t;
+
+/* The persisted history is a circular log of records in a memory mapped file */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    uint64_t head;
+    uint64_t count;
+} file_header_t;
+
+typedef struct
+{
+    UA_DateTime time;
+    double value;
+    uint32_t type;
+    uint32_t index;
+} file_record_t;
+
+/*
+ * Set from the GLib main loop and picked up on the UA server thread by
+ * history_sync. Everything else is only touched by the UA server thread, or
+ * while it is not running.
+ */
+static struct
+{
+    atomic_size_t budget;
+    atomic_bool port_delta;
+    atomic_bool persist;
+    atomic_bool changed;
+} pending;
+
+static history_config_t current;
+static const channels_t *channels;
+static size_t channels_count; // the first slots of channels that have a ring
+static ring_t *rings; // indexed by channel slot
+static size_t rings_size;
+static void *arena;
+static size_t arena_size;
+static ring_t **lookup[CHANNEL_TYPES]; // indexed by sensor or port number
+static size_t lookup_size[CHANNEL_TYPES];
+static uint64_t appended;
+static uint64_t restored;
+
+static int file_fd = -1;
+static void *file_map;
+static size_t file_size;
+static file_header_t *file_header;
+static file_record_t *file_records;
+
+static size_t ring_pos(const ring_t *ring, const size_t index)
+{
+    return (ring->head + ring->capacity - ring->size + index) % ring->capacity;
+}
+
+static UA_DateTime delta_ticks(const uint32_t entry)
+{
+    return (UA_DateTime)(entry >> DELTA_SHIFT) * ((entry & DELTA_SECONDS) ? UA_DATETIME_SEC : UA_DATETIME_MSEC);
+}
+
+static uint32_t delta_encode(UA_DateTime delta, const bool state, UA_DateTime *rounded)
+{
+    UA_DateTime unit = UA_DATETIME_MSEC;
+    uint32_t flags = state ? DELTA_STATE : 0;
+
+    // Clock steps backwards are stored as no time at all
+    delta = MAX(delta, 0);
+    if (DELTA_MAX < delta / UA_DATETIME_MSEC)
+    {
+        unit = UA_DATETIME_SEC;
+        flags |= DELTA_SECONDS;
+    }
+    const UA_DateTime units = MIN(delta / unit, (UA_DateTime)DELTA_MAX);
+    *rounded = units * unit;
+    return (uint32_t)units << DELTA_SHIFT | flags;
+}
+
+static void ring_append(ring_t *ring, const UA_DateTime time, const double value)
+{
+    ring->appended++;
+    if (0 == ring->capacity)
+    {
+        return;
+    }
+
+    if (!ring->delta)
+    {
+        // Source times come from the wall clock; a step backwards keeps the ring sorted like in delta rings
+        const sample_t *newest = &ring->entries.samples[(ring->head + ring->capacity - 1) % ring->capacity];
+        const UA_DateTime sorted = 0 < ring->size ? MAX(time, newest->time) : time;
+        ring->entries.samples[ring->head] = (sample_t){sorted, value};
+    }
+    else if (0 == ring->size || 1 == ring->capacity)
+    {
+        UA_DateTime rounded;
+        ring->entries.deltas[ring->head] = delta_encode(0, 0.0 != value, &rounded);
+        ring->first_time = time;
+        ring->last_time = time;
+    }
+    else
+    {
+        UA_DateTime rounded;
+        const uint32_t entry = delta_encode(time - ring->last_time, 0.0 != value, &rounded);
+        if (ring->size == ring->capacity)
+        {
+            // The oldest sample is overwritten, the second oldest takes over the time
+            ring->first_time += delta_ticks(ring->entries.deltas[ring_pos(ring, 1)]);
+        }
+        ring->entries.deltas[ring->head] = entry;
+        ring->last_time += rounded;
+    }
+    if (ring->delta && 0 == ring->head % CHECKPOINT_INTERVAL)
+    {
+        ring->checkpoints[ring->head / CHECKPOINT_INTERVAL] = ring->last_time;
+    }
+
+    ring->head = (ring->head + 1) % ring->capacity;
+    if (ring->size < ring->capacity)
+    {
+        ring->size++;
+    }
+}
+
+static void cursor_read_time(cursor_t *cursor)
+{
+    if (!cursor->ring->delta && cursor->index < cursor->ring->size)
+    {
+        cursor->time = cursor->ring->entries.samples[ring_pos(cursor->ring, cursor->index)].time;
+    }
+}
+
+static void cursor_next(cursor_t *cursor)
+{
+    const ring_t *ring = cursor->ring;
+    cursor->index++;
+    if (ring->delta && cursor->index < ring->size)
+    {
+        cursor->time += delta_ticks(ring->entries.deltas[ring_pos(ring, cursor->index)]);
+    }
+    cursor_read_time(cursor);
+}
+
+static void cursor_prev(cursor_t *cursor)
+{
+    const ring_t *ring = cursor->ring;
+    if (ring->delta && cursor->index < ring->size)
+    {
+        cursor->time -= delta_ticks(ring->entries.deltas[ring_pos(ring, cursor->index)]);
+    }
+    cursor->index--; // wraps to an invalid index before the oldest sample
+    cursor_read_time(cursor);
+}
+
+static void cursor_seek(cursor_t *cursor, const ring_t *ring, const size_t index)
+{
+    assert(index < ring->size);
+    cursor->ring = ring;
+    if (!ring->delta)
+    {
+        cursor->index = index;
+        cursor_read_time(cursor);
+        return;
+    }
+
+    // Sum up the deltas from the closest checkpoint before, unless that is not in the ring
+    const size_t back = ring_pos(ring, index) % CHECKPOINT_INTERVAL;
+    if (back <= index)
+    {
+        cursor->index = index - back;
+        cursor->time = ring->checkpoints[ring_pos(ring, cursor->index) / CHECKPOINT_INTERVAL];
+    }
+    else
+    {
+        cursor->index = 0;
+        cursor->time = ring->first_time;
+    }
+    while (cursor->index < index)
+    {
+        cursor_next(cursor);
+    }
+}
+
+static UA_DateTime ring_time_at(const ring_t *ring, const size_t index)
+{
+    cursor_t cursor;
+    cursor_seek(&cursor, ring, index);
+    return cursor.time;
+}
+
+static double cursor_value(const cursor_t *cursor)
+{
+    const ring_t *ring = cursor->ring;
+    const size_t pos = ring_pos(ring, cursor->index);
+    if (ring->delta)
+    {
+        return (ring->entries.deltas[pos] & DELTA_STATE) ? 1.0 : 0.0;
+    }
+    return ring->entries.samples[pos].value;
+}
+
+/* Index of the first sample at (or after, if after is set) time, size if there is none */
+static size_t ring_search(const ring_t *ring, const UA_DateTime time, const bool after)
+{
+    size_t low = 0;
+    size_t high = ring->size;
+    while (low < high)
+    {
+        const size_t mid = low + (high - low) / 2;
+        const UA_DateTime mid_time = ring_time_at(ring, mid);
+        if (mid_time < time || (after && mid_time == time))
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/* Number of samples that fit in bytes, delta rings also need room for their checkpoints */
+static size_t ring_capacity(const size_t bytes, const bool delta)
+{
+    if (!delta)
+    {
+        return bytes / sizeof(sample_t);
+    }
+    return bytes / (CHECKPOINT_INTERVAL * sizeof(uint32_t) + sizeof(UA_DateTime)) * CHECKPOINT_INTERVAL;
+}
+
+static ring_t *find_ring(const channel_type_t type, const uint32_t index)
+{
+    return index < lookup_size[type] ? lookup[type][index] : NULL;
+}
+
+static ring_t *find_ring_by_node(const UA_NodeId *node_id)
+{
+    if (CHANNEL_NAMESPACE != node_id->namespaceIndex || UA_NODEIDTYPE_NUMERIC != node_id->identifierType)
+    {
+        return NULL;
+    }
+    const UA_UInt32 id = node_id->identifier.numeric;
+    if (CHANNEL_NODEID_TEMP_BASE <= id && CHANNEL_NODEID_TEMP_BASE + CHANNELS_MAX_PER_TYPE > id)
+    {
+        return find_ring(CHANNEL_TEMP, id - CHANNEL_NODEID_TEMP_BASE);
+    }
+    if (CHANNEL_NODEID_PORT_BASE <= id && CHANNEL_NODEID_PORT_BASE + CHANNELS_MAX_PER_TYPE > id)
+    {
+        return find_ring(CHANNEL_PORT, id - CHANNEL_NODEID_PORT_BASE);
+    }
+    return NULL;
+}
+
+static void free_rings(ring_t *old_rings, void *old_arena, ring_t ***old_lookup)
+{
+    for (int type = 0; type < CHANNEL_TYPES; type++)
+    {
+        free(old_lookup[type]);
+    }
+    free(old_rings);
+    free(old_arena);
+}
+
+/*
+ * Allocate new rings for the channels within the budget, split evenly over
+ * them. Samples of channels that had a ring before are moved over, newest
+ * first if they do not all fit.
+ */
+static void rebuild(const channels_t *new_channels, const size_t count, const history_config_t *config)
+{
+    ring_t *old_rings = rings;
+    void *old_arena = arena;
+    ring_t **old_lookup[CHANNEL_TYPES];
+    size_t old_lookup_size[CHANNEL_TYPES];
+    memcpy(old_lookup, lookup, sizeof(lookup));
+    memcpy(old_lookup_size, lookup_size, sizeof(lookup_size));
+
+    const size_t share = 0 < count ? (config->budget / count) & ~(size_t)(HISTORY_ALIGN - 1) : 0;
+    rings = calloc(count, sizeof(ring_t));
+    arena = 0 < share ? aligned_alloc(HISTORY_ALIGN, share * count) : NULL;
+    if ((0 < count && NULL == rings) || (0 < share && NULL == arena))
+    {
+        LOG_E("%s/%s: Failed to allocate %zu bytes of history", __FILE__, __FUNCTION__, share * count);
+        free(rings);
+        free(arena);
+        rings = NULL;
+        arena = NULL;
+        rings_size = 0;
+        arena_size = 0;
+        memset(lookup, 0, sizeof(lookup));
+        memset(lookup_size, 0, sizeof(lookup_size));
+        free_rings(old_rings, old_arena, old_lookup);
+        return;
+    }
+    rings_size = count;
+    arena_size = share * count;
+
+    memset(lookup_size, 0, sizeof(lookup_size));
+    for (size_t i = 0; i < count; i++)
+    {
+        const channel_t *channel = &new_channels->slots[i];
+        lookup_size[channel->type] = MAX(lookup_size[channel->type], channel->index + 1);
+    }
+    for (int type = 0; type < CHANNEL_TYPES; type++)
+    {
+        lookup[type] = calloc(lookup_size[type], sizeof(ring_t *));
+        if (NULL == lookup[type])
+        {
+            lookup_size[type] = 0;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const channel_t *channel = &new_channels->slots[i];
+        ring_t *ring = &rings[i];
+        ring->channel = channel;
+        ring->delta = CHANNEL_PORT == channel->type && config->port_delta;
+        ring->capacity = ring_capacity(share, ring->delta);
+        ring->entries.samples = (void *)((char *)arena + i * share);
+        if (ring->delta)
+        {
+            ring->checkpoints = (UA_DateTime *)(ring->entries.deltas + ring->capacity);
+        }
+        if (channel->index < lookup_size[channel->type])
+        {
+            lookup[channel->type][channel->index] = ring;
+        }
+
+        const ring_t *old = channel->index < old_lookup_size[channel->type] ? old_lookup[channel->type][channel->index]
+                                                                             : NULL;
+        if (NULL == old)
+        {
+            continue;
+        }
+        const size_t keep = MIN(old->size, ring->capacity);
+        ring->appended = old->appended - keep;
+        if (0 == keep)
+        {
+            continue;
+        }
+        cursor_t cursor;
+        for (cursor_seek(&cursor, old, old->size - keep); cursor.index < old->size; cursor_next(&cursor))
+        {
+            ring_append(ring, cursor.time, cursor_value(&cursor));
+        }
+    }
+
+    free_rings(old_rings, old_arena, old_lookup);
+}
+
+static size_t file_records_for(const size_t budget)
+{
+    return MAX(budget / sizeof(file_record_t), HISTORY_FILE_MIN_RECORDS);
+}
+
+static void file_close(void)
+{
+    if (NULL != file_map)
+    {
+        munmap(file_map, file_size);
+        file_map = NULL;
+        file_header = NULL;
+        file_records = NULL;
+    }
+    if (0 <= file_fd)
+    {
+        close(file_fd);
+        file_fd = -1;
+    }
+}
+
+static void file_clear(void)
+{
+    file_header->magic = HISTORY_FILE_MAGIC;
+    file_header->version = HISTORY_FILE_VERSION;
+    file_header->capacity = (file_size - HISTORY_FILE_HEADER_SIZE) / sizeof(file_record_t);
+    file_header->head = 0;
+    file_header->count = 0;
+}
+
+/* Map the history file with room for the given number of records, restorable tells if it has valid content */
+static bool file_open(const size_t records, bool *restorable)
+{
+    assert(0 > file_fd);
+    *restorable = false;
+
+    file_fd = open(HISTORY_FILE, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (0 > file_fd)
+    {
+        LOG_E("%s/%s: Failed to open %s (%s)", __FILE__, __FUNCTION__, HISTORY_FILE, strerror(errno));
+        return false;
+    }
+    file_size = HISTORY_FILE_HEADER_SIZE + records * sizeof(file_record_t);
+    struct stat st;
+    const bool same_size = 0 == fstat(file_fd, &st) && (off_t)file_size == st.st_size;
+    if (!same_size && 0 != ftruncate(file_fd, file_size))
+    {
+        LOG_E("%s/%s: Failed to resize %s (%s)", __FILE__, __FUNCTION__, HISTORY_FILE, strerror(errno));
+        file_close();
+        return false;
+    }
+    file_map = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, file_fd, 0);
+    if (MAP_FAILED == file_map)
+    {
+        LOG_E("%s/%s: Failed to map %s (%s)", __FILE__, __FUNCTION__, HISTORY_FILE, strerror(errno));
+        file_map = NULL;
+        file_close();
+        return false;
+    }
+    file_header = file_map;
+    file_records = (file_record_t *)((char *)file_map + HISTORY_FILE_HEADER_SIZE);
+
+    *restorable = same_size && HISTORY_FILE_MAGIC == file_header->magic &&
+                  HISTORY_FILE_VERSION == file_header->version && records == file_header->capacity &&
+                  file_header->head < records && file_header->count <= records;
+    if (!*restorable)
+    {
+        file_clear();
+    }
+    return true;
+}
+
+static void file_append(const channel_t *channel, const UA_DateTime time, const double value)
+{
+    file_record_t *record = &file_records[file_header->head];
+    record->time = time;
+    record->value = value;
+    record->type = channel->type;
+    record->index = channel->index;
+    file_header->head = (file_header->head + 1) % file_header->capacity;
+    if (file_header->count < file_header->capacity)
+    {
+        file_header->count++;
+    }
+}
+
+static void file_restore(void)
+{
+    const uint64_t capacity = file_header->capacity;
+    const uint64_t oldest = (file_header->head + capacity - file_header->count) % capacity;
+    for (uint64_t i = 0; i < file_header->count; i++)
+    {
+        const file_record_t *record = &file_records[(oldest + i) % capacity];
+        ring_t *ring = CHANNEL_TYPES > record->type ? find_ring(record->type, record->index) : NULL;
+        if (NULL != ring)
+        {
+            ring_append(ring, record->time, record->value);
+            restored++;
+        }
+    }
+    LOG_I(
+        "%s/%s: Restored %llu history samples from %s",
+        __FILE__,
+        __FUNCTION__,
+        (unsigned long long)restored,
+        HISTORY_FILE);
+}
+
+/* Write what is in the rings to a cleared file, one channel after the other */
+static void file_rewrite(void)
+{
+    for (size_t i = 0; i < rings_size; i++)
+    {
+        const ring_t *ring = &rings[i];
+        if (0 == ring->size)
+        {
+            continue;
+        }
+        cursor_t cursor;
+        for (cursor_seek(&cursor, ring, 0); cursor.index < ring->size; cursor_next(&cursor))
+        {
+            file_append(ring->channel, cursor.time, cursor_value(&cursor));
+        }
+    }
+}
+
+static void set_timestamps(UA_DataValue *data_value, const UA_DateTime time, const UA_TimestampsToReturn timestamps)
+{
+    if (UA_TIMESTAMPSTORETURN_SOURCE == timestamps || UA_TIMESTAMPSTORETURN_BOTH == timestamps)
+    {
+        data_value->sourceTimestamp = time;
+        data_value->hasSourceTimestamp = true;
+    }
+    if (UA_TIMESTAMPSTORETURN_SERVER == timestamps || UA_TIMESTAMPSTORETURN_BOTH == timestamps)
+    {
+        data_value->serverTimestamp = time;
+        data_value->hasServerTimestamp = true;
+    }
+}
+
+static void set_value(
+    UA_DataValue *data_value,
+    const ring_t *ring,
+    double value,
+    const UA_DateTime time,
+    const UA_TimestampsToReturn timestamps)
+{
+    if (CHANNEL_TEMP == ring->channel->type)
+    {
+        (void)UA_Variant_setScalarCopy(&data_value->value, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
+    }
+    else
+    {
+        UA_Boolean state = 0.0 != value;
+        (void)UA_Variant_setScalarCopy(&data_value->value, &state, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    }
+    data_value->hasValue = true;
+    set_timestamps(data_value, time, timestamps);
+}
+
+static UA_StatusCode read_raw_node(
+    const ring_t *ring,
+    const UA_ReadRawModifiedDetails *details,
+    const UA_TimestampsToReturn timestamps,
+    const UA_ByteString *continuation,
+    UA_ByteString *next_continuation,
+    UA_HistoryData *data)
+{
+    const UA_DateTime start = details->startTime;
+    const UA_DateTime end = details->endTime;
+    const UA_UInt32 max = details->numValuesPerNode;
+
+    // Two of start, end and number of values must be given, see OPC UA Part 11
+    if ((0 == start && 0 == end) || ((0 == start || 0 == end) && 0 == max))
+    {
+        return UA_STATUSCODE_BADHISTORYOPERATIONINVALID;
+    }
+    // Only an end time reads backwards from it, only a start time forwards from it
+    const bool reverse = 0 == start || (0 != end && start > end);
+    const UA_DateTime low = 0 == start || 0 == end ? start : MIN(start, end);
+    const UA_DateTime high = 0 == start || 0 == end ? end : MAX(start, end);
+
+    // The samples to return are [first, last)
+    size_t first = 0 == low ? 0 : ring_search(ring, low, false);
+    size_t last = 0 == high ? ring->size : ring_search(ring, high, true);
+    if (details->returnBounds)
+    {
+        first = 0 < first ? first - 1 : first;
+        last = ring->size > last ? last + 1 : last;
+    }
+
+    // Continue after the last value of the previous read, as long as it is still in the ring
+    const uint64_t oldest = ring->appended - ring->size;
+    if (0 < continuation->length)
+    {
+        uint64_t next;
+        if (sizeof(next) != continuation->length)
+        {
+            return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+        }
+        memcpy(&next, continuation->data, sizeof(next));
+        if (reverse)
+        {
+            last = next < oldest ? 0 : MIN(last, next - oldest + 1);
+        }
+        else
+        {
+            first = next < oldest ? first : MAX(first, next - oldest);
+        }
+    }
+    if (first >= last)
+    {
+        return UA_STATUSCODE_GOODNODATA;
+    }
+
+    size_t count = last - first;
+    const size_t limit = 0 < max && HISTORY_MAX_VALUES > max ? max : HISTORY_MAX_VALUES;
+    if (count > limit)
+    {
+        const uint64_t next = reverse ? oldest + last - 1 - limit : oldest + first + limit;
+        if (UA_STATUSCODE_GOOD != UA_ByteString_allocBuffer(next_continuation, sizeof(next)))
+        {
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+        memcpy(next_continuation->data, &next, sizeof(next));
+        count = limit;
+    }
+
+    data->dataValues = UA_Array_new(count, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    if (NULL == data->dataValues)
+    {
+        UA_ByteString_clear(next_continuation);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    data->dataValuesSize = count;
+
+    cursor_t cursor;
+    cursor_seek(&cursor, ring, reverse ? last - 1 : first);
+    for (size_t i = 0; i < count; i++)
+    {
+        set_value(&data->dataValues[i], ring, cursor_value(&cursor), cursor.time, timestamps);
+        if (reverse)
+        {
+            cursor_prev(&cursor);
+        }
+        else
+        {
+            cursor_next(&cursor);
+        }
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static void read_raw(
+    UA_Server *server,
+    void *hdb_context,
+    const UA_NodeId *session_id,
+    void *session_context,
+    const UA_RequestHeader *request_header,
+    const UA_ReadRawModifiedDetails *details,
+    UA_TimestampsToReturn timestamps,
+    UA_Boolean release_continuation_points,
+    size_t nodes_size,
+    const UA_HistoryReadValueId *nodes,
+    UA_HistoryReadResponse *response,
+    UA_HistoryData *const *const history_data)
+{
+    (void)server;
+    (void)hdb_context;
+    (void)session_id;
+    (void)session_context;
+    (void)request_header;
+
+    for (size_t i = 0; i < nodes_size; i++)
+    {
+        UA_HistoryReadResult *result = &response->results[i];
+        const ring_t *ring = find_ring_by_node(&nodes[i].nodeId);
+        if (NULL == ring)
+        {
+            result->statusCode = UA_STATUSCODE_BADNODEIDUNKNOWN;
+        }
+        else if (release_continuation_points)
+        {
+            // Continuation points hold no state
+            result->statusCode = UA_STATUSCODE_GOOD;
+        }
+        else if (details->isReadModified)
+        {
+            result->statusCode = UA_STATUSCODE_BADHISTORYOPERATIONUNSUPPORTED;
+        }
+        else
+        {
+            result->statusCode = read_raw_node(
+                ring, details, timestamps, &nodes[i].continuationPoint, &result->continuationPoint, history_data[i]);
+        }
+    }
+    response->responseHeader.serviceResult = UA_STATUSCODE_GOOD;
+}
+
+/* The value at a given time, linearly interpolated for temperatures and stepped for ports */
+static void read_at(
+    const ring_t *ring,
+    const UA_DateTime time,
+    const UA_TimestampsToReturn timestamps,
+    UA_DataValue *data_value)
+{
+    const size_t next = ring_search(ring, time, true);
+    if (0 == next)
+    {
+        data_value->hasStatus = true;
+        data_value->status = UA_STATUSCODE_BADNODATA;
+        set_timestamps(data_value, time, timestamps);
+        return;
+    }
+
+    cursor_t cursor;
+    cursor_seek(&cursor, ring, next - 1);
+    double value = cursor_value(&cursor);
+    UA_StatusCode status = UA_STATUSCODE_GOOD;
+    if (cursor.time != time)
+    {
+        if (ring->size == next)
+        {
+            // No later value to interpolate towards
+            status = UA_STATUSCODE_UNCERTAINDATASUBNORMAL;
+        }
+        else
+        {
+            status = UA_STATUSCODE_GOOD | HISTORY_STATUS_INTERPOLATED;
+            if (CHANNEL_TEMP == ring->channel->type)
+            {
+                const UA_DateTime before = cursor.time;
+                cursor_next(&cursor);
+                value += (cursor_value(&cursor) - value) * (double)(time - before) / (double)(cursor.time - before);
+            }
+        }
+    }
+    set_value(data_value, ring, value, time, timestamps);
+    data_value->hasStatus = UA_STATUSCODE_GOOD != status;
+    data_value->status = status;
+}
+
+static void read_at_time(
+    UA_Server *server,
+    void *hdb_context,
+    const UA_NodeId *session_id,
+    void *session_context,
+    const UA_RequestHeader *request_header,
+    const UA_ReadAtTimeDetails *details,
+    UA_TimestampsToReturn timestamps,
+    UA_Boolean release_continuation_points,
+    size_t nodes_size,
+    const UA_HistoryReadValueId *nodes,
+    UA_HistoryReadResponse *response,
+    UA_HistoryData *const *const history_data)
+{
+    (void)server;
+    (void)hdb_context;
+    (void)session_id;
+    (void)session_context;
+    (void)request_header;
+
+    for (size_t i = 0; i < nodes_size; i++)
+    {
+        UA_HistoryReadResult *result = &response->results[i];
+        UA_HistoryData *data = history_data[i];
+        const ring_t *ring = find_ring_by_node(&nodes[i].nodeId);
+        if (NULL == ring)
+        {
+            result->statusCode = UA_STATUSCODE_BADNODEIDUNKNOWN;
+            continue;
+        }
+        if (release_continuation_points || 0 == details->reqTimesSize)
+        {
+            result->statusCode = UA_STATUSCODE_GOOD;
+            continue;
+        }
+        data->dataValues = UA_Array_new(details->reqTimesSize, &UA_TYPES[UA_TYPES_DATAVALUE]);
+        if (NULL == data->dataValues)
+        {
+            result->statusCode = UA_STATUSCODE_BADOUTOFMEMORY;
+            continue;
+        }
+        data->dataValuesSize = details->reqTimesSize;
+        for (size_t j = 0; j < details->reqTimesSize; j++)
+        {
+            read_at(ring, details->reqTimes[j], timestamps, &data->dataValues[j]);
+        }
+        result->statusCode = UA_STATUSCODE_GOOD;
+    }
+    response->responseHeader.serviceResult = UA_STATUSCODE_GOOD;
+}
+
+static void load_pending(history_config_t *config)
+{
+    config->budget = atomic_load(&pending.budget);
+    config->port_delta = atomic_load(&pending.port_delta);
+    config->persist = atomic_load(&pending.persist);
+}
+
+/* Called from the GLib main loop, the new configuration is applied by the UA server thread */
+void history_set_config(const history_config_t *config)
+{
+    assert(NULL != config);
+    atomic_store(&pending.budget, config->budget);
+    atomic_store(&pending.port_delta, config->port_delta);
+    atomic_store(&pending.persist, config->persist);
+    atomic_store_explicit(&pending.changed, true, memory_order_release);
+}
+
+/*
+ * Set up the rings for a new set of channels, keeping the samples of channels
+ * that are still there. The first time, the persisted history is read back.
+ * Must not be called while the UA server thread runs.
+ */
+void history_reset(const channels_t *new_channels)
+{
+    assert(NULL != new_channels);
+
+    atomic_store(&pending.changed, false);
+    load_pending(&current);
+    channels = new_channels;
+    channels_count = new_channels->size;
+    rebuild(channels, channels_count, &current);
+
+    if (current.persist && 0 > file_fd)
+    {
+        bool restorable;
+        if (file_open(file_records_for(current.budget), &restorable) && restorable)
+        {
+            file_restore();
+        }
+    }
+    else if (!current.persist)
+    {
+        file_close();
+    }
+    LOG_I(
+        "%s/%s: %zu bytes of history for %zu channels%s",
+        __FILE__,
+        __FUNCTION__,
+        arena_size,
+        rings_size,
+        0 <= file_fd ? ", persisted in " HISTORY_FILE : "");
+}
+
+/* Apply a changed configuration, called on the UA server thread */
+void history_sync(void)
+{
+    if (!atomic_load_explicit(&pending.changed, memory_order_acquire) || NULL == channels)
+    {
+        return;
+    }
+    atomic_store(&pending.changed, false);
+
+    history_config_t config;
+    load_pending(&config);
+    if (config.budget == current.budget && config.port_delta == current.port_delta &&
+        config.persist == current.persist)
+    {
+        return;
+    }
+    rebuild(channels, channels_count, &config);
+
+    // Start the file over from the rings, it may also have a new size
+    file_close();
+    bool restorable;
+    if (config.persist && file_open(file_records_for(config.budget), &restorable))
+    {
+        file_clear();
+        file_rewrite();
+    }
+    current = config;
+    LOG_I("%s/%s: History now uses %zu bytes", __FILE__, __FUNCTION__, arena_size);
+}
+
+/*
+ * Give the channels that were added to the registry while the server runs a
+ * ring, called on the UA server thread. Removed channels keep theirs, so that
+ * their history is there again when they come back.
+ */
+void history_resize(const size_t count)
+{
+    if (NULL == channels || count <= channels_count)
+    {
+        return;
+    }
+    channels_count = count;
+    rebuild(channels, channels_count, &current);
+    LOG_I("%s/%s: %zu bytes of history for %zu channels", __FILE__, __FUNCTION__, arena_size, rings_size);
+}
+
+void history_cleanup(void)
+{
+    file_close();
+    free_rings(rings, arena, lookup);
+    rings = NULL;
+    arena = NULL;
+    rings_size = 0;
+    arena_size = 0;
+    memset(lookup, 0, sizeof(lookup));
+    memset(lookup_size, 0, sizeof(lookup_size));
+    channels = NULL;
+    channels_count = 0;
+}
+
+void history_attach(UA_ServerConfig *config)
+{
+    assert(NULL != config);
+
+    UA_HistoryDatabase *database = &config->historyDatabase;
+    memset(database, 0, sizeof(*database));
+    database->readRaw = read_raw;
+    database->readAtTime = read_at_time;
+    config->accessHistoryDataCapability = true;
+    config->maxReturnDataValues = HISTORY_MAX_VALUES;
+}
+
+static void append(const channel_t *channel, const UA_DateTime time, const double value)
+{
+    assert(NULL != channel);
+    if (channel->slot >= rings_size)
+    {
+        return;
+    }
+    ring_append(&rings[channel->slot], time, value);
+    appended++;
+    if (NULL != file_map)
+    {
+        file_append(channel, time, value);
+    }
+}
+
+void history_append_temp(const channel_t *channel, UA_DateTime time, double value)
+{
+    append(channel, time, value);
+}
+
+void history_append_port(const channel_t *channel, UA_DateTime time, bool state)
+{
+    append(channel, time, state ? 1.0 : 0.0);
+}
+
+void history_get_stats(history_stats_t *stats)
+{
+    assert(NULL != stats);
+    stats->samples = 0;
+    for (size_t i = 0; i < rings_size; i++)
+    {
+        stats->samples += rings[i].size;
+    }
+    stats->bytes = arena_size;
+    stats->appended = appended;
+    stats->restored = restored;
+}
@@ -0,0 +1,59 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _OPCUA_HISTORY_H_
+#define _OPCUA_HISTORY_H_
+
+#include <open62541/server.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "opcua_channels.h"
+
+/* Where history is persisted, relative to the application directory */
+#define HISTORY_FILE "localdata/history.dat"
+
+/* Max values returned per node and HistoryRead, the rest is read with continuation points */
+#define HISTORY_MAX_VALUES 10000
+
+typedef struct
+{
+    size_t budget;   // bytes for all rings
+    bool port_delta; // delta encode port rings
+    bool persist;    // append all samples to HISTORY_FILE
+} history_config_t;
+
+typedef struct
+{
+    uint64_t samples; // samples in memory
+    size_t bytes;     // bytes used by the rings
+    uint64_t appended;
+    uint64_t restored; // samples read back from HISTORY_FILE
+} history_stats_t;
+
+void history_set_config(const history_config_t *config);
+void history_reset(const channels_t *channels);
+void history_sync(void);
+void history_resize(size_t count);
+void history_cleanup(void);
+void history_attach(UA_ServerConfig *config);
+void history_append_temp(const channel_t *channel, UA_DateTime time, double value);
+void history_append_port(const channel_t *channel, UA_DateTime time, bool state);
+void history_get_stats(history_stats_t *stats);
+
+#endif /* _OPCUA_HISTORY_H_ */
@@ -0,0 +1,144 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <sys/param.h>
+
+#include "opcua_common.h"
+#include "opcua_limits.h"
+
+/*
+ * Rough sizes of what open62541 allocates for a session, used to estimate the
+ * memory that the limits allow. Every session has a secure channel with a send
+ * and a receive buffer of buffer_size.
+ */
+#define LIMITS_SESSION_BYTES 4096
+#define LIMITS_SUBSCRIPTION_BYTES 1024
+#define LIMITS_MONITORED_ITEM_BYTES 320 // item, sampling registration and one queued value
+#define LIMITS_NOTIFICATION_BYTES 64    // per value in a publish response
+
+#define LIMITS_SESSIONS_MAX UINT16_MAX
+
+/* Set from the GLib main loop, applied to the server configuration in limits_sync or limits_apply */
+static pthread_mutex_t pending_mutex = PTHREAD_MUTEX_INITIALIZER;
+static limits_t pending = {
+    .max_sessions = 100,
+    .max_subscriptions = 10,
+    .max_monitored_items = 1000,
+    .max_notifications = 1000,
+    .min_publishing_ms = 100.0,
+    .min_sampling_ms = 50.0,
+    .buffer_size = 65535,
+    .memory_budget = 0,
+};
+static bool pending_changed;
+
+uint64_t limits_session_cost(const limits_t *limits)
+{
+    assert(NULL != limits);
+    const uint64_t subscription = LIMITS_SUBSCRIPTION_BYTES +
+                                  (uint64_t)limits->max_monitored_items * LIMITS_MONITORED_ITEM_BYTES +
+                                  (uint64_t)limits->max_notifications * LIMITS_NOTIFICATION_BYTES;
+    return LIMITS_SESSION_BYTES + 2 * (uint64_t)limits->buffer_size +
+           (uint64_t)limits->max_subscriptions * subscription;
+}
+
+/*
+ * Called from the GLib main loop. When all sessions at their limits would not
+ * fit in the memory budget, fewer sessions are allowed.
+ */
+void limits_set(const limits_t *limits)
+{
+    assert(NULL != limits);
+    limits_t checked = *limits;
+    checked.max_sessions = MIN(MAX(checked.max_sessions, 1), LIMITS_SESSIONS_MAX);
+
+    const uint64_t cost = limits_session_cost(&checked);
+    if (0 < checked.memory_budget && checked.max_sessions * cost > checked.memory_budget)
+    {
+        const uint32_t sessions = (uint32_t)MAX(checked.memory_budget / cost, 1);
+        LOG_W(
+            "%s/%s: %u sessions of %llu kB need %llu kB, over the budget of %llu kB, allowing %u sessions",
+            __FILE__,
+            __FUNCTION__,
+            checked.max_sessions,
+            (unsigned long long)(cost / 1024),
+            (unsigned long long)(checked.max_sessions * cost / 1024),
+            (unsigned long long)(checked.memory_budget / 1024),
+            sessions);
+        checked.max_sessions = sessions;
+    }
+    LOG_I(
+        "%s/%s: Up to %u sessions, estimated %llu kB each and %llu kB in total",
+        __FILE__,
+        __FUNCTION__,
+        checked.max_sessions,
+        (unsigned long long)(cost / 1024),
+        (unsigned long long)(checked.max_sessions * cost / 1024));
+
+    pthread_mutex_lock(&pending_mutex);
+    pending = checked;
+    pending_changed = true;
+    pthread_mutex_unlock(&pending_mutex);
+}
+
+static void apply_service_limits(UA_ServerConfig *config, const limits_t *limits)
+{
+    config->maxSecureChannels = (UA_UInt16)limits->max_sessions;
+    config->maxSessions = (UA_UInt16)limits->max_sessions;
+    config->maxSubscriptionsPerSession = limits->max_subscriptions;
+    config->maxMonitoredItemsPerSubscription = limits->max_monitored_items;
+    config->maxNotificationsPerPublish = limits->max_notifications;
+    config->publishingIntervalLimits.min = limits->min_publishing_ms;
+    config->publishingIntervalLimits.max = MAX(config->publishingIntervalLimits.max, limits->min_publishing_ms);
+    config->samplingIntervalLimits.min = limits->min_sampling_ms;
+    config->samplingIntervalLimits.max = MAX(config->samplingIntervalLimits.max, limits->min_sampling_ms);
+}
+
+/* Apply all limits, must not be called while the UA server thread runs */
+void limits_apply(UA_ServerConfig *config)
+{
+    assert(NULL != config);
+    pthread_mutex_lock(&pending_mutex);
+    const limits_t limits = pending;
+    pending_changed = false;
+    pthread_mutex_unlock(&pending_mutex);
+
+    apply_service_limits(config, &limits);
+    config->tcpBufSize = limits.buffer_size;
+}
+
+/*
+ * Apply changed limits, called on the UA server thread. They are checked when
+ * sessions, subscriptions and monitored items are created or modified, so the
+ * existing ones keep what they have. The buffer size is only used for new
+ * connections once the network layer is restarted, see limits_apply.
+ */
+void limits_sync(UA_Server *server)
+{
+    assert(NULL != server);
+    pthread_mutex_lock(&pending_mutex);
+    const bool changed = pending_changed;
+    const limits_t limits = pending;
+    pending_changed = false;
+    pthread_mutex_unlock(&pending_mutex);
+    if (changed)
+    {
+        apply_service_limits(UA_Server_getConfig(server), &limits);
+    }
+}
@@ -0,0 +1,42 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _OPCUA_LIMITS_H_
+#define _OPCUA_LIMITS_H_
+
+#include <open62541/server.h>
+
+#include <stdint.h>
+
+/* Capacity and publishing limits of the OPC UA server */
+typedef struct
+{
+    uint32_t max_sessions;
+    uint32_t max_subscriptions;   // per session
+    uint32_t max_monitored_items; // per subscription
+    uint32_t max_notifications;   // per publish response
+    double min_publishing_ms;
+    double min_sampling_ms;
+    uint32_t buffer_size;   // bytes, max size of a sent or received chunk
+    uint64_t memory_budget; // bytes for all sessions, 0 for no budget
+} limits_t;
+
+void limits_set(const limits_t *limits);
+uint64_t limits_session_cost(const limits_t *limits);
+void limits_apply(UA_ServerConfig *config);
+void limits_sync(UA_Server *server);
+
+#endif /* _OPCUA_LIMITS_H_ */
@@ -0,0 +1,306 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include "opcua_log.h"
+
+/* Number of messages in the ring (a power of two) and max length of one message */
+#define LOG_RING_SIZE 256
+#define LOG_MSG_LEN 256
+
+/*
+ * Bounded multi-producer/single-consumer ring (Vyukov style). Each slot has a
+ * sequence number that tells whether it is free for the producer at a given
+ * position or holds a message for the consumer.
+ */
+typedef struct
+{
+    atomic_size_t seq;
+    int level;
+    char msg[LOG_MSG_LEN];
+} log_slot_t;
+
+static log_slot_t ring[LOG_RING_SIZE];
+static atomic_size_t enqueue_pos;
+static size_t dequeue_pos;
+static atomic_uint dropped;
+
+static atomic_int log_level = LOG_INFO;
+static atomic_bool running;
+static pthread_t flush_thread;
+static sem_t flush_sem;
+static _Atomic(log_site_t *) sites;
+
+static const struct
+{
+    const char *name;
+    int level;
+} level_names[] = {
+    {"error", LOG_ERR},
+    {"warning", LOG_WARNING},
+    {"info", LOG_INFO},
+    {"debug", LOG_DEBUG},
+};
+
+static int64_t now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+static void output(const int level, const char *msg)
+{
+    syslog(level, "%s", msg);
+    printf("%s\n", msg);
+}
+
+static void register_site(log_site_t *site, const int level, const char *fmt)
+{
+    if (atomic_flag_test_and_set(&site->registered))
+    {
+        return;
+    }
+    site->fmt = fmt;
+    site->level = level;
+    log_site_t *head = atomic_load(&sites);
+    do
+    {
+        site->next = head;
+    } while (!atomic_compare_exchange_weak(&sites, &head, site));
+}
+
+static void enqueue(const int level, const char *fmt, va_list args)
+{
+    size_t pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+    log_slot_t *slot;
+
+    for (;;)
+    {
+        slot = &ring[pos & (LOG_RING_SIZE - 1)];
+        const size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (0 == diff)
+        {
+            if (atomic_compare_exchange_weak_explicit(
+                    &enqueue_pos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (0 > diff)
+        {
+            // Full, the flush thread is behind
+            atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    slot->level = level;
+    vsnprintf(slot->msg, LOG_MSG_LEN, fmt, args);
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    sem_post(&flush_sem);
+}
+
+static bool dequeue(int *level, char *msg)
+{
+    log_slot_t *slot = &ring[dequeue_pos & (LOG_RING_SIZE - 1)];
+    const size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+    if (seq != dequeue_pos + 1)
+    {
+        return false;
+    }
+    *level = slot->level;
+    memcpy(msg, slot->msg, LOG_MSG_LEN);
+    atomic_store_explicit(&slot->seq, dequeue_pos + LOG_RING_SIZE, memory_order_release);
+    dequeue_pos++;
+    return true;
+}
+
+static void report_suppressed(const bool all)
+{
+    const int64_t now = now_s();
+    char msg[LOG_MSG_LEN];
+
+    for (log_site_t *site = atomic_load(&sites); NULL != site; site = site->next)
+    {
+        // Wait for the site's window to close unless we are shutting down
+        if (!all && atomic_load_explicit(&site->window, memory_order_relaxed) + LOG_RATE_INTERVAL_S > now)
+        {
+            continue;
+        }
+        const unsigned int suppressed = atomic_exchange_explicit(&site->suppressed, 0, memory_order_relaxed);
+        if (0 < suppressed)
+        {
+            snprintf(msg, sizeof(msg), "%u messages suppressed like: %s", suppressed, site->fmt);
+            output(site->level, msg);
+        }
+    }
+
+    const unsigned int lost = atomic_exchange_explicit(&dropped, 0, memory_order_relaxed);
+    if (0 < lost)
+    {
+        snprintf(msg, sizeof(msg), "%u log messages dropped (log buffer full)", lost);
+        output(LOG_WARNING, msg);
+    }
+}
+
+static void *flush_messages(void *arg)
+{
+    (void)arg;
+    int level;
+    char msg[LOG_MSG_LEN];
+
+    while (atomic_load(&running))
+    {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += LOG_RATE_INTERVAL_S;
+        (void)sem_timedwait(&flush_sem, &deadline);
+
+        while (dequeue(&level, msg))
+        {
+            output(level, msg);
+        }
+        report_suppressed(false);
+    }
+
+    // Flush what is left before the thread exits
+    while (dequeue(&level, msg))
+    {
+        output(level, msg);
+    }
+    report_suppressed(true);
+    return NULL;
+}
+
+void log_init(void)
+{
+    assert(!atomic_load(&running));
+    for (size_t i = 0; i < LOG_RING_SIZE; i++)
+    {
+        atomic_init(&ring[i].seq, i);
+    }
+    atomic_init(&enqueue_pos, 0);
+    dequeue_pos = 0;
+    sem_init(&flush_sem, 0, 0);
+
+    atomic_store(&running, true);
+    if (0 != pthread_create(&flush_thread, NULL, flush_messages, NULL))
+    {
+        // Keep logging synchronously
+        atomic_store(&running, false);
+        sem_destroy(&flush_sem);
+        output(LOG_ERR, "Failed to create log thread, logging synchronously");
+    }
+}
+
+void log_cleanup(void)
+{
+    if (!atomic_load(&running))
+    {
+        return;
+    }
+    atomic_store(&running, false);
+    sem_post(&flush_sem);
+    pthread_join(flush_thread, NULL);
+    sem_destroy(&flush_sem);
+
+    // Messages that raced with the shutdown
+    int level;
+    char msg[LOG_MSG_LEN];
+    while (dequeue(&level, msg))
+    {
+        output(level, msg);
+    }
+}
+
+void log_set_level(int level)
+{
+    atomic_store_explicit(&log_level, level, memory_order_relaxed);
+}
+
+bool log_set_level_name(const char *name)
+{
+    if (NULL == name)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(level_names) / sizeof(level_names[0]); i++)
+    {
+        if (0 == strcasecmp(name, level_names[i].name))
+        {
+            log_set_level(level_names[i].level);
+            return true;
+        }
+    }
+    return false;
+}
+
+void log_write(log_site_t *site, int level, const char *fmt, ...)
+{
+    assert(NULL != site);
+    assert(NULL != fmt);
+
+    if (level > atomic_load_explicit(&log_level, memory_order_relaxed))
+    {
+        return;
+    }
+
+    register_site(site, level, fmt);
+
+    // Start a new rate limit window for this call site when the old one has passed
+    const int64_t now = now_s();
+    int_fast64_t window = atomic_load_explicit(&site->window, memory_order_relaxed);
+    if (now >= window + LOG_RATE_INTERVAL_S &&
+        atomic_compare_exchange_strong_explicit(
+            &site->window, &window, now, memory_order_relaxed, memory_order_relaxed))
+    {
+        atomic_store_explicit(&site->count, 0, memory_order_relaxed);
+    }
+    if (LOG_RATE_LIMIT <= atomic_fetch_add_explicit(&site->count, 1, memory_order_relaxed))
+    {
+        atomic_fetch_add_explicit(&site->suppressed, 1, memory_order_relaxed);
+        return;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    if (atomic_load_explicit(&running, memory_order_relaxed))
+    {
+        enqueue(level, fmt, args);
+    }
+    else
+    {
+        // Before log_init and after log_cleanup
+        char msg[LOG_MSG_LEN];
+        vsnprintf(msg, sizeof(msg), fmt, args);
+        output(level, msg);
+    }
+    va_end(args);
+}
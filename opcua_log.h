@@ -0,0 +1,47 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _OPCUA_LOG_H_
+#define _OPCUA_LOG_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <syslog.h>
+
+/* Max messages per call site and rate limit interval before they are suppressed */
+#define LOG_RATE_LIMIT 10
+#define LOG_RATE_INTERVAL_S 1
+
+/* Rate limit state, one static instance per LOG call site */
+typedef struct log_site
+{
+    const char *fmt;
+    int level;
+    atomic_flag registered;
+    atomic_int_fast64_t window;
+    atomic_uint count;
+    atomic_uint suppressed;
+    struct log_site *next;
+} log_site_t;
+
+void log_init(void);
+void log_cleanup(void);
+void log_set_level(int level);
+bool log_set_level_name(const char *name);
+void log_write(log_site_t *site, int level, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+
+#endif /* _OPCUA_LOG_H_ */
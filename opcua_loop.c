@@ -0,0 +1,186 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <dirent.h>
+#include <glib.h>
+#include <open62541/plugin/eventloop.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "opcua_common.h"
+#include "opcua_loop.h"
+
+/*
+ * Runs a started server in the GLib main loop instead of on its own thread.
+ * open62541's POSIX event loop waits on an epoll file descriptor for all its
+ * sockets, and an epoll file descriptor is readable when one of them is ready.
+ * The GSource polls it together with the D-Bus connection and wakes for the
+ * event loop's next timer, then runs one non-blocking iteration of the server.
+ * The event loop does not expose the descriptor, so it is the one epoll
+ * descriptor of the process that is new since before the server was created.
+ */
+
+#define LOOP_EPOLL_LINK "anon_inode:[eventpoll]"
+
+typedef struct
+{
+    GSource source;
+    UA_Server *server;
+    UA_EventLoop *event_loop;
+    gpointer tag; // of the epoll file descriptor
+} loop_source_t;
+
+static GSource *attached;
+
+/* Milliseconds until the event loop's next timer, rounded up so that it is due on waking */
+static gint next_timeout_ms(UA_EventLoop *event_loop)
+{
+    const UA_DateTime wait = event_loop->nextCyclicTime(event_loop) - event_loop->dateTime_nowMonotonic(event_loop);
+    if (0 >= wait)
+    {
+        return 0;
+    }
+    return (gint)MIN((wait + UA_DATETIME_MSEC - 1) / UA_DATETIME_MSEC, G_MAXINT);
+}
+
+static gboolean loop_prepare(GSource *source, gint *timeout)
+{
+    loop_source_t *loop = (loop_source_t *)source;
+    *timeout = next_timeout_ms(loop->event_loop);
+    return 0 == *timeout;
+}
+
+static gboolean loop_check(GSource *source)
+{
+    loop_source_t *loop = (loop_source_t *)source;
+    return 0 != (g_source_query_unix_fd(source, loop->tag) & G_IO_IN) || 0 == next_timeout_ms(loop->event_loop);
+}
+
+static gboolean loop_dispatch(GSource *source, GSourceFunc callback, gpointer user_data)
+{
+    (void)callback;
+    (void)user_data;
+    loop_source_t *loop = (loop_source_t *)source;
+    (void)UA_Server_run_iterate(loop->server, false);
+    return G_SOURCE_CONTINUE;
+}
+
+static GSourceFuncs loop_funcs = {
+    .prepare = loop_prepare,
+    .check = loop_check,
+    .dispatch = loop_dispatch,
+};
+
+/* The epoll file descriptors of the process */
+void loop_list_fds(loop_fds_t *fds)
+{
+    assert(NULL != fds);
+    fds->count = 0;
+    DIR *dir = opendir("/proc/self/fd");
+    if (NULL == dir)
+    {
+        LOG_W("%s/%s: Failed to list the file descriptors", __FILE__, __FUNCTION__);
+        return;
+    }
+    const int own = dirfd(dir);
+    const struct dirent *entry;
+    while (NULL != (entry = readdir(dir)) && LOOP_FDS_MAX > fds->count)
+    {
+        char *end;
+        const long fd = strtol(entry->d_name, &end, 10);
+        if (end == entry->d_name || '\0' != *end || own == fd)
+        {
+            continue;
+        }
+        char link[sizeof(LOOP_EPOLL_LINK)];
+        const ssize_t length = readlinkat(own, entry->d_name, link, sizeof(link));
+        if ((ssize_t)sizeof(LOOP_EPOLL_LINK) - 1 == length && 0 == memcmp(link, LOOP_EPOLL_LINK, (size_t)length))
+        {
+            fds->fds[fds->count++] = (int)fd;
+        }
+    }
+    closedir(dir);
+}
+
+/* The one epoll file descriptor that is not in before, -1 if there is none or more than one */
+static int find_new_fd(const loop_fds_t *before)
+{
+    loop_fds_t now;
+    loop_list_fds(&now);
+    int found = -1;
+    for (size_t i = 0; i < now.count; i++)
+    {
+        bool known = false;
+        for (size_t j = 0; j < before->count && !known; j++)
+        {
+            known = now.fds[i] == before->fds[j];
+        }
+        if (known)
+        {
+            continue;
+        }
+        if (0 <= found)
+        {
+            return -1;
+        }
+        found = now.fds[i];
+    }
+    return found;
+}
+
+/* Attach a started server to the default main context, returns false if its event loop cannot be polled */
+bool loop_attach(UA_Server *server, const loop_fds_t *before)
+{
+    assert(NULL != server);
+    assert(NULL != before);
+    assert(NULL == attached);
+
+    const int fd = find_new_fd(before);
+    if (0 > fd)
+    {
+        LOG_W("%s/%s: Failed to find the file descriptor of the server's event loop", __FILE__, __FUNCTION__);
+        return false;
+    }
+    GSource *source = g_source_new(&loop_funcs, sizeof(loop_source_t));
+    loop_source_t *loop = (loop_source_t *)source;
+    loop->server = server;
+    loop->event_loop = UA_Server_getConfig(server)->eventLoop;
+    loop->tag = g_source_add_unix_fd(source, fd, G_IO_IN);
+    g_source_set_name(source, "open62541");
+    (void)g_source_attach(source, NULL);
+    attached = source;
+    LOG_I("%s/%s: Running the UA server in the main loop, event loop file descriptor %d", __FILE__, __FUNCTION__, fd);
+    return true;
+}
+
+/* Stop running the server, it can then be shut down */
+void loop_detach(void)
+{
+    if (NULL == attached)
+    {
+        return;
+    }
+    g_source_destroy(attached);
+    g_source_unref(attached);
+    attached = NULL;
+}
+
+bool loop_is_attached(void)
+{
+    return NULL != attached;
+}
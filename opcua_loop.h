@@ -1,5 +1,5 @@
 /**
- * Copyright (C) 2022, Axis Communications AB, Lund, Sweden
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -14,24 +14,26 @@
  * limitations under the License.
  */
 
-#ifndef _OPCUA_TEMPSENSORS_H_
-#define _OPCUA_TEMPSENSORS_H_
+#ifndef _OPCUA_LOOP_H_
+#define _OPCUA_LOOP_H_
 
-#include <stdint.h>
-#include <stdio.h>
+#include <open62541/server.h>
 
-#define TEMP_LABEL_LEN 16
-#define TEMP_LABEL_FMT "temperature %i"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Most epoll file descriptors remembered from before a server was created */
+#define LOOP_FDS_MAX 16
 
 typedef struct
 {
-    size_t size;
-    uint32_t *subid;
-    char **labels;
-} tempsensors_t;
+    size_t count;
+    int fds[LOOP_FDS_MAX];
+} loop_fds_t;
 
-void tempsensors_init(tempsensors_t **tempsensors, const size_t size);
-void tempsensors_free(tempsensors_t **tempsensors);
-char *tempsensors_get_label_from_subscription(tempsensors_t *tempsensors, const uint32_t subscription_id);
+void loop_list_fds(loop_fds_t *fds);
+bool loop_attach(UA_Server *server, const loop_fds_t *before);
+void loop_detach(void);
+bool loop_is_attached(void);
 
-#endif /* _OPCUA_TEMPSENSORS_H_ */
+#endif /* _OPCUA_LOOP_H_ */
@@ -17,11 +17,591 @@
 #include <assert.h>
 #include <open62541/server_config_default.h>
 #include <pthread.h>
+#include <stdlib.h>
+#include <sys/param.h>
+#include <time.h>
 
+#include "opcua_aggregates.h"
+#include "opcua_alarms.h"
 #include "opcua_common.h"
+#include "opcua_diagnostics.h"
+#include "opcua_events.h"
+#include "opcua_history.h"
+#include "opcua_limits.h"
+#include "opcua_loop.h"
 #include "opcua_open62541.h"
+#include "opcua_poll.h"
+#include "opcua_security.h"
+#include "opcua_snapshot.h"
+#include "opcua_updates.h"
+
+/* How often the server thread drains the update queue and the max batch size per run */
+#define UPDATES_DRAIN_INTERVAL_MS 10
+#define UPDATES_DRAIN_BATCH UPDATES_CAPACITY
+
+/* How often the server syncs settings and publishes its figures when it runs in the GLib main loop */
+#define LOOP_SYNC_INTERVAL_MS 100
+
+/* Node ids in namespace 1 of the update lag object and its variables */
+#define LAG_NODEID 3000
+#define LAG_NODEID_LAST 3001
+#define LAG_NODEID_MEAN 3002
+#define LAG_NODEID_MAX 3003
+#define LAG_NODEID_COUNT 3004
+
+/* Node ids in namespace 1 of the polling object and its variables */
+#define POLL_NODEID 3100
+#define POLL_NODEID_CYCLE_CALLS 3101
+#define POLL_NODEID_MAX_CALLS 3102
+#define POLL_NODEID_POLLED 3103
+#define POLL_NODEID_CALLS 3104
+
+/* Node id in namespace 1 of the SetOutputs method in the Objects folder */
+#define OUTPUTS_METHOD_NODEID 3200
+
+/* Node id in namespace 1 of the diagnostics object, variable v is DIAG_NODEID + 1 + v */
+#define DIAG_NODEID 3500
+
+/* How often the server thread counts the sessions and subscriptions */
+#define DIAG_SAMPLE_MS 1000
+
+/* Variables of the diagnostics object, read from the counters when a client reads them */
+typedef enum
+{
+    DIAG_VAR_SIGNALS_TEMP,
+    DIAG_VAR_SIGNALS_PORT,
+    DIAG_VAR_DECODE_FAILURES,
+    DIAG_VAR_UPDATES_WRITTEN,
+    DIAG_VAR_UPDATES_COALESCED,
+    DIAG_VAR_UPDATES_DROPPED,
+    DIAG_VAR_QUEUE_DEPTH,
+    DIAG_VAR_QUEUE_HIGH_WATER,
+    DIAG_VAR_LATENCY_P50,
+    DIAG_VAR_LATENCY_P90,
+    DIAG_VAR_LATENCY_P99,
+    DIAG_VAR_SESSIONS,
+    DIAG_VAR_SUBSCRIPTIONS,
+    DIAG_VAR_MONITORED_ITEMS,
+    DIAG_VAR_CPU,
+    DIAG_VAR_RSS,
+    DIAG_VARS
+} diag_var_t;
+
+static const char *diag_labels[DIAG_VARS] = {
+    [DIAG_VAR_SIGNALS_TEMP] = "temperature signals",
+    [DIAG_VAR_SIGNALS_PORT] = "port signals",
+    [DIAG_VAR_DECODE_FAILURES] = "decode failures",
+    [DIAG_VAR_UPDATES_WRITTEN] = "updates written",
+    [DIAG_VAR_UPDATES_COALESCED] = "updates coalesced",
+    [DIAG_VAR_UPDATES_DROPPED] = "updates dropped",
+    [DIAG_VAR_QUEUE_DEPTH] = "queue depth",
+    [DIAG_VAR_QUEUE_HIGH_WATER] = "queue high-water",
+    [DIAG_VAR_LATENCY_P50] = "write latency p50",
+    [DIAG_VAR_LATENCY_P90] = "write latency p90",
+    [DIAG_VAR_LATENCY_P99] = "write latency p99",
+    [DIAG_VAR_SESSIONS] = "sessions",
+    [DIAG_VAR_SUBSCRIPTIONS] = "subscriptions",
+    [DIAG_VAR_MONITORED_ITEMS] = "monitored items",
+    [DIAG_VAR_CPU] = "cpu time",
+    [DIAG_VAR_RSS] = "rss"};
+
+/* Range of the temperature sensors, for percent deadbands in monitored item filters */
+#define TEMP_EURANGE_LOW -40.0
+#define TEMP_EURANGE_HIGH 125.0
 
 static UA_Server *server;
+static pthread_t server_thread;
+static UA_UInt64 drain_callback_id;
+static bool pull;               // channel nodes read the snapshot rather than being written
+static bool pull_wanted;        // used by the next ua_server_init
+static bool single_loop;        // the server runs in the GLib main loop rather than on a thread
+static bool single_loop_wanted; // used when the server runs again
+static loop_fds_t init_fds;     // epoll file descriptors from before the server was created
+static snapshot_t snapshot;     // latest values of the channels in pull mode
+static updates_t updates;
+static uint64_t updates_overflows_reported;
+static updates_t transitions; // every port transition, for the events
+static uint64_t transitions_overflows_reported;
+
+/* Written on the server thread, read by ua_server_get_lag_stats from any thread */
+static pthread_mutex_t lag_mutex = PTHREAD_MUTEX_INITIALIZER;
+static ua_lag_stats_t lag;
+static uint64_t lag_published;
+static uint64_t poll_published;
+
+static ua_output_handler_t output_handler;
+
+/* A channel added or removed while the server runs, queued by the GLib main loop */
+typedef struct
+{
+    channel_t *channel;
+    bool add;
+    bool output;  // direction of an added port
+    double value; // initial value of an added channel
+} channel_change_t;
+
+/* Applied on the server thread in drain_updates, in the order they were queued */
+static pthread_mutex_t changes_mutex = PTHREAD_MUTEX_INITIALIZER;
+static channel_change_t *changes;
+static size_t changes_size;
+static size_t changes_capacity;
+
+/* Sampled on the server thread, read by the diagnostics */
+static atomic_uint_fast64_t diag_sessions;
+static atomic_uint_fast64_t diag_subscriptions;
+static int64_t diag_sampled;
+
+/* Monotonic time of the last write of each channel slot that no read has seen yet, 0 once read */
+#define WRITTEN_SLOTS (CHANNEL_TYPES * CHANNELS_MAX_PER_TYPE)
+static atomic_int_fast64_t written[WRITTEN_SLOTS];
+
+/* Time on the UA server's clock for a CLOCK_REALTIME time in ns */
+static UA_DateTime to_datetime(const int64_t real_ns)
+{
+    return UA_DATETIME_UNIX_EPOCH + real_ns / 100;
+}
+
+static void add_stat_object(const UA_UInt32 id, const char *label, const char *description)
+{
+    UA_ObjectAttributes attr = UA_ObjectAttributes_default;
+    attr.description = UA_LOCALIZEDTEXT("en-US", (char *)description);
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", (char *)label);
+    UA_Server_addObjectNode(
+        server,
+        UA_NODEID_NUMERIC(CHANNEL_NAMESPACE, id),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+        UA_QUALIFIEDNAME(CHANNEL_NAMESPACE, (char *)label),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+        attr,
+        NULL,
+        NULL);
+}
+
+static void add_stat_variable(const UA_UInt32 parent, const UA_UInt32 id, const char *label, const UA_DataType *type)
+{
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.description = UA_LOCALIZEDTEXT("en-US", (char *)label);
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", (char *)label);
+    attr.dataType = type->typeId;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+    UA_Server_addVariableNode(
+        server,
+        UA_NODEID_NUMERIC(CHANNEL_NAMESPACE, id),
+        UA_NODEID_NUMERIC(CHANNEL_NAMESPACE, parent),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+        UA_QUALIFIEDNAME(CHANNEL_NAMESPACE, (char *)label),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+        attr,
+        NULL,
+        NULL);
+}
+
+static bool diag_is_double(const diag_var_t var)
+{
+    return DIAG_VAR_LATENCY_P50 == var || DIAG_VAR_LATENCY_P90 == var || DIAG_VAR_LATENCY_P99 == var ||
+           DIAG_VAR_CPU == var;
+}
+
+/* Sums the per-thread counters, so that the threads that count never share a cache line */
+static UA_StatusCode read_diagnostics(
+    UA_Server *ua_server,
+    const UA_NodeId *session_id,
+    void *session_context,
+    const UA_NodeId *node_id,
+    void *node_context,
+    UA_Boolean source_timestamp,
+    const UA_NumericRange *range,
+    UA_DataValue *value)
+{
+    (void)ua_server;
+    (void)session_id;
+    (void)session_context;
+    (void)node_context;
+    (void)range;
+    if (UA_NODEIDTYPE_NUMERIC != node_id->identifierType || DIAG_NODEID >= node_id->identifier.numeric ||
+        DIAG_NODEID + DIAG_VARS < node_id->identifier.numeric)
+    {
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+    }
+    const diag_var_t var = (diag_var_t)(node_id->identifier.numeric - DIAG_NODEID - 1);
+    UA_UInt64 count = 0;
+    UA_Double number = 0.0;
+    updates_stats_t stats;
+    diag_process_t process = {0};
+
+    switch (var)
+    {
+    case DIAG_VAR_SIGNALS_TEMP:
+        count = diagnostics_get(DIAG_SIGNALS_TEMP);
+        break;
+    case DIAG_VAR_SIGNALS_PORT:
+        count = diagnostics_get(DIAG_SIGNALS_PORT);
+        break;
+    case DIAG_VAR_DECODE_FAILURES:
+        count = diagnostics_get(DIAG_DECODE_FAILURES);
+        break;
+    case DIAG_VAR_UPDATES_WRITTEN:
+        count = diagnostics_get(DIAG_UPDATES_WRITTEN);
+        break;
+    case DIAG_VAR_UPDATES_COALESCED:
+        count = diagnostics_get(DIAG_UPDATES_COALESCED);
+        break;
+    case DIAG_VAR_UPDATES_DROPPED:
+    case DIAG_VAR_QUEUE_DEPTH:
+    case DIAG_VAR_QUEUE_HIGH_WATER:
+        updates_get_stats(&updates, &stats);
+        count = DIAG_VAR_UPDATES_DROPPED == var ? stats.overflows
+                : DIAG_VAR_QUEUE_DEPTH == var   ? stats.depth
+                                                : stats.high_water;
+        break;
+    case DIAG_VAR_LATENCY_P50:
+        number = diagnostics_latency_percentile(DIAG_STAGE_TOTAL, 50.0);
+        break;
+    case DIAG_VAR_LATENCY_P90:
+        number = diagnostics_latency_percentile(DIAG_STAGE_TOTAL, 90.0);
+        break;
+    case DIAG_VAR_LATENCY_P99:
+        number = diagnostics_latency_percentile(DIAG_STAGE_TOTAL, 99.0);
+        break;
+    case DIAG_VAR_SESSIONS:
+        count = atomic_load_explicit(&diag_sessions, memory_order_relaxed);
+        break;
+    case DIAG_VAR_SUBSCRIPTIONS:
+        count = atomic_load_explicit(&diag_subscriptions, memory_order_relaxed);
+        break;
+    case DIAG_VAR_MONITORED_ITEMS:
+        count = diagnostics_get(DIAG_MONITORED_ITEMS);
+        break;
+    case DIAG_VAR_CPU:
+    case DIAG_VAR_RSS:
+        if (!diagnostics_get_process(&process))
+        {
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+        number = process.cpu_s;
+        count = process.rss_kb;
+        break;
+    default:
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+    }
+
+    UA_StatusCode status = diag_is_double(var)
+                               ? UA_Variant_setScalarCopy(&value->value, &number, &UA_TYPES[UA_TYPES_DOUBLE])
+                               : UA_Variant_setScalarCopy(&value->value, &count, &UA_TYPES[UA_TYPES_UINT64]);
+    value->hasValue = UA_STATUSCODE_GOOD == status;
+    if (source_timestamp)
+    {
+        value->sourceTimestamp = UA_DateTime_now();
+        value->hasSourceTimestamp = true;
+    }
+    return status;
+}
+
+static void add_diagnostics_nodes(void)
+{
+    add_stat_object(DIAG_NODEID, "Diagnostics", "Counters of the signal to server write pipeline");
+    UA_DataSource source = {.read = read_diagnostics, .write = NULL};
+    for (size_t i = 0; i < DIAG_VARS; i++)
+    {
+        char *label = (char *)diag_labels[i];
+        UA_VariableAttributes attr = UA_VariableAttributes_default;
+        attr.description = UA_LOCALIZEDTEXT("en-US", label);
+        attr.displayName = UA_LOCALIZEDTEXT("en-US", label);
+        const bool is_double = diag_is_double((diag_var_t)i);
+        attr.dataType = is_double ? UA_TYPES[UA_TYPES_DOUBLE].typeId : UA_TYPES[UA_TYPES_UINT64].typeId;
+        attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+        // No node context, which would make the monitored item callback take the node for a channel
+        UA_Server_addDataSourceVariableNode(
+            server,
+            UA_NODEID_NUMERIC(CHANNEL_NAMESPACE, DIAG_NODEID + 1 + i),
+            UA_NODEID_NUMERIC(CHANNEL_NAMESPACE, DIAG_NODEID),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+            UA_QUALIFIEDNAME(CHANNEL_NAMESPACE, label),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+            attr,
+            source,
+            NULL,
+            NULL);
+    }
+}
+
+static void add_stat_nodes(void)
+{
+    add_stat_object(LAG_NODEID, "update lag", "D-Bus signal to server write lag in ms");
+    add_stat_variable(LAG_NODEID, LAG_NODEID_LAST, "last", &UA_TYPES[UA_TYPES_DOUBLE]);
+    add_stat_variable(LAG_NODEID, LAG_NODEID_MEAN, "mean", &UA_TYPES[UA_TYPES_DOUBLE]);
+    add_stat_variable(LAG_NODEID, LAG_NODEID_MAX, "max", &UA_TYPES[UA_TYPES_DOUBLE]);
+    add_stat_variable(LAG_NODEID, LAG_NODEID_COUNT, "count", &UA_TYPES[UA_TYPES_UINT64]);
+
+    add_stat_object(POLL_NODEID, "polling", "D-Bus polls for channels without signals");
+    add_stat_variable(POLL_NODEID, POLL_NODEID_CYCLE_CALLS, "calls per cycle", &UA_TYPES[UA_TYPES_UINT32]);
+    add_stat_variable(POLL_NODEID, POLL_NODEID_MAX_CALLS, "max calls per cycle", &UA_TYPES[UA_TYPES_UINT32]);
+    add_stat_variable(POLL_NODEID, POLL_NODEID_POLLED, "polled channels", &UA_TYPES[UA_TYPES_UINT32]);
+    add_stat_variable(POLL_NODEID, POLL_NODEID_CALLS, "calls", &UA_TYPES[UA_TYPES_UINT64]);
+
+    add_diagnostics_nodes();
+}
+
+static void write_stat_value(const UA_UInt32 id, void *value, const UA_DataType *type)
+{
+    UA_Variant variant;
+    UA_Variant_setScalar(&variant, value, type);
+    (void)UA_Server_writeValue(server, UA_NODEID_NUMERIC(CHANNEL_NAMESPACE, id), variant);
+}
+
+/* Publish the lag once per drain rather than once per update */
+static void publish_lag(void)
+{
+    if (lag_published == lag.count)
+    {
+        return;
+    }
+    UA_Double last = lag.last_us / 1000.0;
+    UA_Double mean = lag.mean_us / 1000.0;
+    UA_Double max = lag.max_us / 1000.0;
+    UA_UInt64 count = lag.count;
+    write_stat_value(LAG_NODEID_LAST, &last, &UA_TYPES[UA_TYPES_DOUBLE]);
+    write_stat_value(LAG_NODEID_MEAN, &mean, &UA_TYPES[UA_TYPES_DOUBLE]);
+    write_stat_value(LAG_NODEID_MAX, &max, &UA_TYPES[UA_TYPES_DOUBLE]);
+    write_stat_value(LAG_NODEID_COUNT, &count, &UA_TYPES[UA_TYPES_UINT64]);
+    lag_published = lag.count;
+}
+
+/* Publish the poll counters once per poll cycle */
+static void publish_poll(void)
+{
+    poll_stats_t stats;
+    poll_get_stats(&stats);
+    if (poll_published == stats.cycles)
+    {
+        return;
+    }
+    UA_UInt32 cycle_calls = stats.cycle_calls;
+    UA_UInt32 max_calls = stats.max_calls;
+    UA_UInt32 polled = stats.polled;
+    UA_UInt64 calls = stats.calls;
+    write_stat_value(POLL_NODEID_CYCLE_CALLS, &cycle_calls, &UA_TYPES[UA_TYPES_UINT32]);
+    write_stat_value(POLL_NODEID_MAX_CALLS, &max_calls, &UA_TYPES[UA_TYPES_UINT32]);
+    write_stat_value(POLL_NODEID_POLLED, &polled, &UA_TYPES[UA_TYPES_UINT32]);
+    write_stat_value(POLL_NODEID_CALLS, &calls, &UA_TYPES[UA_TYPES_UINT64]);
+    poll_published = stats.cycles;
+}
+
+static int64_t mono_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void record_lag(const update_time_t *received, const int64_t written_ns)
+{
+    const int64_t lag_ns = written_ns - received->mono_ns;
+    const uint64_t lag_us = 0 < lag_ns ? (uint64_t)lag_ns / 1000 : 0;
+    diagnostics_record_latency(DIAG_STAGE_TOTAL, lag_ns);
+
+    pthread_mutex_lock(&lag_mutex);
+    lag.count++;
+    lag.last_us = lag_us;
+    lag.mean_us += ((double)lag_us - lag.mean_us) / (double)lag.count;
+    lag.max_us = MAX(lag.max_us, lag_us);
+    pthread_mutex_unlock(&lag_mutex);
+}
+
+/* A new value that clients can read, from any thread */
+static void record_written(const channel_t *channel, const update_time_t *received, const int64_t written_ns)
+{
+    diagnostics_count(DIAG_UPDATES_WRITTEN);
+    record_lag(received, written_ns);
+    if (channel->slot < WRITTEN_SLOTS)
+    {
+        atomic_store_explicit(&written[channel->slot], written_ns, memory_order_relaxed);
+    }
+}
+
+/*
+ * Channels whose value is kept in the snapshot, from the GLib main loop. Port
+ * values are kept in both modes, as output port nodes read them.
+ */
+static bool stores_snapshot(const channel_t *channel)
+{
+    return pull || CHANNEL_PORT == channel->type;
+}
+
+/*
+ * Nodes that are data sources reading the snapshot, all of them in pull mode.
+ * Output port nodes always are, so that a write reports whether the port was set.
+ * From the server thread, which owns channel->output.
+ */
+static bool reads_snapshot(const channel_t *channel)
+{
+    return pull || (CHANNEL_PORT == channel->type && channel->output);
+}
+
+static void write_update(const update_t *update, void *user_data)
+{
+    (void)user_data;
+    const channel_t *channel = update->channel;
+    UA_DataValue newvalue;
+    UA_StatusCode status;
+
+    UA_DataValue_init(&newvalue);
+    switch (channel->type)
+    {
+    case CHANNEL_TEMP:
+        UA_Variant_setScalar(&newvalue.value, (void *)&update->value.temp, &UA_TYPES[UA_TYPES_DOUBLE]);
+        break;
+    case CHANNEL_PORT:
+        UA_Variant_setScalar(&newvalue.value, (void *)&update->value.state, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    default:
+        assert(false);
+        return;
+    }
+    newvalue.hasValue = true;
+    newvalue.sourceTimestamp = to_datetime(update->received.real_ns);
+    newvalue.hasSourceTimestamp = true;
+    newvalue.serverTimestamp = UA_DateTime_now();
+    newvalue.hasServerTimestamp = true;
+    const int64_t start_ns = diagnostics_now_ns();
+    diagnostics_record_latency(DIAG_STAGE_QUEUE, start_ns - update->queued_ns);
+
+    // In pull mode the nodes already read the value, it was stored when it was queued
+    if (!pull)
+    {
+        // Output port nodes read the snapshot in both modes. A failed write must not keep the value from the history.
+        status = UA_STATUSCODE_GOOD;
+        if (!reads_snapshot(channel))
+        {
+            status = UA_Server_writeDataValue(server, channel->node_id, newvalue);
+        }
+        if (UA_STATUSCODE_GOOD != status)
+        {
+            LOG_E("%s/%s: Failed to write %s (%s)", __FILE__, __FUNCTION__, channel->label, UA_StatusCode_name(status));
+        }
+        const int64_t written_ns = diagnostics_now_ns();
+        diagnostics_record_latency(DIAG_STAGE_WRITE, written_ns - start_ns);
+        record_written(channel, &update->received, written_ns);
+    }
+
+    if (CHANNEL_TEMP == channel->type)
+    {
+        history_append_temp(channel, newvalue.sourceTimestamp, update->value.temp);
+        aggregates_add(channel, update->received.mono_ns, update->value.temp);
+        alarms_check(server, channel, update->value.temp, newvalue.sourceTimestamp);
+    }
+    else
+    {
+        history_append_port(channel, newvalue.sourceTimestamp, update->value.state);
+    }
+}
+
+static void send_transition(const update_t *update, void *user_data)
+{
+    (void)user_data;
+    events_port_transition(server, update);
+}
+
+/* Report overflows here rather than in the producer, once per drain */
+static void report_overflows(updates_t *queue, const char *name, uint64_t *reported)
+{
+    updates_stats_t stats;
+    updates_get_stats(queue, &stats);
+    if (stats.overflows != *reported)
+    {
+        LOG_E(
+            "%s/%s: %s queue full, dropped %llu (%llu in total, high-water %zu of %u)",
+            __FILE__,
+            __FUNCTION__,
+            name,
+            (unsigned long long)(stats.overflows - *reported),
+            (unsigned long long)stats.overflows,
+            stats.high_water,
+            UPDATES_CAPACITY);
+        *reported = stats.overflows;
+    }
+}
+
+/*
+ * Sample the session and subscription counts of the server at most every
+ * DIAG_SAMPLE_MS, from the drain callback. The diagnostics nodes read them from
+ * here, as their read callbacks run inside a service and must not call into the
+ * server.
+ */
+static void sample_server_counts(const int64_t now_ns)
+{
+    if (now_ns - diag_sampled < (int64_t)DIAG_SAMPLE_MS * 1000000)
+    {
+        return;
+    }
+    diag_sampled = now_ns;
+
+    const UA_ServerStatistics statistics = UA_Server_getStatistics(server);
+    const uint64_t sessions = statistics.ss.currentSessionCount;
+    uint64_t subscriptions = 0;
+#ifdef UA_ENABLE_DIAGNOSTICS
+    const UA_NodeId count_id =
+        UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERDIAGNOSTICS_SERVERDIAGNOSTICSSUMMARY_CURRENTSUBSCRIPTIONCOUNT);
+    UA_Variant value;
+    UA_Variant_init(&value);
+    if (UA_STATUSCODE_GOOD == UA_Server_readValue(server, count_id, &value) &&
+        UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_UINT32]))
+    {
+        subscriptions = *(UA_UInt32 *)value.data;
+    }
+    UA_Variant_clear(&value);
+#endif
+    atomic_store_explicit(&diag_sessions, sessions, memory_order_relaxed);
+    atomic_store_explicit(&diag_subscriptions, subscriptions, memory_order_relaxed);
+}
+
+static void apply_channel_changes(void);
+
+static void drain_updates(UA_Server *ua_server, void *data)
+{
+    (void)data;
+    limits_sync(ua_server);
+    apply_channel_changes();
+    history_sync();
+    aggregates_sync(ua_server);
+    alarms_sync(ua_server);
+    (void)updates_drain(&transitions, send_transition, NULL, UPDATES_DRAIN_BATCH);
+    (void)updates_drain(&updates, write_update, NULL, UPDATES_DRAIN_BATCH);
+    publish_lag();
+    publish_poll();
+    const int64_t now_ns = mono_ns();
+    aggregates_publish(ua_server, now_ns);
+    sample_server_counts(now_ns);
+    report_overflows(&updates, "Update", &updates_overflows_reported);
+    report_overflows(&transitions, "Port transition", &transitions_overflows_reported);
+}
+
+/* Logged when the server stops */
+static void log_exit_stats(void)
+{
+    updates_stats_t stats;
+    updates_get_stats(&updates, &stats);
+    LOG_I(
+        "%s/%s: Update queue pushed %llu, dropped %llu, depth %zu, high-water %zu of %u",
+        __FILE__,
+        __FUNCTION__,
+        (unsigned long long)stats.pushed,
+        (unsigned long long)stats.overflows,
+        stats.depth,
+        stats.high_water,
+        UPDATES_CAPACITY);
+
+    ua_lag_stats_t lag_stats;
+    ua_server_get_lag_stats(&lag_stats);
+    LOG_I(
+        "%s/%s: Update lag mean %.3f ms, max %.3f ms over %llu updates",
+        __FILE__,
+        __FUNCTION__,
+        lag_stats.mean_us / 1000.0,
+        lag_stats.max_us / 1000.0,
+        (unsigned long long)lag_stats.count);
+}
 
 static void *run_ua_server(void *running)
 {
@@ -31,26 +611,441 @@ static void *run_ua_server(void *running)
     LOG_I("%s/%s: Starting UA server ...", __FILE__, __FUNCTION__);
     UA_StatusCode status = UA_Server_run(server, running);
     LOG_I("%s/%s: UA Server exit status: %s", __FILE__, __FUNCTION__, UA_StatusCode_name(status));
-    UA_Server_delete(server);
-    server = NULL;
+    log_exit_stats();
     return NULL;
 }
 
+/* Channel nodes have their channel as node context */
+static void on_monitored_item(
+    UA_Server *ua_server,
+    const UA_NodeId *session_id,
+    void *session_context,
+    const UA_NodeId *node_id,
+    void *node_context,
+    UA_UInt32 attribute_id,
+    UA_Boolean removed)
+{
+    (void)ua_server;
+    (void)session_id;
+    (void)session_context;
+    (void)node_id;
+    diagnostics_add(DIAG_MONITORED_ITEMS, removed ? -1 : 1);
+    if (NULL != node_context && UA_ATTRIBUTEID_VALUE == attribute_id)
+    {
+        poll_watch(node_context, !removed);
+    }
+}
+
+/* The first read of a channel's value after a write tells how long the new value waited for a client */
+static void record_sample(const channel_t *channel)
+{
+    if (NULL == channel || WRITTEN_SLOTS <= channel->slot ||
+        0 == atomic_load_explicit(&written[channel->slot], memory_order_relaxed))
+    {
+        return;
+    }
+    const int64_t written_ns = atomic_exchange_explicit(&written[channel->slot], 0, memory_order_relaxed);
+    if (0 != written_ns)
+    {
+        diagnostics_record_latency(DIAG_STAGE_SAMPLE, diagnostics_now_ns() - written_ns);
+    }
+}
+
+/*
+ * Value callback before every read of a channel's value, also when a monitored
+ * item samples it. The first read after a write tells how long the new value
+ * waited for a client.
+ */
+static void on_value_read(
+    UA_Server *ua_server,
+    const UA_NodeId *session_id,
+    void *session_context,
+    const UA_NodeId *node_id,
+    void *node_context,
+    const UA_NumericRange *range,
+    const UA_DataValue *data)
+{
+    (void)ua_server;
+    (void)session_id;
+    (void)session_context;
+    (void)node_id;
+    (void)range;
+    (void)data;
+    record_sample(node_context);
+}
+
+/* Read callback of the channel nodes that are data sources */
+static UA_StatusCode read_snapshot(
+    UA_Server *ua_server,
+    const UA_NodeId *session_id,
+    void *session_context,
+    const UA_NodeId *node_id,
+    void *node_context,
+    UA_Boolean source_timestamp,
+    const UA_NumericRange *range,
+    UA_DataValue *value)
+{
+    (void)ua_server;
+    (void)session_id;
+    (void)session_context;
+    (void)node_id;
+    const channel_t *channel = node_context;
+    snapshot_value_t stored;
+    if (NULL != range)
+    {
+        return UA_STATUSCODE_BADINDEXRANGENODATA;
+    }
+    if (NULL == channel || !snapshot_load(&snapshot, channel->slot, &stored))
+    {
+        return UA_STATUSCODE_BADWAITINGFORINITIALDATA;
+    }
+    record_sample(channel);
+
+    UA_StatusCode status;
+    if (CHANNEL_TEMP == channel->type)
+    {
+        status = UA_Variant_setScalarCopy(&value->value, &stored.value, &UA_TYPES[UA_TYPES_DOUBLE]);
+    }
+    else
+    {
+        const UA_Boolean state = 0.0 != stored.value;
+        status = UA_Variant_setScalarCopy(&value->value, &state, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    }
+    value->hasValue = UA_STATUSCODE_GOOD == status;
+    if (source_timestamp)
+    {
+        value->sourceTimestamp = to_datetime(stored.source_ns);
+        value->hasSourceTimestamp = true;
+    }
+    value->serverTimestamp = to_datetime(stored.server_ns);
+    value->hasServerTimestamp = true;
+    return status;
+}
+
+static UA_StatusCode set_output(const channel_t *channel, const UA_DataValue *data)
+{
+    if (NULL == channel || !channel->output)
+    {
+        return UA_STATUSCODE_BADNOTWRITABLE;
+    }
+    if (!data->hasValue || !UA_Variant_hasScalarType(&data->value, &UA_TYPES[UA_TYPES_BOOLEAN]))
+    {
+        return UA_STATUSCODE_BADTYPEMISMATCH;
+    }
+    const UA_Boolean state = *(const UA_Boolean *)data->value.data;
+    if (NULL == output_handler || !output_handler(channel->index, state))
+    {
+        LOG_E("%s/%s: Failed to set %s", __FILE__, __FUNCTION__, channel->label);
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/*
+ * Write callback of output port nodes, the write fails when the port could not
+ * be set. The node changes when the state has been read back.
+ */
+static UA_StatusCode write_output(
+    UA_Server *ua_server,
+    const UA_NodeId *session_id,
+    void *session_context,
+    const UA_NodeId *node_id,
+    void *node_context,
+    const UA_NumericRange *range,
+    const UA_DataValue *data)
+{
+    (void)ua_server;
+    (void)session_id;
+    (void)session_context;
+    (void)node_id;
+    if (NULL != range)
+    {
+        return UA_STATUSCODE_BADINDEXRANGEINVALID;
+    }
+    return set_output(node_context, data);
+}
+
+static UA_StatusCode request_output(UA_Server *ua_server, const UA_UInt32 port, const UA_Boolean state)
+{
+    void *context = NULL;
+    if (CHANNELS_MAX_PER_TYPE <= port ||
+        UA_STATUSCODE_GOOD != UA_Server_getNodeContext(
+                                  ua_server,
+                                  UA_NODEID_NUMERIC(CHANNEL_NAMESPACE, CHANNEL_NODEID_PORT_BASE + port),
+                                  &context) ||
+        NULL == context)
+    {
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+    }
+    const channel_t *channel = context;
+    if (!channel->output)
+    {
+        return UA_STATUSCODE_BADNOTWRITABLE;
+    }
+    if (NULL == output_handler || !output_handler(port, state))
+    {
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/*
+ * SetOutputs(Ports, States) -> Results: sets several output ports with one
+ * call. The ports are set one after the other, each result tells whether its
+ * port was set, and the port nodes get the read back states.
+ */
+static UA_StatusCode set_outputs(
+    UA_Server *ua_server,
+    const UA_NodeId *session_id,
+    void *session_context,
+    const UA_NodeId *method_id,
+    void *method_context,
+    const UA_NodeId *object_id,
+    void *object_context,
+    size_t input_size,
+    const UA_Variant *input,
+    size_t output_size,
+    UA_Variant *output)
+{
+    (void)session_id;
+    (void)session_context;
+    (void)method_id;
+    (void)method_context;
+    (void)object_id;
+    (void)object_context;
+    if (2 != input_size || 1 != output_size || !UA_Variant_hasArrayType(&input[0], &UA_TYPES[UA_TYPES_UINT32]) ||
+        !UA_Variant_hasArrayType(&input[1], &UA_TYPES[UA_TYPES_BOOLEAN]) ||
+        input[0].arrayLength != input[1].arrayLength)
+    {
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    }
+
+    const size_t count = input[0].arrayLength;
+    const UA_UInt32 *ports = input[0].data;
+    const UA_Boolean *states = input[1].data;
+    UA_StatusCode *results = UA_Array_new(count, &UA_TYPES[UA_TYPES_STATUSCODE]);
+    if (NULL == results)
+    {
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        results[i] = request_output(ua_server, ports[i], states[i]);
+    }
+    UA_Variant_setArray(output, results, count, &UA_TYPES[UA_TYPES_STATUSCODE]);
+    return UA_STATUSCODE_GOOD;
+}
+
+static void add_output_method(void)
+{
+    UA_Argument inputs[2];
+    UA_Argument_init(&inputs[0]);
+    inputs[0].name = UA_STRING("Ports");
+    inputs[0].description = UA_LOCALIZEDTEXT("en-US", "Output port numbers");
+    inputs[0].dataType = UA_TYPES[UA_TYPES_UINT32].typeId;
+    inputs[0].valueRank = UA_VALUERANK_ONE_DIMENSION;
+    UA_Argument_init(&inputs[1]);
+    inputs[1].name = UA_STRING("States");
+    inputs[1].description = UA_LOCALIZEDTEXT("en-US", "New state of each port");
+    inputs[1].dataType = UA_TYPES[UA_TYPES_BOOLEAN].typeId;
+    inputs[1].valueRank = UA_VALUERANK_ONE_DIMENSION;
+
+    UA_Argument result;
+    UA_Argument_init(&result);
+    result.name = UA_STRING("Results");
+    result.description = UA_LOCALIZEDTEXT("en-US", "Whether each port is being set");
+    result.dataType = UA_TYPES[UA_TYPES_STATUSCODE].typeId;
+    result.valueRank = UA_VALUERANK_ONE_DIMENSION;
+
+    UA_MethodAttributes attr = UA_MethodAttributes_default;
+    attr.description = UA_LOCALIZEDTEXT("en-US", "Set several output ports at once");
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "SetOutputs");
+    attr.executable = true;
+    attr.userExecutable = true;
+    UA_Server_addMethodNode(
+        server,
+        UA_NODEID_NUMERIC(CHANNEL_NAMESPACE, OUTPUTS_METHOD_NODEID),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+        UA_QUALIFIEDNAME(CHANNEL_NAMESPACE, "SetOutputs"),
+        attr,
+        set_outputs,
+        2,
+        inputs,
+        1,
+        &result,
+        NULL,
+        NULL);
+}
+
+static bool add_callback(void)
+{
+    // In the main loop updates are written as they come, the callback only syncs and publishes
+    const UA_Double interval = single_loop ? LOOP_SYNC_INTERVAL_MS : UPDATES_DRAIN_INTERVAL_MS;
+    UA_StatusCode status = UA_Server_addRepeatedCallback(server, drain_updates, NULL, interval, &drain_callback_id);
+    if (UA_STATUSCODE_GOOD != status)
+    {
+        LOG_E("%s/%s: Failed to add update callback (%s)", __FILE__, __FUNCTION__, UA_StatusCode_name(status));
+        return false;
+    }
+    return true;
+}
+
+/* Returns true if the mode changed, which takes a new server */
+bool ua_server_set_pull(bool enabled)
+{
+    const bool changed = enabled != pull_wanted;
+    pull_wanted = enabled;
+    return changed;
+}
+
+/* Returns true if the mode changed, it is used when the server runs again */
+bool ua_server_set_single_loop(bool enabled)
+{
+    const bool changed = enabled != single_loop_wanted;
+    single_loop_wanted = enabled;
+    return changed;
+}
+
 void ua_server_init(const UA_UInt16 port)
 {
     assert(NULL == server);
+    pull = pull_wanted;
+    single_loop = single_loop_wanted;
+    loop_list_fds(&init_fds);
     server = UA_Server_new();
     assert(NULL != server);
-    UA_ServerConfig_setMinimal(UA_Server_getConfig(server), port, NULL);
+
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_ServerConfig_setMinimal(config, port, NULL);
+    security_apply(config);
+    limits_apply(config);
+    history_attach(config);
+    config->monitoredItemRegisterCallback = on_monitored_item;
+    add_stat_nodes();
+    add_output_method();
+    events_add_types(server);
+    (void)add_callback();
+
+    // The server thread is not running yet, so it is safe to reset the queue and the lag
+    updates_init(&updates);
+    updates_overflows_reported = 0;
+    updates_init(&transitions);
+    transitions_overflows_reported = 0;
+    pthread_mutex_lock(&lag_mutex);
+    memset(&lag, 0, sizeof(lag));
+    pthread_mutex_unlock(&lag_mutex);
+    lag_published = 0;
+    poll_published = 0;
+}
+
+void ua_server_cleanup(void)
+{
+    assert(!loop_is_attached());
+    if (NULL != server)
+    {
+        UA_Server_delete(server);
+        server = NULL;
+    }
+    snapshot_free(&snapshot);
+
+    // Changes that the server did not apply are for channels of the next launch
+    pthread_mutex_lock(&changes_mutex);
+    free(changes);
+    changes = NULL;
+    changes_size = 0;
+    changes_capacity = 0;
+    pthread_mutex_unlock(&changes_mutex);
+}
+
+/*
+ * Move the stopped server to a new port, or give it new limits. The nodes and
+ * their values are kept and updates queued while the server was stopped are
+ * written when it runs again, so only the network layer is restarted. A new
+ * node mode or security setup needs a new server, and false is returned.
+ */
+bool ua_server_rebind(const UA_UInt16 port)
+{
+    assert(NULL != server);
+    if (pull_wanted != pull)
+    {
+        LOG_I(
+            "%s/%s: Nodes in %s mode instead of %s",
+            __FILE__,
+            __FUNCTION__,
+            pull_wanted ? "pull" : "write",
+            pull ? "pull" : "write");
+        return false;
+    }
+    if (security_changed())
+    {
+        LOG_I("%s/%s: New certificates or security settings", __FILE__, __FUNCTION__);
+        return false;
+    }
+    single_loop = single_loop_wanted;
+
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    char url[32];
+    snprintf(url, sizeof(url), "opc.tcp://:%u", port);
+    UA_String *urls = UA_Array_new(1, &UA_TYPES[UA_TYPES_STRING]);
+    if (NULL == urls)
+    {
+        LOG_E("%s/%s: Failed to allocate server URL", __FILE__, __FUNCTION__);
+        return false;
+    }
+    urls[0] = UA_STRING_ALLOC(url);
+    UA_Array_delete(config->serverUrls, config->serverUrlsSize, &UA_TYPES[UA_TYPES_STRING]);
+    config->serverUrls = urls;
+    config->serverUrlsSize = 1;
+    limits_apply(config);
+
+    // Make sure the callback is scheduled exactly once in the restarted event loop
+    UA_Server_removeRepeatedCallback(server, drain_callback_id);
+    return add_callback();
+}
+
+/* Start the server in the GLib main loop, returns false to run it on a thread instead */
+static bool start_in_loop(void)
+{
+    LOG_I("%s/%s: Starting UA server in the main loop ...", __FILE__, __FUNCTION__);
+    const UA_StatusCode status = UA_Server_run_startup(server);
+    if (UA_STATUSCODE_GOOD != status)
+    {
+        LOG_E("%s/%s: Failed to start UA server (%s)", __FILE__, __FUNCTION__, UA_StatusCode_name(status));
+        return false;
+    }
+    if (!loop_attach(server, &init_fds))
+    {
+        (void)UA_Server_run_shutdown(server);
+        return false;
+    }
+
+    // Updates queued until now are older than the ones written at once from now on
+    (void)updates_drain(&transitions, send_transition, NULL, UPDATES_DRAIN_BATCH);
+    (void)updates_drain(&updates, write_update, NULL, UPDATES_DRAIN_BATCH);
+    return true;
 }
 
-bool ua_server_run(pthread_t *thread_id, UA_Boolean *running)
+/*
+ * Start the server thread, it runs until running is cleared and ua_server_join
+ * returns. The server runs in the GLib main loop instead if that was asked for.
+ */
+bool ua_server_run(UA_Boolean *running)
 {
     assert(NULL != server);
-    assert(NULL != thread_id);
     assert(NULL != running);
 
-    int result = pthread_create(thread_id, NULL, run_ua_server, (void *)running);
+    if (single_loop && start_in_loop())
+    {
+        return true;
+    }
+    if (single_loop)
+    {
+        LOG_W("%s/%s: Running the UA server on its own thread", __FILE__, __FUNCTION__);
+        single_loop = false;
+        (void)UA_Server_changeRepeatedCallbackInterval(server, drain_callback_id, UPDATES_DRAIN_INTERVAL_MS);
+    }
+    int result = pthread_create(&server_thread, NULL, run_ua_server, (void *)running);
     LOG_I("%s/%s: pthread_create result is %i", __FILE__, __FUNCTION__, result);
     if (0 != result)
     {
@@ -60,82 +1055,382 @@ bool ua_server_run(pthread_t *thread_id, UA_Boolean *running)
     return true;
 }
 
-void ua_server_add_bool(char *label, UA_Boolean state)
+void ua_server_join(void)
 {
-    assert(NULL != server);
-    assert(NULL != label);
+    if (loop_is_attached())
+    {
+        loop_detach();
+        const UA_StatusCode status = UA_Server_run_shutdown(server);
+        LOG_I("%s/%s: UA Server exit status: %s", __FILE__, __FUNCTION__, UA_StatusCode_name(status));
+        log_exit_stats();
+        return;
+    }
+    pthread_join(server_thread, NULL);
+}
 
-    // Define attributes
-    UA_VariableAttributes attr = UA_VariableAttributes_default;
+/* The initial value has no signal time, so it gets the time it was added */
+static void write_initial(const channel_t *channel, const UA_Variant *value, const UA_DateTime time)
+{
+    UA_DataValue data_value;
+    UA_DataValue_init(&data_value);
+    data_value.value = *value;
+    data_value.hasValue = true;
+    data_value.sourceTimestamp = time;
+    data_value.hasSourceTimestamp = true;
+    data_value.serverTimestamp = time;
+    data_value.hasServerTimestamp = true;
+    (void)UA_Server_writeDataValue(server, channel->node_id, data_value);
+}
 
-    UA_Variant_setScalar(&attr.value, &state, &UA_TYPES[UA_TYPES_BOOLEAN]);
+/* The value that the channel's data source nodes read from now on, stored on the GLib main loop */
+static void store_snapshot(const channel_t *channel, const double value, const update_time_t *received)
+{
+    update_time_t now;
+    updates_time_now(&now);
+    const snapshot_value_t stored = {.value = value, .source_ns = received->real_ns, .server_ns = now.real_ns};
+    // In push mode the value counts as written when the server has taken it, see write_update
+    if (snapshot_store(&snapshot, channel->slot, &stored) && pull)
+    {
+        record_written(channel, received, now.mono_ns);
+    }
+}
 
-    attr.description = UA_LOCALIZEDTEXT("en-US", label);
-    attr.displayName = UA_LOCALIZEDTEXT("en-US", label);
-    attr.dataType = UA_TYPES[UA_TYPES_BOOLEAN].typeId;
-    attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+static void add_snapshot(const channel_t *channel, const double value)
+{
+    if (!stores_snapshot(channel))
+    {
+        return;
+    }
+    if (!snapshot_add(&snapshot, channel->slot))
+    {
+        LOG_E("%s/%s: Failed to add %s to the snapshot", __FILE__, __FUNCTION__, channel->label);
+        return;
+    }
+    update_time_t now;
+    updates_time_now(&now);
+    const snapshot_value_t stored = {.value = value, .source_ns = now.real_ns, .server_ns = now.real_ns};
+    (void)snapshot_store(&snapshot, channel->slot, &stored);
+}
 
-    // Add the variable node to the information model
-    UA_NodeId node_id = UA_NODEID_STRING(1, label);
-    UA_QualifiedName name = UA_QUALIFIEDNAME(1, label);
+/*
+ * The node of a channel in the Objects folder. It is either written with
+ * every update, or in pull mode a data source that reads the snapshot, so
+ * that an update costs the server nothing until a client reads it. Output
+ * port nodes are data sources in both modes, so that a write can fail.
+ */
+static void add_channel_node(const channel_t *channel, const UA_VariableAttributes *attr, const UA_DateTime now)
+{
+    UA_QualifiedName name = UA_QUALIFIEDNAME(1, (char *)channel->label);
     UA_NodeId parent_node_id = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
     UA_NodeId parent_ref_node_id = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    if (reads_snapshot(channel))
+    {
+        UA_DataSource source = {.read = read_snapshot, .write = channel->output ? write_output : NULL};
+        UA_Server_addDataSourceVariableNode(
+            server,
+            channel->node_id,
+            parent_node_id,
+            parent_ref_node_id,
+            name,
+            UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+            *attr,
+            source,
+            (void *)channel,
+            NULL);
+        return;
+    }
+
     UA_Server_addVariableNode(
         server,
-        node_id,
+        channel->node_id,
         parent_node_id,
         parent_ref_node_id,
         name,
         UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
-        attr,
-        NULL,
+        *attr,
+        (void *)channel,
         NULL);
+    write_initial(channel, &attr->value, now);
+    UA_ValueCallback callback = {.onRead = on_value_read, .onWrite = NULL};
+    UA_Server_setVariableNode_valueCallback(server, channel->node_id, callback);
 }
 
-void ua_server_add_double(char *label, UA_Double value)
+static void add_port_nodes(const channel_t *channel, UA_Boolean state)
 {
-    assert(NULL != server);
-    assert(NULL != label);
+    char *label = (char *)channel->label;
 
     // Define attributes
     UA_VariableAttributes attr = UA_VariableAttributes_default;
-    UA_Variant_setScalar(&attr.value, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
+
+    UA_Variant_setScalar(&attr.value, &state, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    const UA_DateTime now = UA_DateTime_now();
+
     attr.description = UA_LOCALIZEDTEXT("en-US", label);
     attr.displayName = UA_LOCALIZEDTEXT("en-US", label);
-    attr.dataType = UA_TYPES[UA_TYPES_DOUBLE].typeId;
-    attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+    attr.dataType = UA_TYPES[UA_TYPES_BOOLEAN].typeId;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_HISTORYREAD;
+    if (channel->output)
+    {
+        attr.accessLevel |= UA_ACCESSLEVELMASK_WRITE;
+    }
+    attr.historizing = true;
 
-    // Add the variable node to the information model
-    UA_NodeId node_id = UA_NODEID_STRING(1, label);
-    UA_QualifiedName name = UA_QUALIFIEDNAME(1, label);
-    UA_NodeId parent_node_id = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
-    UA_NodeId parent_ref_node_id = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    add_channel_node(channel, &attr, now);
+    history_append_port(channel, now, state);
+}
+
+void ua_server_add_bool(const channel_t *channel, UA_Boolean state)
+{
+    assert(NULL != server);
+    assert(NULL != channel);
+    add_snapshot(channel, state ? 1.0 : 0.0);
+    add_port_nodes(channel, state);
+}
+
+/* The EURange property is what the server computes a percent deadband from */
+static void add_eurange(const channel_t *channel)
+{
+    UA_Range range = {.low = TEMP_EURANGE_LOW, .high = TEMP_EURANGE_HIGH};
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Variant_setScalar(&attr.value, &range, &UA_TYPES[UA_TYPES_RANGE]);
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "EURange");
+    attr.dataType = UA_TYPES[UA_TYPES_RANGE].typeId;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ;
     UA_Server_addVariableNode(
         server,
-        node_id,
-        parent_node_id,
-        parent_ref_node_id,
-        name,
-        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+        UA_NODEID_NULL,
+        channel->node_id,
+        UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY),
+        UA_QUALIFIEDNAME(0, "EURange"),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_PROPERTYTYPE),
         attr,
         NULL,
         NULL);
 }
 
-void ua_server_update_port(char *label, UA_Boolean state)
+static void add_temp_nodes(const channel_t *channel, UA_Double value)
+{
+    char *label = (char *)channel->label;
+
+    // Define attributes
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Variant_setScalar(&attr.value, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
+    const UA_DateTime now = UA_DateTime_now();
+    attr.description = UA_LOCALIZEDTEXT("en-US", label);
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", label);
+    attr.dataType = UA_TYPES[UA_TYPES_DOUBLE].typeId;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_HISTORYREAD;
+    attr.historizing = true;
+
+    add_channel_node(channel, &attr, now);
+    add_eurange(channel);
+    aggregates_add_nodes(server, channel);
+    alarms_add_nodes(server, channel);
+    history_append_temp(channel, now, value);
+    aggregates_add(channel, mono_ns(), value);
+    alarms_check(server, channel, value, now);
+}
+
+void ua_server_add_double(const channel_t *channel, UA_Double value)
+{
+    assert(NULL != server);
+    assert(NULL != channel);
+    add_snapshot(channel, value);
+    add_temp_nodes(channel, value);
+}
+
+static bool queue_change(const channel_change_t *change)
+{
+    pthread_mutex_lock(&changes_mutex);
+    if (changes_size == changes_capacity)
+    {
+        const size_t capacity = 0 < changes_capacity ? 2 * changes_capacity : 16;
+        channel_change_t *grown = realloc(changes, capacity * sizeof(*changes));
+        if (NULL == grown)
+        {
+            pthread_mutex_unlock(&changes_mutex);
+            return false;
+        }
+        changes = grown;
+        changes_capacity = capacity;
+    }
+    changes[changes_size++] = *change;
+    pthread_mutex_unlock(&changes_mutex);
+
+    // In the main loop the server is on this thread and the change is applied at once
+    if (loop_is_attached())
+    {
+        apply_channel_changes();
+    }
+    return true;
+}
+
+/*
+ * Called from the GLib main loop while the server runs, for a channel that
+ * was added to the registry or came back. Its nodes are added on the server
+ * thread, the other nodes and their monitored items are left alone.
+ */
+bool ua_server_add_channel(channel_t *channel, bool output, UA_Double value)
 {
     assert(NULL != server);
-    UA_Variant newvalue;
-    UA_Variant_setScalar(&newvalue, &state, &UA_TYPES[UA_TYPES_BOOLEAN]);
-    UA_NodeId currentNodeId = UA_NODEID_STRING(1, label);
-    UA_Server_writeValue(server, currentNodeId, newvalue);
+    assert(NULL != channel);
+    add_snapshot(channel, value);
+    const channel_change_t change = {.channel = channel, .add = true, .output = output, .value = value};
+    return queue_change(&change);
 }
 
-void ua_server_update_temp(char *label, UA_Double value)
+/* Called from the GLib main loop for a channel that is gone, its nodes are deleted on the server thread */
+bool ua_server_remove_channel(channel_t *channel)
 {
     assert(NULL != server);
-    UA_Variant newvalue;
-    UA_Variant_setScalar(&newvalue, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
-    UA_NodeId currentNodeId = UA_NODEID_STRING(1, label);
-    UA_Server_writeValue(server, currentNodeId, newvalue);
+    assert(NULL != channel);
+    const channel_change_t change = {.channel = channel, .add = false};
+    return queue_change(&change);
+}
+
+static void remove_channel_nodes(const channel_t *channel)
+{
+    alarms_remove_channel(server, channel);
+    aggregates_remove_channel(server, channel);
+    // Also deletes the children, monitored items of the node get a bad status
+    UA_StatusCode status = UA_Server_deleteNode(server, channel->node_id, true);
+    if (UA_STATUSCODE_GOOD != status)
+    {
+        LOG_W(
+            "%s/%s: Failed to delete the node of %s (%s)",
+            __FILE__,
+            __FUNCTION__,
+            channel->label,
+            UA_StatusCode_name(status));
+    }
+    atomic_store_explicit(&written[channel->slot], 0, memory_order_relaxed);
+}
+
+/* Runs on the server thread */
+static void apply_channel_changes(void)
+{
+    pthread_mutex_lock(&changes_mutex);
+    channel_change_t *applied = changes;
+    const size_t count = changes_size;
+    changes = NULL;
+    changes_size = 0;
+    changes_capacity = 0;
+    pthread_mutex_unlock(&changes_mutex);
+
+    // New slots need a ring before their initial value is appended
+    size_t slots = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (applied[i].add)
+        {
+            slots = MAX(slots, (size_t)applied[i].channel->slot + 1);
+        }
+    }
+    history_resize(slots);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        channel_t *channel = applied[i].channel;
+        if (!applied[i].add)
+        {
+            remove_channel_nodes(channel);
+            LOG_I("%s/%s: Removed %s", __FILE__, __FUNCTION__, channel->label);
+            continue;
+        }
+        // No node refers to the channel now, so its direction can change
+        channel->output = applied[i].output;
+        if (CHANNEL_TEMP == channel->type)
+        {
+            aggregates_add_channel(channel);
+            alarms_add_channel(channel);
+            add_temp_nodes(channel, applied[i].value);
+        }
+        else
+        {
+            add_port_nodes(channel, 0.0 != applied[i].value);
+        }
+        LOG_I("%s/%s: Added %s", __FILE__, __FUNCTION__, channel->label);
+    }
+    free(applied);
+}
+
+/*
+ * The update functions are called from the GLib main loop. They only queue the
+ * new value, the writes are done on the UA server's thread in drain_updates.
+ * When that server runs in the main loop the value is written at once instead.
+ * In pull mode, and for ports, they also store it in the snapshot, which data
+ * source nodes read.
+ */
+static bool submit(updates_t *queue, const update_t *update, const updates_handler_t handler)
+{
+    if (loop_is_attached())
+    {
+        handler(update, NULL);
+        return true;
+    }
+    return updates_push(queue, update);
+}
+
+bool ua_server_update_port(const channel_t *channel, UA_Boolean state, const update_time_t *received)
+{
+    assert(NULL != channel);
+    assert(NULL != received);
+    if (stores_snapshot(channel))
+    {
+        store_snapshot(channel, state ? 1.0 : 0.0, received);
+    }
+    update_t update = {.channel = channel, .received = *received, .value.state = state};
+    update.queued_ns = diagnostics_now_ns();
+    diagnostics_record_latency(DIAG_STAGE_HOLD, update.queued_ns - received->mono_ns);
+    return submit(&updates, &update, write_update);
+}
+
+/* Every signaled port transition, sent as an event rather than coalesced like the port's value */
+bool ua_server_port_transition(
+    const channel_t *channel,
+    bool state,
+    bool activelow,
+    bool virtual,
+    const update_time_t *received)
+{
+    assert(NULL != channel);
+    assert(NULL != received);
+    update_t update = {.channel = channel, .received = *received};
+    update.value.transition.state = state;
+    update.value.transition.activelow = activelow;
+    update.value.transition.virtual = virtual;
+    return submit(&transitions, &update, send_transition);
+}
+
+bool ua_server_update_temp(const channel_t *channel, UA_Double value, const update_time_t *received)
+{
+    assert(NULL != channel);
+    assert(NULL != received);
+    if (pull)
+    {
+        store_snapshot(channel, value, received);
+    }
+    update_t update = {.channel = channel, .received = *received, .value.temp = value};
+    update.queued_ns = diagnostics_now_ns();
+    diagnostics_record_latency(DIAG_STAGE_HOLD, update.queued_ns - received->mono_ns);
+    return submit(&updates, &update, write_update);
+}
+
+/* Called before the server runs */
+void ua_server_set_output_handler(ua_output_handler_t handler)
+{
+    output_handler = handler;
+}
+
+void ua_server_get_update_stats(updates_stats_t *stats)
+{
+    updates_get_stats(&updates, stats);
+}
+
+void ua_server_get_lag_stats(ua_lag_stats_t *stats)
+{
+    assert(NULL != stats);
+    pthread_mutex_lock(&lag_mutex);
+    *stats = lag;
+    pthread_mutex_unlock(&lag_mutex);
 }
@@ -19,12 +19,43 @@
 
 #include <open62541/server.h>
 
+#include "opcua_channels.h"
+#include "opcua_updates.h"
+
+/* Time from D-Bus signal to the write of the value on the server thread, in us */
+typedef struct
+{
+    uint64_t count;
+    uint64_t last_us;
+    uint64_t max_us;
+    double mean_us;
+} ua_lag_stats_t;
+
+bool ua_server_set_pull(bool enabled);
+bool ua_server_set_single_loop(bool enabled);
 void ua_server_init(const UA_UInt16 port);
-bool ua_server_run(pthread_t *thread_id, UA_Boolean *running);
+void ua_server_cleanup(void);
+bool ua_server_rebind(const UA_UInt16 port);
+bool ua_server_run(UA_Boolean *running);
+void ua_server_join(void);
+
+void ua_server_add_bool(const channel_t *channel, UA_Boolean state);
+void ua_server_add_double(const channel_t *channel, UA_Double value);
+bool ua_server_add_channel(channel_t *channel, bool output, UA_Double value);
+bool ua_server_remove_channel(channel_t *channel);
+bool ua_server_update_port(const channel_t *channel, UA_Boolean state, const update_time_t *received);
+bool ua_server_update_temp(const channel_t *channel, UA_Double value, const update_time_t *received);
+bool ua_server_port_transition(
+    const channel_t *channel,
+    bool state,
+    bool activelow,
+    bool virtual,
+    const update_time_t *received);
+/* Called on the server thread when a client sets an output port, returns false if the port was not set */
+typedef bool (*ua_output_handler_t)(uint32_t port, bool state);
 
-void ua_server_add_bool(char *label, UA_Boolean state);
-void ua_server_add_double(char *label, UA_Double value);
-void ua_server_update_port(char *label, UA_Boolean state);
-void ua_server_update_temp(char *label, UA_Double value);
+void ua_server_set_output_handler(ua_output_handler_t handler);
+void ua_server_get_update_stats(updates_stats_t *stats);
+void ua_server_get_lag_stats(ua_lag_stats_t *stats);
 
 #endif /* _OPCUA_OPEN62541_H_ */
@@ -0,0 +1,109 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <glib.h>
+
+#include "opcua_common.h"
+#include "opcua_dbus.h"
+#include "opcua_outputs.h"
+
+/*
+ * Output ports are set by clients on the UA server threads. The port is set
+ * with a SetState call on the client's thread, so that the write or method
+ * call reports whether the device took it, and its state is then read back
+ * with an asynchronous GetState on the GLib main loop, which owns the D-Bus
+ * signals. The port's node gets the read back state.
+ */
+
+typedef struct
+{
+    uint32_t port;
+    bool state;
+    update_time_t requested;
+} request_t;
+
+static outputs_confirm_t confirm_callback = NULL;
+
+void outputs_init(outputs_confirm_t confirm)
+{
+    confirm_callback = confirm;
+}
+
+static void on_read_back(bool ok, bool state, gpointer user_data)
+{
+    request_t *request = user_data;
+    if (!ok)
+    {
+        LOG_E("%s/%s: No state for port %u after setting it", __FILE__, __FUNCTION__, request->port);
+        g_free(request);
+        return;
+    }
+
+    update_time_t received;
+    updates_time_now(&received);
+    if (state != request->state)
+    {
+        LOG_W(
+            "%s/%s: Port %u is %s after setting it %s",
+            __FILE__,
+            __FUNCTION__,
+            request->port,
+            state ? "active" : "inactive",
+            request->state ? "active" : "inactive");
+    }
+    LOG_D(
+        "%s/%s: Port %u confirmed after %.3f ms",
+        __FILE__,
+        __FUNCTION__,
+        request->port,
+        (received.mono_ns - request->requested.mono_ns) / 1000000.0);
+    if (NULL != confirm_callback)
+    {
+        confirm_callback(request->port, state, &received);
+    }
+    g_free(request);
+}
+
+static gboolean read_back(gpointer data)
+{
+    request_t *request = data;
+    dbus_port_get_state_async((int)request->port, on_read_back, request);
+    return G_SOURCE_REMOVE;
+}
+
+/* Called from any thread, returns false if the port was not set */
+bool outputs_set(uint32_t port, bool state)
+{
+    request_t *request = g_try_new(request_t, 1);
+    if (NULL == request)
+    {
+        LOG_E("%s/%s: No memory to set port %u", __FILE__, __FUNCTION__, port);
+        return false;
+    }
+    request->port = port;
+    request->state = state;
+    updates_time_now(&request->requested);
+    if (!dbus_port_set_state((int)port, state))
+    {
+        g_free(request);
+        return false;
+    }
+
+    // Ahead of the signals and polls that wait on the main loop, or at once on a server in the main loop
+    g_main_context_invoke_full(NULL, G_PRIORITY_HIGH, read_back, request, NULL);
+    return true;
+}
@@ -1,5 +1,5 @@
 /**
- * Copyright (C) 2022, Axis Communications AB, Lund, Sweden
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -14,24 +14,18 @@
  * limitations under the License.
  */
 
-#ifndef _OPCUA_PORTSIO_H_
-#define _OPCUA_PORTSIO_H_
+#ifndef _OPCUA_OUTPUTS_H_
+#define _OPCUA_OUTPUTS_H_
 
+#include <stdbool.h>
 #include <stdint.h>
-#include <stdio.h>
 
-#define PORT_LABEL_LEN 8
-#define PORT_LABEL_FMT "port %i"
+#include "opcua_updates.h"
 
-typedef struct
-{
-    size_t size;
-    uint32_t *subid;
-    char **labels;
-} ports_t;
+/* Called on the GLib main loop with the state read back from an output port after setting it */
+typedef void (*outputs_confirm_t)(uint32_t port, bool state, const update_time_t *received);
 
-void ports_init(ports_t **ports, const size_t size);
-void ports_free(ports_t **ports);
-char *ports_get_label_from_subscription(ports_t *ports, const uint32_t subscription_id);
+void outputs_init(outputs_confirm_t confirm);
+bool outputs_set(uint32_t port, bool state);
 
-#endif /* _OPCUA_PORTSIO_H_ */
+#endif /* _OPCUA_OUTPUTS_H_ */
@@ -0,0 +1,352 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdatomic.h>
+
+#include "opcua_coalesce.h"
+#include "opcua_common.h"
+#include "opcua_dbus.h"
+#include "opcua_poll.h"
+
+/*
+ * Channels normally get their values from D-Bus signals (push). Each of them
+ * is still polled every POLL_VERIFY_MS, and a polled value that differs from
+ * the last signalled one means that signals got lost: the channel is then
+ * polled (poll) until the next signal arrives. Channels without a working
+ * subscription are polled from the start.
+ *
+ * Everything but poll_watch and poll_get_stats runs on the GLib main loop.
+ */
+
+typedef enum
+{
+    MODE_PUSH,
+    MODE_POLL
+} poll_mode_t;
+
+typedef struct
+{
+    const channel_t *channel;
+    poll_mode_t mode;
+    bool in_flight;
+    bool has_value;
+    double value;     // last value from a signal or a poll
+    double tolerance; // polled values closer than this to a signalled value are not a miss
+    guint interval_ms;
+    gint64 due;       // monotonic time in us of the next poll
+    gint64 last_push; // monotonic time in us of the last signal
+} node_t;
+
+/* One poll in flight, stale when the nodes were reset in the meantime */
+typedef struct
+{
+    guint generation;
+    size_t slot;
+    gint64 issued;
+} call_t;
+
+static node_t *nodes = NULL; // indexed by channel slot
+static atomic_uint *watchers = NULL;
+static size_t nodes_size = 0;
+static size_t cursor = 0; // round robin start of the next cycle
+static guint generation = 0;
+static guint cycle_id = 0;
+static atomic_uint max_calls = 16;
+
+static atomic_uint_fast64_t stat_cycles;
+static atomic_uint_fast64_t stat_calls;
+static atomic_uint stat_cycle_calls;
+static atomic_uint stat_polled;
+
+static node_t *node_get(const channel_t *channel)
+{
+    assert(NULL != channel);
+    assert(channel->slot < nodes_size);
+    return &nodes[channel->slot];
+}
+
+static void node_set_mode(node_t *node, const poll_mode_t mode, const gint64 now)
+{
+    if (mode == node->mode)
+    {
+        return;
+    }
+    node->mode = mode;
+    if (MODE_POLL == mode)
+    {
+        node->interval_ms = POLL_CYCLE_MS;
+        node->due = now;
+        atomic_fetch_add_explicit(&stat_polled, 1, memory_order_relaxed);
+    }
+    else
+    {
+        node->due = now + (gint64)POLL_VERIFY_MS * 1000;
+        atomic_fetch_sub_explicit(&stat_polled, 1, memory_order_relaxed);
+    }
+}
+
+/* Poll faster while the value changes, slower while it does not and slowest when no client monitors it */
+static void node_adapt(node_t *node, const bool changed)
+{
+    if (0 == atomic_load_explicit(&watchers[node->channel->slot], memory_order_relaxed))
+    {
+        node->interval_ms = POLL_INTERVAL_MAX_MS;
+    }
+    else if (changed)
+    {
+        node->interval_ms = MAX(node->interval_ms / 2, POLL_CYCLE_MS);
+    }
+    else
+    {
+        node->interval_ms = MIN(node->interval_ms + node->interval_ms / 2, POLL_INTERVAL_MAX_MS);
+    }
+}
+
+static void on_polled(node_t *node, const double value)
+{
+    const gint64 now = g_get_monotonic_time();
+    const bool changed = !node->has_value || fabs(value - node->value) > node->tolerance;
+
+    if (MODE_PUSH == node->mode)
+    {
+        node->due = now + (gint64)POLL_VERIFY_MS * 1000;
+        if (!changed)
+        {
+            return;
+        }
+        LOG_W("%s/%s: %s changed without a signal, polling it", __FILE__, __FUNCTION__, node->channel->label);
+        node_set_mode(node, MODE_POLL, now);
+    }
+    node_adapt(node, changed);
+    node->due = now + (gint64)node->interval_ms * 1000;
+    node->has_value = true;
+    node->value = value;
+
+    update_time_t received;
+    updates_time_now(&received);
+    if (CHANNEL_TEMP == node->channel->type)
+    {
+        coalesce_temp(node->channel, value, &received);
+    }
+    else
+    {
+        coalesce_port(node->channel, 0.0 != value, &received);
+    }
+}
+
+/* The node of a finished call, or NULL if the result must be ignored */
+static node_t *call_finish(const call_t *call, const bool ok)
+{
+    node_t *node = call->generation == generation ? &nodes[call->slot] : NULL;
+    if (NULL == node || NULL == node->channel)
+    {
+        return NULL;
+    }
+    node->in_flight = false;
+    if (!ok)
+    {
+        // Try again after a full interval rather than in the next cycle
+        const gint64 interval_ms = MODE_POLL == node->mode ? node->interval_ms : POLL_VERIFY_MS;
+        node->due = g_get_monotonic_time() + interval_ms * 1000;
+        return NULL;
+    }
+    // A signal that arrived after the poll was sent is newer than the polled value
+    return node->last_push > call->issued ? NULL : node;
+}
+
+static void on_temp_polled(bool ok, double value, gpointer user_data)
+{
+    call_t *call = user_data;
+    node_t *node = call_finish(call, ok);
+    if (NULL != node)
+    {
+        on_polled(node, value);
+    }
+    g_free(call);
+}
+
+static void on_state_polled(bool ok, bool state, gpointer user_data)
+{
+    call_t *call = user_data;
+    node_t *node = call_finish(call, ok);
+    if (NULL != node)
+    {
+        on_polled(node, state ? 1.0 : 0.0);
+    }
+    g_free(call);
+}
+
+/* Start all due polls of a cycle at once, at most max_calls, round robin so that none starves */
+static gboolean on_cycle(G_GNUC_UNUSED gpointer user_data)
+{
+    const gint64 now = g_get_monotonic_time();
+    const guint limit = atomic_load_explicit(&max_calls, memory_order_relaxed);
+    guint calls = 0;
+    size_t i;
+
+    for (i = 0; i < nodes_size && calls < limit; i++)
+    {
+        node_t *node = &nodes[(cursor + i) % nodes_size];
+        if (NULL == node->channel || node->in_flight || node->due > now)
+        {
+            continue;
+        }
+        call_t *call = g_new(call_t, 1);
+        call->generation = generation;
+        call->slot = node->channel->slot;
+        call->issued = now;
+        node->in_flight = true;
+        if (CHANNEL_TEMP == node->channel->type)
+        {
+            dbus_temp_get_value_async(node->channel->index, on_temp_polled, call);
+        }
+        else
+        {
+            dbus_port_get_state_async(node->channel->index, on_state_polled, call);
+        }
+        calls++;
+    }
+    cursor = 0 < nodes_size ? (cursor + i) % nodes_size : 0;
+
+    atomic_fetch_add_explicit(&stat_cycles, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stat_calls, calls, memory_order_relaxed);
+    atomic_store_explicit(&stat_cycle_calls, calls, memory_order_relaxed);
+    return G_SOURCE_CONTINUE;
+}
+
+void poll_reset(const size_t capacity)
+{
+    poll_cleanup();
+    nodes = g_new0(node_t, capacity);
+    watchers = g_new0(atomic_uint, capacity);
+    nodes_size = capacity;
+    cycle_id = g_timeout_add(POLL_CYCLE_MS, on_cycle, NULL);
+}
+
+void poll_cleanup(void)
+{
+    // Polls still in flight see the new generation and are dropped
+    generation++;
+    g_clear_handle_id(&cycle_id, g_source_remove);
+    g_free(nodes);
+    g_free(watchers);
+    nodes = NULL;
+    watchers = NULL;
+    nodes_size = 0;
+    cursor = 0;
+    atomic_store(&stat_polled, 0);
+}
+
+void poll_set_max_calls(guint calls)
+{
+    assert(0 < calls);
+    atomic_store_explicit(&max_calls, calls, memory_order_relaxed);
+}
+
+/* Start to check or poll a channel, push is false if it has no working subscription */
+void poll_add(const channel_t *channel, bool push, double value)
+{
+    node_t *node = node_get(channel);
+    const gint64 now = g_get_monotonic_time();
+
+    node->channel = channel;
+    node->mode = MODE_PUSH;
+    node->has_value = true;
+    node->value = value;
+    node->due = now + (gint64)POLL_VERIFY_MS * 1000;
+    if (!push)
+    {
+        LOG_W("%s/%s: No signals for %s, polling it", __FILE__, __FUNCTION__, channel->label);
+        node_set_mode(node, MODE_POLL, now);
+    }
+}
+
+/* Stop to check or poll a channel that is gone, a poll in flight is dropped when it returns */
+void poll_remove(const channel_t *channel)
+{
+    node_t *node = node_get(channel);
+    if (NULL == node->channel)
+    {
+        return;
+    }
+    node_set_mode(node, MODE_PUSH, g_get_monotonic_time());
+    node->channel = NULL;
+    node->in_flight = false;
+    node->has_value = false;
+}
+
+void poll_set_tolerance(const channel_t *channel, double tolerance)
+{
+    node_get(channel)->tolerance = tolerance;
+}
+
+/* A value from a signal, which means that the channel gets signals */
+void poll_pushed(const channel_t *channel, double value)
+{
+    node_t *node = node_get(channel);
+    if (NULL == node->channel)
+    {
+        // Not published (yet)
+        return;
+    }
+    const gint64 now = g_get_monotonic_time();
+    if (MODE_POLL == node->mode)
+    {
+        LOG_I("%s/%s: Got a signal for %s again, stop polling it", __FILE__, __FUNCTION__, channel->label);
+        node_set_mode(node, MODE_PUSH, now);
+    }
+    else
+    {
+        // Signals arrive, so the check can wait
+        node->due = now + (gint64)POLL_VERIFY_MS * 1000;
+    }
+    node->has_value = true;
+    node->value = value;
+    node->last_push = now;
+}
+
+/*
+ * Called from the UA server thread when a client starts or stops monitoring a
+ * channel. The nodes are only reset while the server is stopped.
+ */
+void poll_watch(const channel_t *channel, bool watched)
+{
+    assert(NULL != channel);
+    if (channel->slot >= nodes_size)
+    {
+        return;
+    }
+    if (watched)
+    {
+        atomic_fetch_add_explicit(&watchers[channel->slot], 1, memory_order_relaxed);
+    }
+    else
+    {
+        atomic_fetch_sub_explicit(&watchers[channel->slot], 1, memory_order_relaxed);
+    }
+}
+
+void poll_get_stats(poll_stats_t *stats)
+{
+    assert(NULL != stats);
+    stats->cycles = atomic_load_explicit(&stat_cycles, memory_order_relaxed);
+    stats->calls = atomic_load_explicit(&stat_calls, memory_order_relaxed);
+    stats->cycle_calls = atomic_load_explicit(&stat_cycle_calls, memory_order_relaxed);
+    stats->max_calls = atomic_load_explicit(&max_calls, memory_order_relaxed);
+    stats->polled = atomic_load_explicit(&stat_polled, memory_order_relaxed);
+}
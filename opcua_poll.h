@@ -0,0 +1,53 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _OPCUA_POLL_H_
+#define _OPCUA_POLL_H_
+
+#include <glib.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "opcua_channels.h"
+
+/* Polls are started in cycles of this length, which is also the shortest poll interval */
+#define POLL_CYCLE_MS 250
+#define POLL_INTERVAL_MAX_MS 10000
+
+/* How often a channel that gets signals is polled to check that they still arrive */
+#define POLL_VERIFY_MS 30000
+
+typedef struct
+{
+    uint64_t cycles;
+    uint64_t calls;
+    uint32_t cycle_calls; // D-Bus calls started in the last cycle
+    uint32_t max_calls;   // upper bound for cycle_calls
+    uint32_t polled;      // channels that are polled instead of getting signals
+} poll_stats_t;
+
+void poll_reset(const size_t capacity);
+void poll_cleanup(void);
+void poll_set_max_calls(guint max_calls);
+void poll_add(const channel_t *channel, bool push, double value);
+void poll_remove(const channel_t *channel);
+void poll_set_tolerance(const channel_t *channel, double tolerance);
+void poll_pushed(const channel_t *channel, double value);
+void poll_watch(const channel_t *channel, bool watched);
+void poll_get_stats(poll_stats_t *stats);
+
+#endif /* _OPCUA_POLL_H_ */
@@ -0,0 +1,484 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <dirent.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <open62541/plugin/pki_default.h>
+#include <open62541/server_config_default.h>
+
+#include "opcua_common.h"
+#include "opcua_security.h"
+
+#define SECURITY_PATH_MAX 256
+#define SECURITY_LIST_MAX 64          // files per directory, the rest are ignored
+#define SECURITY_FILE_MAX (64 * 1024) // bytes, larger files are not read
+
+/*
+ * A file as it was last read. The server set up in ua_server_init parses the
+ * cached bytes once, so a relaunch or a rebind reads nothing again unless the
+ * file's signature changed. Reconnecting clients are verified against the
+ * trust list that the server parsed at setup.
+ */
+typedef struct
+{
+    char path[SECURITY_PATH_MAX];
+    bool exists;
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    struct timespec mtime;
+    UA_ByteString data; // empty if the file could not be read
+} cached_file_t;
+
+typedef struct
+{
+    const char *dir;
+    size_t count;
+    cached_file_t files[SECURITY_LIST_MAX]; // sorted by path
+} cached_list_t;
+
+enum
+{
+    LIST_TRUSTED,
+    LIST_ISSUERS,
+    LIST_REVOKED,
+    LISTS
+};
+
+/*
+ * Only used from the GLib main loop. The server may keep pointers to the
+ * cached data, it is only read again in ua_server_init when there are none.
+ */
+static cached_file_t certificate = {.path = SECURITY_CERTIFICATE_FILE};
+static cached_file_t private_key = {.path = SECURITY_PRIVATE_KEY_FILE};
+static cached_list_t lists[LISTS] = {
+    [LIST_TRUSTED] = {.dir = SECURITY_TRUSTED_DIR},
+    [LIST_ISSUERS] = {.dir = SECURITY_ISSUERS_DIR},
+    [LIST_REVOKED] = {.dir = SECURITY_REVOKED_DIR},
+};
+static bool allow_none = true;
+static bool applied_allow_none = true;
+static bool accept_all;
+static bool applied_accept_all;
+static bool applied;
+
+static bool is_unchanged(const cached_file_t *file, const struct stat *st)
+{
+    if (NULL == st)
+    {
+        return !file->exists;
+    }
+    return file->exists && st->st_dev == file->dev && st->st_ino == file->ino && st->st_size == file->size &&
+           st->st_mtim.tv_sec == file->mtime.tv_sec && st->st_mtim.tv_nsec == file->mtime.tv_nsec;
+}
+
+static void read_file(cached_file_t *file, const struct stat *st)
+{
+    if (SECURITY_FILE_MAX < st->st_size)
+    {
+        LOG_W("%s/%s: %s is larger than %d bytes, not used", __FILE__, __FUNCTION__, file->path, SECURITY_FILE_MAX);
+        return;
+    }
+    FILE *f = fopen(file->path, "rb");
+    if (NULL == f)
+    {
+        LOG_W("%s/%s: Failed to open %s: %s", __FILE__, __FUNCTION__, file->path, strerror(errno));
+        return;
+    }
+    if (UA_STATUSCODE_GOOD != UA_ByteString_allocBuffer(&file->data, (size_t)st->st_size))
+    {
+        LOG_E("%s/%s: Failed to allocate %s", __FILE__, __FUNCTION__, file->path);
+    }
+    else if (file->data.length != fread(file->data.data, 1, file->data.length, f))
+    {
+        LOG_W("%s/%s: Failed to read %s", __FILE__, __FUNCTION__, file->path);
+        UA_ByteString_clear(&file->data);
+    }
+    fclose(f);
+}
+
+/* Returns true if the file changed since it was cached, and caches it again if load is set */
+static bool refresh_file(cached_file_t *file, const bool load)
+{
+    struct stat st;
+    const bool exists = 0 == stat(file->path, &st) && S_ISREG(st.st_mode);
+    if (is_unchanged(file, exists ? &st : NULL))
+    {
+        return false;
+    }
+    if (load)
+    {
+        UA_ByteString_clear(&file->data);
+        file->exists = exists;
+        if (exists)
+        {
+            file->dev = st.st_dev;
+            file->ino = st.st_ino;
+            file->size = st.st_size;
+            file->mtime = st.st_mtim;
+            read_file(file, &st);
+        }
+    }
+    return true;
+}
+
+static int compare_paths(const void *a, const void *b)
+{
+    return strcmp(a, b);
+}
+
+/* The sorted paths of the files in a directory, a missing directory is an empty one */
+static size_t list_dir(const char *dir, char (*paths)[SECURITY_PATH_MAX])
+{
+    DIR *d = opendir(dir);
+    if (NULL == d)
+    {
+        return 0;
+    }
+    size_t count = 0;
+    const struct dirent *entry;
+    while (NULL != (entry = readdir(d)))
+    {
+        if ('.' == entry->d_name[0])
+        {
+            continue;
+        }
+        if (SECURITY_LIST_MAX == count)
+        {
+            LOG_W(
+                "%s/%s: More than %d files in %s, the rest are ignored",
+                __FILE__,
+                __FUNCTION__,
+                SECURITY_LIST_MAX,
+                dir);
+            break;
+        }
+        const int length = snprintf(paths[count], SECURITY_PATH_MAX, "%s/%s", dir, entry->d_name);
+        if (0 < length && SECURITY_PATH_MAX > length)
+        {
+            count++;
+        }
+    }
+    closedir(d);
+    qsort(paths, count, SECURITY_PATH_MAX, compare_paths);
+    return count;
+}
+
+/* Like refresh_file for every file in the list's directory, and for files added or removed */
+static bool refresh_list(cached_list_t *list, const bool load)
+{
+    char paths[SECURITY_LIST_MAX][SECURITY_PATH_MAX];
+    const size_t count = list_dir(list->dir, paths);
+    bool changed = count != list->count;
+    for (size_t i = 0; i < count && !changed; i++)
+    {
+        changed = 0 != strcmp(paths[i], list->files[i].path);
+    }
+    if (changed && !load)
+    {
+        return true;
+    }
+
+    if (changed)
+    {
+        // Keep the files that are still there, both are sorted
+        static cached_file_t files[SECURITY_LIST_MAX];
+        size_t old = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            while (old < list->count && 0 > strcmp(list->files[old].path, paths[i]))
+            {
+                UA_ByteString_clear(&list->files[old++].data);
+            }
+            if (old < list->count && 0 == strcmp(list->files[old].path, paths[i]))
+            {
+                files[i] = list->files[old++];
+            }
+            else
+            {
+                memset(&files[i], 0, sizeof(files[i]));
+                memcpy(files[i].path, paths[i], SECURITY_PATH_MAX);
+            }
+        }
+        while (old < list->count)
+        {
+            UA_ByteString_clear(&list->files[old++].data);
+        }
+        memcpy(list->files, files, count * sizeof(files[0]));
+        list->count = count;
+    }
+    for (size_t i = 0; i < list->count; i++)
+    {
+        changed |= refresh_file(&list->files[i], load);
+    }
+    return changed;
+}
+
+static bool refresh_all(const bool load)
+{
+    bool changed = refresh_file(&certificate, load);
+    changed |= refresh_file(&private_key, load);
+    for (size_t i = 0; i < LISTS; i++)
+    {
+        changed |= refresh_list(&lists[i], load);
+    }
+    return changed;
+}
+
+#ifdef UA_ENABLE_ENCRYPTION
+static const struct
+{
+    const char *name;
+    UA_StatusCode (*add)(UA_ServerConfig *config, const UA_ByteString *certificate, const UA_ByteString *key);
+} policies[] = {
+    {"Basic256Sha256", UA_ServerConfig_addSecurityPolicyBasic256Sha256},
+    {"Aes128_Sha256_RsaOaep", UA_ServerConfig_addSecurityPolicyAes128Sha256RsaOaep},
+#ifdef UA_ENABLE_ENCRYPTION_OPENSSL
+    // open62541 only implements it with OpenSSL
+    {"Aes256_Sha256_RsaPss", UA_ServerConfig_addSecurityPolicyAes256Sha256RsaPss},
+#endif
+};
+
+/* Returns the number of policies added, each with a Sign and a SignAndEncrypt endpoint */
+static size_t add_endpoints(UA_ServerConfig *config, const bool report)
+{
+    const size_t first = config->securityPoliciesSize;
+    for (size_t i = 0; i < sizeof(policies) / sizeof(policies[0]); i++)
+    {
+        const UA_StatusCode status = policies[i].add(config, &certificate.data, &private_key.data);
+        if (UA_STATUSCODE_GOOD != status && report)
+        {
+            LOG_E(
+                "%s/%s: Failed to add security policy %s: %s",
+                __FILE__,
+                __FUNCTION__,
+                policies[i].name,
+                UA_StatusCode_name(status));
+        }
+    }
+    for (size_t i = first; i < config->securityPoliciesSize; i++)
+    {
+        const UA_String uri = config->securityPolicies[i].policyUri;
+        if (UA_STATUSCODE_GOOD != UA_ServerConfig_addEndpoint(config, uri, UA_MESSAGESECURITYMODE_SIGN) ||
+            UA_STATUSCODE_GOOD != UA_ServerConfig_addEndpoint(config, uri, UA_MESSAGESECURITYMODE_SIGNANDENCRYPT))
+        {
+            LOG_E("%s/%s: Failed to add endpoints for %.*s", __FILE__, __FUNCTION__, (int)uri.length, uri.data);
+        }
+    }
+    return config->securityPoliciesSize - first;
+}
+
+/* The None policy stays for GetEndpoints, but sessions need a secure channel */
+static void remove_none_endpoints(UA_ServerConfig *config)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < config->endpointsSize; i++)
+    {
+        if (UA_MESSAGESECURITYMODE_NONE == config->endpoints[i].securityMode)
+        {
+            UA_EndpointDescription_clear(&config->endpoints[i]);
+        }
+        else
+        {
+            config->endpoints[kept++] = config->endpoints[i];
+        }
+    }
+    config->endpointsSize = kept;
+    config->securityPolicyNoneDiscoveryOnly = true;
+}
+
+/* The readable files of a list, the byte strings point into the cache */
+static size_t list_data(const cached_list_t *list, UA_ByteString *data)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < list->count; i++)
+    {
+        if (0 < list->files[i].data.length)
+        {
+            data[count++] = list->files[i].data;
+        }
+    }
+    return count;
+}
+
+static UA_StatusCode reject_certificate(
+    const UA_CertificateVerification *verification, const UA_ByteString *certificate)
+{
+    (void)verification;
+    (void)certificate;
+    return UA_STATUSCODE_BADCERTIFICATEUNTRUSTED;
+}
+
+/*
+ * Clients are verified against the trusted certificates. Without any, every
+ * client certificate is rejected unless accept_all is set. Returns the number
+ * of trusted certificates.
+ */
+static size_t set_trust_lists(UA_ServerConfig *config)
+{
+    UA_ByteString trusted[SECURITY_LIST_MAX];
+    UA_ByteString issuers[SECURITY_LIST_MAX];
+    UA_ByteString revoked[SECURITY_LIST_MAX];
+    const size_t trusted_count = list_data(&lists[LIST_TRUSTED], trusted);
+    const size_t issuers_count = list_data(&lists[LIST_ISSUERS], issuers);
+    const size_t revoked_count = list_data(&lists[LIST_REVOKED], revoked);
+    if (accept_all)
+    {
+        // UA_ServerConfig_setMinimal set up both verifications to accept all
+        return trusted_count;
+    }
+
+    UA_CertificateVerification *verifications[] = {&config->secureChannelPKI, &config->sessionPKI};
+    for (size_t i = 0; i < sizeof(verifications) / sizeof(verifications[0]); i++)
+    {
+        UA_CertificateVerification *verification = verifications[i];
+        if (NULL != verification->clear)
+        {
+            verification->clear(verification);
+        }
+        if (0 == trusted_count)
+        {
+            UA_CertificateVerification_AcceptAll(verification);
+            verification->verifyCertificate = reject_certificate;
+            continue;
+        }
+        const UA_StatusCode status = UA_CertificateVerification_Trustlist(
+            verification, trusted, trusted_count, issuers, issuers_count, revoked, revoked_count);
+        if (UA_STATUSCODE_GOOD != status)
+        {
+            LOG_E("%s/%s: Failed to set up the trust list: %s", __FILE__, __FUNCTION__, UA_StatusCode_name(status));
+            verification->verifyCertificate = reject_certificate;
+        }
+    }
+    return trusted_count;
+}
+#endif
+
+/* Called from the GLib main loop, used by the next ua_server_init. Returns false if unchanged. */
+bool security_set_allow_none(bool allowed)
+{
+    const bool changed = allowed != allow_none;
+    allow_none = allowed;
+    return changed;
+}
+
+/* Called from the GLib main loop, used by the next ua_server_init. Returns false if unchanged. */
+bool security_set_accept_all(bool accepted)
+{
+    const bool changed = accepted != accept_all;
+    accept_all = accepted;
+    return changed;
+}
+
+/* Returns true if the server needs to be set up again, for new files in localdata/pki or a new setting */
+bool security_changed(void)
+{
+    return allow_none != applied_allow_none || accept_all != applied_accept_all || refresh_all(false);
+}
+
+/* Add the secure endpoints to a server configured with UA_ServerConfig_setMinimal, from ua_server_init */
+void security_apply(UA_ServerConfig *config)
+{
+    assert(NULL != config);
+
+    // Log only when the files or the setting are not the ones of the last server
+    const bool report =
+        refresh_all(true) || allow_none != applied_allow_none || accept_all != applied_accept_all || !applied;
+    applied_allow_none = allow_none;
+    applied_accept_all = accept_all;
+    applied = true;
+
+#ifdef UA_ENABLE_ENCRYPTION
+    if (0 == certificate.data.length || 0 == private_key.data.length)
+    {
+        if (report)
+        {
+            LOG_W(
+                "%s/%s: No certificate and private key in %s and %s, only unencrypted sessions",
+                __FILE__,
+                __FUNCTION__,
+                SECURITY_CERTIFICATE_FILE,
+                SECURITY_PRIVATE_KEY_FILE);
+        }
+        return;
+    }
+    const size_t added = add_endpoints(config, report);
+    if (0 == added)
+    {
+        return;
+    }
+    if (!allow_none)
+    {
+        remove_none_endpoints(config);
+    }
+    const size_t trusted = set_trust_lists(config);
+    if (report)
+    {
+        LOG_I(
+            "%s/%s: %zu security policies, %s unencrypted sessions",
+            __FILE__,
+            __FUNCTION__,
+            added,
+            allow_none ? "with" : "without");
+        if (accept_all)
+        {
+            LOG_W("%s/%s: All client certificates are accepted", __FILE__, __FUNCTION__);
+        }
+        else if (0 == trusted)
+        {
+            LOG_W(
+                "%s/%s: No certificates in %s, all client certificates are rejected",
+                __FILE__,
+                __FUNCTION__,
+                SECURITY_TRUSTED_DIR);
+        }
+    }
+#else
+    if (report && certificate.exists)
+    {
+        LOG_W("%s/%s: open62541 is built without encryption, %s is not used", __FILE__, __FUNCTION__, certificate.path);
+    }
+#endif
+}
+
+static void clear_file(cached_file_t *file)
+{
+    UA_ByteString_clear(&file->data);
+    file->exists = false;
+}
+
+/* Called after ua_server_cleanup */
+void security_cleanup(void)
+{
+    clear_file(&certificate);
+    clear_file(&private_key);
+    for (size_t i = 0; i < LISTS; i++)
+    {
+        for (size_t j = 0; j < lists[i].count; j++)
+        {
+            clear_file(&lists[i].files[j]);
+        }
+        lists[i].count = 0;
+    }
+    applied = false;
+}
@@ -0,0 +1,39 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _OPCUA_SECURITY_H_
+#define _OPCUA_SECURITY_H_
+
+#include <open62541/server.h>
+
+#include <stdbool.h>
+
+/* The server's certificate and private key, DER or PEM, relative to the application directory */
+#define SECURITY_CERTIFICATE_FILE "localdata/pki/server.crt"
+#define SECURITY_PRIVATE_KEY_FILE "localdata/pki/server.key"
+
+/* One certificate or revocation list per file */
+#define SECURITY_TRUSTED_DIR "localdata/pki/trusted"
+#define SECURITY_ISSUERS_DIR "localdata/pki/issuers"
+#define SECURITY_REVOKED_DIR "localdata/pki/revoked"
+
+bool security_set_allow_none(bool allowed);
+bool security_set_accept_all(bool accepted);
+bool security_changed(void);
+void security_apply(UA_ServerConfig *config);
+void security_cleanup(void);
+
+#endif /* _OPCUA_SECURITY_H_ */
@@ -16,248 +16,1329 @@
 
 #include <assert.h>
 #include <axparameter.h>
+#include <glib-unix.h>
 #include <libgen.h>
+#include <math.h>
 #include <open62541/server_config_default.h>
 #include <pthread.h>
 
+#include "opcua_aggregates.h"
+#include "opcua_alarms.h"
+#include "opcua_channels.h"
+#include "opcua_coalesce.h"
 #include "opcua_common.h"
 #include "opcua_dbus.h"
+#include "opcua_diagnostics.h"
+#include "opcua_events.h"
+#include "opcua_history.h"
+#include "opcua_limits.h"
 #include "opcua_open62541.h"
-#include "opcua_portsio.h"
-#include "opcua_tempsensors.h"
-
-#define SIGNALTEMPCHANGE "TemperatureChangeSignal"
-#define SIGNALPORTIOCHANGE "PortChanged"
+#include "opcua_outputs.h"
+#include "opcua_poll.h"
+#include "opcua_security.h"
 
 static GMainLoop *main_loop = NULL;
 static AXParameter *axparameter = NULL;
-static tempsensors_t tempsensors;
-static ports_t ports;
+static channels_t channels;
+
+/* Initial values collected while enumerating, indexed by channel slot */
+typedef struct
+{
+    bool has_value;
+    union
+    {
+        double temp;
+        bool state;
+    } value;
+} initial_value_t;
+
+/* Used for sensors that have no entry of their own in tempDeadband */
+#define TEMP_DEADBAND_DEFAULT 0.1
+
+/* Used for sensors that have no entry of their own in alarmHysteresis */
+#define ALARM_HYSTERESIS_DEFAULT 1.0
+
+/* Longest tempMinInterval in ms, same as for coalesceWindow */
+#define TEMP_MIN_INTERVAL_MAX 60000
+
+/* Spare registry slots for sensors and ports that appear while the server runs */
+#define ENUMERATE_SPARE_CHANNELS 16
+
+static initial_value_t *initial_values = NULL;
+
+/* Per sensor settings: sensor i uses entry i, sensors past the end use the last entry */
+static GArray *temp_deadbands = NULL;
+static GArray *temp_min_intervals = NULL;
+static GArray *alarm_low_low = NULL; // limits are NAN for none
+static GArray *alarm_low = NULL;
+static GArray *alarm_high = NULL;
+static GArray *alarm_high_high = NULL;
+static GArray *alarm_hysteresis = NULL;
+static bool port_events = true;
+static history_config_t history_config;
+static limits_t server_limits = {
+    .max_sessions = 32,
+    .max_subscriptions = 4,
+    .max_monitored_items = 500,
+    .max_notifications = 1000,
+    .min_publishing_ms = 100.0,
+    .min_sampling_ms = 50.0,
+    .buffer_size = 64 * 1024,
+    .memory_budget = 32768 * 1024,
+};
+static guint pending_calls = 0;
+static void (*on_calls_done)(void) = NULL; // finishes a launch or re-enumeration after the last reply
+static gint64 main_start = 0;
+static gint64 launch_start = 0;
+static gboolean launching = FALSE;
+static gboolean relaunch = FALSE;
+static gboolean full_relaunch = FALSE; // a rebind is not enough, the channels must be enumerated again
 static UA_Server *server = NULL;
 static guint port = 0;
 static UA_Boolean ua_server_running = false;
-static pthread_t ua_server_thread_id;
 
-static void open_syslog(const char *app_name)
+/* Sensor and port counts of the device */
+typedef struct
+{
+    uint32_t temps;
+    uint32_t ports;
+    uint32_t inputs; // ports 0 to inputs - 1 are inputs, the rest outputs
+} counts_t;
+
+/* The counts that the channels are for, checked every enumerate_interval s while the server runs */
+static counts_t enumerated;
+static guint launches = 0;
+static guint enumerate_id = 0;
+static struct
+{
+    guint pending; // count calls in flight
+    guint launch;  // the counts are dropped if the server was launched again meanwhile
+    bool ok;
+    bool retry; // some channels were not added last time
+    counts_t counts;
+} enumeration;
+
+static void open_syslog(const char *app_name)
+{
+    openlog(app_name, LOG_PID, LOG_LOCAL4);
+    log_init();
+}
+
+static void close_syslog(void)
+{
+    LOG_I("%s/%s: Exiting!", __FILE__, __FUNCTION__);
+    log_cleanup();
+    closelog();
+}
+
+static void on_temp_signal(
+    G_GNUC_UNUSED GDBusProxy *proxy,
+    const gchar *sender_name,
+    const gchar *signal_name,
+    GVariant *parameters,
+    G_GNUC_UNUSED gpointer user_data)
+{
+    uint32_t sub_id;
+    double value;
+    update_time_t received;
+
+    // Take the time first so that it does not include the decoding
+    updates_time_now(&received);
+    diagnostics_count(DIAG_SIGNALS_TEMP);
+    if (!dbus_temp_unpack_signal(parameters, &sub_id, &value))
+    {
+        diagnostics_count(DIAG_DECODE_FAILURES);
+        LOG_E(
+            "%s/%s: Failed to get values from signal %s sent by %s", __FILE__, __FUNCTION__, signal_name, sender_name);
+        return;
+    }
+    const int64_t decoded_ns = diagnostics_now_ns();
+    diagnostics_record_latency(DIAG_STAGE_DECODE, decoded_ns - received.mono_ns);
+    const channel_t *channel = channels_get_from_subscription(&channels, CHANNEL_TEMP, sub_id);
+    diagnostics_record_latency(DIAG_STAGE_LOOKUP, diagnostics_now_ns() - decoded_ns);
+    if (NULL == channel)
+    {
+        // Not one of our subscriptions
+        return;
+    }
+    poll_pushed(channel, value);
+    coalesce_temp(channel, value, &received);
+    LOG_D("%s/%s: New value for %s is %f", __FILE__, __FUNCTION__, channel->label, value);
+}
+
+static void on_port_signal(
+    G_GNUC_UNUSED GDBusProxy *proxy,
+    const gchar *sender_name,
+    const gchar *signal_name,
+    GVariant *parameters,
+    G_GNUC_UNUSED gpointer user_data)
+{
+    dbus_port_signal_t signal;
+    update_time_t received;
+
+    updates_time_now(&received);
+    diagnostics_count(DIAG_SIGNALS_PORT);
+    if (!dbus_port_unpack_signal(parameters, &signal))
+    {
+        diagnostics_count(DIAG_DECODE_FAILURES);
+        LOG_E(
+            "%s/%s: Failed to get values from signal %s sent by %s", __FILE__, __FUNCTION__, signal_name, sender_name);
+        return;
+    }
+    const int64_t decoded_ns = diagnostics_now_ns();
+    diagnostics_record_latency(DIAG_STAGE_DECODE, decoded_ns - received.mono_ns);
+    const channel_t *channel = channels_get_from_subscription(&channels, CHANNEL_PORT, signal.subscription_id);
+    diagnostics_record_latency(DIAG_STAGE_LOOKUP, diagnostics_now_ns() - decoded_ns);
+    if (NULL == channel)
+    {
+        return;
+    }
+    poll_pushed(channel, signal.state ? 1.0 : 0.0);
+    coalesce_port(channel, signal.state, &received);
+    if (port_events && !ua_server_port_transition(channel, signal.state, signal.activelow, signal.virtual, &received))
+    {
+        LOG_D("%s/%s: No event for the transition of %s", __FILE__, __FUNCTION__, channel->label);
+    }
+    LOG_D(
+        "%s/%s: Port status change. port:%d, virtual:%d, hidden:%d, input:%d, virtual_trig:%d, state:%d, "
+        "activelow:%d",
+        __FILE__,
+        __FUNCTION__,
+        signal.port,
+        signal.virtual,
+        signal.hidden,
+        signal.input,
+        signal.virtual_trig,
+        signal.state,
+        signal.activelow)
+}
+
+/* The state of an output port read back after a client set it, written without coalescing */
+static void on_output_confirmed(uint32_t port, bool state, const update_time_t *received)
+{
+    const channel_t *channel = channels_get_from_subscription(&channels, CHANNEL_PORT, port);
+    if (NULL == channel)
+    {
+        return;
+    }
+    poll_pushed(channel, state ? 1.0 : 0.0);
+    (void)ua_server_update_port(channel, state, received);
+}
+
+static uint32_t get_number_of_tempsensors(void)
+{
+    uint32_t count = 0;
+    if (!dbus_temp_get_number_of_sensors(&count))
+    {
+        LOG_E("%s/%s: Failed to get number of temperature sensors", __FILE__, __FUNCTION__);
+    }
+    else
+    {
+        LOG_I("%s/%s: This device has %u temperature sensors", __FILE__, __FUNCTION__, count);
+    }
+    return count;
+}
+
+/* Ports 0 to inputs - 1 are inputs, the rest outputs */
+static uint32_t get_number_of_ports(uint32_t *inputs)
+{
+    uint32_t count_all = 0;
+    uint32_t count_in = 0;
+    uint32_t count_out = 0;
+
+    if (!dbus_get_number_of_ioports(&count_in, &count_out))
+    {
+        LOG_E("%s/%s: Failed to get number of ports", __FILE__, __FUNCTION__);
+    }
+    else
+    {
+        count_all = count_in + count_out;
+        LOG_I(
+            "%s/%s: This device has %u input ports and %u output ports. (%u)",
+            __FILE__,
+            __FUNCTION__,
+            count_in,
+            count_out,
+            count_all);
+    }
+    *inputs = count_in;
+    return count_all;
+}
+
+/* Count a reply, the last one finishes what was waiting for it */
+static void call_done(void)
+{
+    assert(0 < pending_calls);
+    if (0 < --pending_calls || NULL == on_calls_done)
+    {
+        return;
+    }
+    void (*done)(void) = on_calls_done;
+    on_calls_done = NULL;
+    done();
+}
+
+/* Run done when every call in flight has replied, at once if none is */
+static void when_calls_done(void (*done)(void))
+{
+    assert(NULL == on_calls_done);
+    if (0 == pending_calls)
+    {
+        done();
+        return;
+    }
+    on_calls_done = done;
+}
+
+static void on_initial_temp(bool ok, double value, gpointer user_data)
+{
+    channel_t *channel = user_data;
+    if (ok)
+    {
+        LOG_I("%s/%s: Got temperature for sensor %u: %f", __FILE__, __FUNCTION__, channel->index, value);
+        initial_values[channel->slot].has_value = true;
+        initial_values[channel->slot].value.temp = value;
+    }
+    call_done();
+}
+
+static void on_temp_unsubscribed(bool ok, gpointer user_data)
+{
+    if (ok)
+    {
+        LOG_D("%s/%s: Unsubscribed %u", __FILE__, __FUNCTION__, GPOINTER_TO_UINT(user_data));
+    }
+}
+
+/* Drop the TemperatureController registration of a sensor, the device would otherwise keep signalling it */
+static void unsubscribe_temp(const uint32_t subid)
+{
+    dbus_temp_unsubscribe_async(subid, on_temp_unsubscribed, GUINT_TO_POINTER(subid));
+}
+
+static void on_temp_subscribed(bool ok, uint32_t subid, gpointer user_data)
+{
+    channel_t *channel = user_data;
+    if (!ok)
+    {
+        LOG_E("%s/%s: Failed to subscribe to changes for sensor with id %u", __FILE__, __FUNCTION__, channel->index);
+    }
+    else if (channel->removed)
+    {
+        LOG_D("%s/%s: Sensor %u is gone, dropping subscription %u", __FILE__, __FUNCTION__, channel->index, subid);
+        unsubscribe_temp(subid);
+    }
+    else if (!channels_set_subscription(&channels, channel, subid))
+    {
+        LOG_E(
+            "%s/%s: Failed to map subscription id %u for sensor %u", __FILE__, __FUNCTION__, subid, channel->index);
+        unsubscribe_temp(subid);
+    }
+    call_done();
+}
+
+static void on_initial_state(bool ok, bool state, gpointer user_data)
+{
+    channel_t *channel = user_data;
+    if (ok)
+    {
+        LOG_I("%s/%s: Got state for port %u: %d", __FILE__, __FUNCTION__, channel->index, state);
+        initial_values[channel->slot].has_value = true;
+        initial_values[channel->slot].value.state = state;
+    }
+    call_done();
+}
+
+static double sensor_setting(const GArray *list, const uint32_t index, const double fallback)
+{
+    if (NULL == list || 0 == list->len)
+    {
+        return fallback;
+    }
+    return g_array_index(list, double, MIN(index, list->len - 1));
+}
+
+/* Add a sensor to the registry, or give a removed one its slot back, and ask for its value and signals */
+static channel_t *add_tempsensor(const uint32_t index)
+{
+    channel_t *channel = channels_add(&channels, CHANNEL_TEMP, index);
+    if (NULL == channel)
+    {
+        LOG_E("%s/%s: No room for temperature sensor %u", __FILE__, __FUNCTION__, index);
+        return NULL;
+    }
+    const double min_interval = sensor_setting(temp_min_intervals, index, 0);
+    const double deadband = sensor_setting(temp_deadbands, index, TEMP_DEADBAND_DEFAULT);
+    coalesce_set_min_interval(channel, (guint)min_interval);
+    poll_set_tolerance(channel, deadband);
+    dbus_temp_get_value_async(index, on_initial_temp, channel);
+    pending_calls++;
+    dbus_temp_subscribe_to_change_async(index, deadband, on_temp_subscribed, channel);
+    pending_calls++;
+    return channel;
+}
+
+static void add_tempsensors(const uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (NULL == add_tempsensor(i))
+        {
+            break;
+        }
+    }
+}
+
+/* Same for a port, its direction is set by the caller */
+static channel_t *add_port(const uint32_t index)
+{
+    channel_t *channel = channels_add(&channels, CHANNEL_PORT, index);
+    if (NULL == channel)
+    {
+        LOG_E("%s/%s: No room for port %u", __FILE__, __FUNCTION__, index);
+        return NULL;
+    }
+    LOG_I("%s/%s: Added label (%s) for port:%u", __FILE__, __FUNCTION__, channel->label, index);
+    dbus_port_get_state_async(index, on_initial_state, channel);
+    pending_calls++;
+
+    // PortChanged signals carry the port number rather than a subscription id
+    (void)channels_set_subscription(&channels, channel, index);
+    return channel;
+}
+
+static void add_ports(const uint32_t count, const uint32_t inputs)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        channel_t *channel = add_port(i);
+        if (NULL == channel)
+        {
+            break;
+        }
+        channel->output = inputs <= i;
+    }
+}
+
+static void publish_channels(void)
+{
+    for (size_t i = 0; i < channels.size; i++)
+    {
+        const channel_t *channel = &channels.slots[i];
+        if (!initial_values[i].has_value)
+        {
+            LOG_E("%s/%s: No value for %s, it will not be published", __FILE__, __FUNCTION__, channel->label);
+            continue;
+        }
+        if (CHANNEL_TEMP == channel->type)
+        {
+            ua_server_add_double(channel, initial_values[i].value.temp);
+            poll_add(channel, channel->subscribed, initial_values[i].value.temp);
+        }
+        else
+        {
+            ua_server_add_bool(channel, initial_values[i].value.state);
+            poll_add(channel, channel->subscribed, initial_values[i].value.state ? 1.0 : 0.0);
+        }
+    }
+}
+
+static void restart_ua_server(void);
+
+/* The values are in, publish the channels and start the server */
+static void finish_launch(void)
+{
+    // History for the new channels, read back from file on the first launch
+    history_reset(&channels);
+    aggregates_reset(&channels);
+    alarms_reset(&channels);
+
+    // Add the nodes to the OPC UA server when all values are in
+    publish_channels();
+    g_free(initial_values);
+    initial_values = NULL;
+
+    ua_server_running = true;
+    LOG_I("%s/%s: Starting UA server on port %u ...", __FILE__, __FUNCTION__, port);
+    launching = FALSE;
+    if (!ua_server_run(&ua_server_running))
+    {
+        LOG_E("%s/%s: Failed to launch UA server", __FILE__, __FUNCTION__);
+        ua_server_running = false;
+    }
+    else
+    {
+        LOG_I(
+            "%s/%s: %u temperature sensors and %u ports readable after %.1f ms",
+            __FILE__,
+            __FUNCTION__,
+            enumerated.temps,
+            enumerated.ports,
+            (g_get_monotonic_time() - launch_start) / 1000.0);
+        if (1 == launches)
+        {
+            LOG_I(
+                "%s/%s: Ready after %.1f ms", __FILE__, __FUNCTION__, (g_get_monotonic_time() - main_start) / 1000.0);
+        }
+    }
+
+    // Changed while the values were coming in
+    if (relaunch)
+    {
+        restart_ua_server();
+    }
+}
+
+/* Enumerate the channels and ask for their values, the launch finishes with the last reply */
+static void launch_ua_server(const guint serverport)
+{
+    assert(NULL == server);
+    assert(0 < serverport);
+    assert(!ua_server_running);
+    assert(1024 <= serverport && 65535 >= serverport);
+    assert(0 == pending_calls);
+
+    launch_start = g_get_monotonic_time();
+    launching = TRUE;
+
+    // Create an OPC UA server
+    LOG_I("%s/%s: Create UA server serving on port %u", __FILE__, __FUNCTION__, serverport);
+    ua_server_init(serverport);
+
+    // Size the channel registry for all sensors and ports, and some that may appear later
+    const uint32_t count_temp = get_number_of_tempsensors();
+    uint32_t count_inputs = 0;
+    const uint32_t count_ports = get_number_of_ports(&count_inputs);
+    const size_t capacity =
+        MIN((size_t)count_temp + count_ports + ENUMERATE_SPARE_CHANNELS, CHANNEL_TYPES * CHANNELS_MAX_PER_TYPE);
+    channels_free(&channels);
+    channels_init(&channels, capacity);
+    coalesce_reset(capacity);
+    poll_reset(capacity);
+    initial_values = g_new0(initial_value_t, capacity);
+    enumerated = (counts_t){.temps = count_temp, .ports = count_ports, .inputs = count_inputs};
+    enumeration.retry = false;
+    launches++;
+
+    // Ask for all temperature sensors and IO ports at once
+    add_tempsensors(count_temp);
+    add_ports(count_ports, count_inputs);
+    when_calls_done(finish_launch);
+}
+
+static void shutdown_ua_server(void)
+{
+    assert(ua_server_running);
+    ua_server_running = false;
+    ua_server_join();
+}
+
+/* Restart only the server's network layer, keeping nodes and D-Bus subscriptions */
+static gboolean rebind_ua_server(const guint serverport)
+{
+    assert(ua_server_running);
+    const gint64 start = g_get_monotonic_time();
+
+    shutdown_ua_server();
+    if (!ua_server_rebind(serverport))
+    {
+        return FALSE;
+    }
+    ua_server_running = true;
+    if (!ua_server_run(&ua_server_running))
+    {
+        LOG_E("%s/%s: Failed to restart UA server", __FILE__, __FUNCTION__);
+        ua_server_running = false;
+        return FALSE;
+    }
+
+    LOG_I(
+        "%s/%s: UA server network restarted on port %u in %.1f ms",
+        __FILE__,
+        __FUNCTION__,
+        serverport,
+        (g_get_monotonic_time() - start) / 1000.0);
+    return TRUE;
+}
+
+/* Restart the server on port, only its network layer if possible */
+static void restart_ua_server(void)
+{
+    // Changed while the server is being launched, picked up when the launch finishes
+    if (launching)
+    {
+        relaunch = TRUE;
+        return;
+    }
+    // Replies to calls in flight refer to the channels that a launch frees
+    if (0 < pending_calls)
+    {
+        on_calls_done = restart_ua_server;
+        return;
+    }
+
+    relaunch = FALSE;
+    if (ua_server_running && !full_relaunch && rebind_ua_server(port))
+    {
+        return;
+    }
+
+    // First launch, or fall back to a full relaunch
+    full_relaunch = FALSE;
+    if (ua_server_running)
+    {
+        shutdown_ua_server();
+    }
+    ua_server_cleanup();
+    launch_ua_server(port);
+}
+
+/* Take a channel out of the registry, a sensor also drops its TemperatureController registration */
+static void forget_channel(channel_t *channel)
+{
+    if (CHANNEL_TEMP == channel->type && channel->subscribed)
+    {
+        unsubscribe_temp(channel->subid);
+    }
+    channels_remove(&channels, channel);
+    coalesce_remove(channel);
+}
+
+/* A sensor or port that is gone, its nodes are deleted on the server thread */
+static void remove_channel(channel_t *channel)
+{
+    forget_channel(channel);
+    poll_remove(channel);
+    if (!ua_server_remove_channel(channel))
+    {
+        LOG_E("%s/%s: Failed to remove the node of %s", __FILE__, __FUNCTION__, channel->label);
+    }
+}
+
+static bool is_missing(const channel_type_t type, const uint32_t index)
+{
+    const channel_t *channel = channels_find(&channels, type, index);
+    return NULL == channel || channel->removed;
+}
+
+/* State of a re-enumeration while the values of the added channels come in */
+static struct
+{
+    counts_t counts;
+    GPtrArray *added;
+    guint removed;
+    gint64 start;
+} reenumeration;
+
+/* The values are in, publish the added channels */
+static void finish_reenumerate(void)
+{
+    const counts_t *counts = &reenumeration.counts;
+    GPtrArray *added = reenumeration.added;
+    launching = FALSE;
+
+    // A channel without a value is tried again with the next enumeration
+    enumerated = *counts;
+    enumeration.retry = false;
+    for (guint i = 0; i < added->len; i++)
+    {
+        channel_t *channel = g_ptr_array_index(added, i);
+        const initial_value_t *initial = &initial_values[channel->slot];
+        const bool output = CHANNEL_PORT == channel->type && counts->inputs <= channel->index;
+        const double value =
+            CHANNEL_TEMP == channel->type ? initial->value.temp : (initial->value.state ? 1.0 : 0.0);
+        if (!initial->has_value || !ua_server_add_channel(channel, output, value))
+        {
+            LOG_E("%s/%s: No value for %s, it will not be published", __FILE__, __FUNCTION__, channel->label);
+            forget_channel(channel);
+            enumeration.retry = true;
+            continue;
+        }
+        poll_add(channel, channel->subscribed, value);
+    }
+
+    LOG_I(
+        "%s/%s: Added %u channels and removed %u in %.1f ms",
+        __FILE__,
+        __FUNCTION__,
+        added->len,
+        reenumeration.removed,
+        (g_get_monotonic_time() - reenumeration.start) / 1000.0);
+    g_ptr_array_free(added, TRUE);
+    reenumeration.added = NULL;
+    g_free(initial_values);
+    initial_values = NULL;
+    if (relaunch)
+    {
+        restart_ua_server();
+    }
+}
+
+/*
+ * Bring the channels in line with new counts while the server runs. Only the
+ * sensors and ports that are gone or new are removed or added, along with
+ * their nodes and subscriptions, so the sessions and monitored items of the
+ * others are left alone. A port that changed direction is removed and added.
+ */
+static void reenumerate(const counts_t *counts)
+{
+    reenumeration.start = g_get_monotonic_time();
+    LOG_I(
+        "%s/%s: %u temperature sensors and %u ports (%u inputs), were %u and %u (%u)",
+        __FILE__,
+        __FUNCTION__,
+        counts->temps,
+        counts->ports,
+        counts->inputs,
+        enumerated.temps,
+        enumerated.ports,
+        enumerated.inputs);
+
+    // Channels that were never there need a spare slot, or a larger registry
+    size_t fresh = 0;
+    for (uint32_t i = 0; i < counts->temps; i++)
+    {
+        fresh += NULL == channels_find(&channels, CHANNEL_TEMP, i) ? 1 : 0;
+    }
+    for (uint32_t i = 0; i < counts->ports; i++)
+    {
+        fresh += NULL == channels_find(&channels, CHANNEL_PORT, i) ? 1 : 0;
+    }
+    if (channels.size + fresh > channels.capacity)
+    {
+        LOG_I("%s/%s: No room for %zu new channels, relaunching", __FILE__, __FUNCTION__, fresh);
+        full_relaunch = TRUE;
+        restart_ua_server();
+        return;
+    }
+
+    // The direction of a port is the one it was added with, channel->output belongs to the server thread
+    reenumeration.removed = 0;
+    for (size_t i = 0; i < channels.size; i++)
+    {
+        channel_t *channel = &channels.slots[i];
+        const bool gone = CHANNEL_TEMP == channel->type
+                              ? counts->temps <= channel->index
+                              : counts->ports <= channel->index ||
+                                    (enumerated.inputs <= channel->index) != (counts->inputs <= channel->index);
+        if (!channel->removed && gone)
+        {
+            remove_channel(channel);
+            reenumeration.removed++;
+        }
+    }
+
+    // Parameter changes wait for the replies like they do during a launch, see restart_ua_server
+    launching = TRUE;
+    initial_values = g_new0(initial_value_t, channels.capacity);
+    reenumeration.counts = *counts;
+    GPtrArray *added = reenumeration.added = g_ptr_array_new();
+    for (uint32_t i = 0; i < counts->temps; i++)
+    {
+        channel_t *channel = is_missing(CHANNEL_TEMP, i) ? add_tempsensor(i) : NULL;
+        if (NULL != channel)
+        {
+            g_ptr_array_add(added, channel);
+        }
+    }
+    for (uint32_t i = 0; i < counts->ports; i++)
+    {
+        channel_t *channel = is_missing(CHANNEL_PORT, i) ? add_port(i) : NULL;
+        if (NULL != channel)
+        {
+            g_ptr_array_add(added, channel);
+        }
+    }
+    when_calls_done(finish_reenumerate);
+}
+
+static void on_enumerated(void)
+{
+    assert(0 < enumeration.pending);
+    if (0 < --enumeration.pending)
+    {
+        return;
+    }
+    // A launch in the meantime enumerated on its own, or one is waiting for replies
+    if (!enumeration.ok || launches != enumeration.launch || launching || NULL != on_calls_done ||
+        !ua_server_running)
+    {
+        return;
+    }
+    if (enumeration.retry || enumeration.counts.temps != enumerated.temps ||
+        enumeration.counts.ports != enumerated.ports || enumeration.counts.inputs != enumerated.inputs)
+    {
+        reenumerate(&enumeration.counts);
+    }
+}
+
+static void on_temps_counted(bool ok, uint32_t count, G_GNUC_UNUSED gpointer user_data)
+{
+    enumeration.ok = enumeration.ok && ok;
+    enumeration.counts.temps = count;
+    on_enumerated();
+}
+
+static void on_ports_counted(bool ok, uint32_t inputs, uint32_t outputs, G_GNUC_UNUSED gpointer user_data)
+{
+    enumeration.ok = enumeration.ok && ok;
+    enumeration.counts.ports = inputs + outputs;
+    enumeration.counts.inputs = inputs;
+    on_enumerated();
+}
+
+/* Ask for the counts without blocking the main loop, the channels are compared when both are in */
+static gboolean on_enumerate(G_GNUC_UNUSED gpointer user_data)
+{
+    if (!ua_server_running || launching || 0 < enumeration.pending)
+    {
+        return G_SOURCE_CONTINUE;
+    }
+    enumeration.pending = 2;
+    enumeration.launch = launches;
+    enumeration.ok = true;
+    dbus_temp_get_number_of_sensors_async(on_temps_counted, NULL);
+    dbus_get_number_of_ioports_async(on_ports_counted, NULL);
+    return G_SOURCE_CONTINUE;
+}
+
+static void port_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    /* Translate parameter value to number; atoi can handle NULL */
+    int newport = atoi(value);
+    /* Only allow non-privileged ports */
+    if (1024 > newport || 65535 < newport)
+    {
+        LOG_E("%s/%s: illegal value for %s: '%s'", __FILE__, __FUNCTION__, name, value);
+        return;
+    }
+    port = newport;
+    LOG_I("%s/%s: OPC UA server %s is %u", __FILE__, __FUNCTION__, name, port);
+    restart_ua_server();
+}
+
+static void log_level_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    if (!log_set_level_name(value))
+    {
+        LOG_E("%s/%s: illegal value for %s: '%s'", __FILE__, __FUNCTION__, name, value);
+        return;
+    }
+    LOG_I("%s/%s: Log level %s is %s", __FILE__, __FUNCTION__, name, value);
+}
+
+static void coalesce_window_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    /* Translate parameter value to number; atoi can handle NULL */
+    int window = atoi(value);
+    if (0 > window)
+    {
+        LOG_E("%s/%s: illegal value for %s: '%s'", __FILE__, __FUNCTION__, name, value);
+        return;
+    }
+    LOG_I("%s/%s: Update coalescing %s is %i ms", __FILE__, __FUNCTION__, name, window);
+    coalesce_set_window(window);
+}
+
+static void coalesce_port_edges_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    bool edges = (0 == g_strcmp0(value, "yes"));
+    LOG_I("%s/%s: Update coalescing %s is %s", __FILE__, __FUNCTION__, name, edges ? "yes" : "no");
+    coalesce_set_port_edges(edges);
+}
+
+static void history_budget_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    /* Translate parameter value to number; atoi can handle NULL */
+    int budget = atoi(value);
+    if (0 > budget)
+    {
+        LOG_E("%s/%s: illegal value for %s: '%s'", __FILE__, __FUNCTION__, name, value);
+        return;
+    }
+    LOG_I("%s/%s: History %s is %i kB", __FILE__, __FUNCTION__, name, budget);
+    history_config.budget = (size_t)budget * 1024;
+    history_set_config(&history_config);
+}
+
+static void history_port_delta_callback(const gchar *name, const gchar *value, void *data)
 {
-    openlog(app_name, LOG_PID, LOG_LOCAL4);
+    (void)data;
+    history_config.port_delta = (0 == g_strcmp0(value, "yes"));
+    LOG_I("%s/%s: History %s is %s", __FILE__, __FUNCTION__, name, history_config.port_delta ? "yes" : "no");
+    history_set_config(&history_config);
 }
 
-static void close_syslog(void)
+static void history_persist_callback(const gchar *name, const gchar *value, void *data)
 {
-    LOG_I("%s/%s: Exiting!", __FILE__, __FUNCTION__);
-    closelog();
+    (void)data;
+    history_config.persist = (0 == g_strcmp0(value, "yes"));
+    LOG_I("%s/%s: History %s is %s", __FILE__, __FUNCTION__, name, history_config.persist ? "yes" : "no");
+    history_set_config(&history_config);
 }
 
-static void on_dbus_signal(
-    G_GNUC_UNUSED GDBusProxy *proxy,
-    const gchar *sender_name,
-    const gchar *signal_name,
-    GVariant *parameters,
-    G_GNUC_UNUSED gpointer user_data)
+/* A comma separated list of numbers in [0, max], e.g. one per sensor */
+static GArray *parse_sensor_list(const gchar *value, const double max)
 {
-    uint32_t sub_id;
-    double value;
-    char *label;
+    if (NULL == value)
+    {
+        return NULL;
+    }
 
-    // Check which signal
-    // TemperatureChangeSignal
-    if (0 == strcmp(signal_name, SIGNALTEMPCHANGE))
+    gchar **items = g_strsplit(value, ",", -1);
+    GArray *list = g_array_new(FALSE, FALSE, sizeof(double));
+    for (gchar **item = items; NULL != *item; item++)
     {
-        if (!dbus_temp_unpack_signal(parameters, &sub_id, &value))
+        gchar *end;
+        const gchar *text = g_strstrip(*item);
+        const double number = g_ascii_strtod(text, &end);
+        if (end == text || '\0' != *end || !isfinite(number) || 0 > number || max < number)
         {
-            LOG_E(
-                "%s/%s: Failed to get values from signal %s sent by %s",
-                __FILE__,
-                __FUNCTION__,
-                signal_name,
-                sender_name);
-            return;
+            g_array_set_size(list, 0);
+            break;
         }
-        label = tempsensors_get_label_from_subscription(&tempsensors, sub_id);
-        assert(NULL != label);
-        ua_server_update_temp(label, value);
-        LOG_I("%s/%s: New value for %s is %f", __FILE__, __FUNCTION__, label, value);
+        g_array_append_val(list, number);
     }
+    g_strfreev(items);
+
+    if (0 == list->len)
+    {
+        g_array_free(list, TRUE);
+        return NULL;
+    }
+    return list;
+}
 
-    gint port;
-    gboolean virtual;
-    gboolean hidden;
-    gboolean input;
-    gboolean virtual_trig;
-    gboolean state;
-    gboolean activelow;
+static void temp_deadband_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    GArray *deadbands = parse_sensor_list(value, G_MAXDOUBLE);
+    if (NULL == deadbands)
+    {
+        LOG_E("%s/%s: illegal value for %s: '%s'", __FILE__, __FUNCTION__, name, value);
+        return;
+    }
+    LOG_I("%s/%s: Temperature %s is %s", __FILE__, __FUNCTION__, name, value);
 
-    // PortChanged
-    if (0 == strcmp(signal_name, SIGNALPORTIOCHANGE))
+    // Register again for the sensors with a new deadband, the reply moves the channel to the new subscription id.
+    // The old subscription is dropped first, the device would otherwise keep signalling it.
+    for (size_t i = 0; i < channels.size; i++)
     {
-        if (!dbus_port_unpack_signal(
-                parameters, &sub_id, &port, &virtual, &hidden, &input, &virtual_trig, &state, &activelow))
+        channel_t *channel = &channels.slots[i];
+        const double deadband = sensor_setting(deadbands, channel->index, TEMP_DEADBAND_DEFAULT);
+        if (CHANNEL_TEMP != channel->type || channel->removed ||
+            deadband == sensor_setting(temp_deadbands, channel->index, TEMP_DEADBAND_DEFAULT))
         {
-            LOG_E(
-                "%s/%s: Failed to get values from signal %s sent by %s",
-                __FILE__,
-                __FUNCTION__,
-                signal_name,
-                sender_name);
-            return;
+            continue;
         }
+        poll_set_tolerance(channel, deadband);
+        LOG_I("%s/%s: Register %s with deadband %g", __FILE__, __FUNCTION__, channel->label, deadband);
+        if (channel->subscribed)
+        {
+            unsubscribe_temp(channel->subid);
+        }
+        dbus_temp_subscribe_to_change_async(channel->index, deadband, on_temp_subscribed, channel);
+        pending_calls++;
+    }
 
-        label = ports_get_label_from_subscription(&ports, sub_id);
-        assert(NULL != label);
-
-        ua_server_update_port(label, state);
-        LOG_I(
-            "%s/%s: Port status change. port:%d, virtual:%d, hidden:%d, input:%d, virtual_trig:%d, state:%d, "
-            "activelow:%d",
-            __FILE__,
-            __FUNCTION__,
-            port,
-            virtual,
-            hidden,
-            input,
-            virtual_trig,
-            state,
-            activelow)
+    if (NULL != temp_deadbands)
+    {
+        g_array_free(temp_deadbands, TRUE);
     }
+    temp_deadbands = deadbands;
 }
 
-static void add_tempsensors(void)
+static void temp_min_interval_callback(const gchar *name, const gchar *value, void *data)
 {
-    uint32_t count = 0;
-    if (!dbus_temp_get_number_of_sensors(&count))
+    (void)data;
+    GArray *intervals = parse_sensor_list(value, TEMP_MIN_INTERVAL_MAX);
+    if (NULL == intervals)
     {
-        LOG_E("%s/%s: Failed to get number of temperature sensors", __FILE__, __FUNCTION__);
+        LOG_E("%s/%s: illegal value for %s: '%s'", __FILE__, __FUNCTION__, name, value);
+        return;
     }
-    else
+    LOG_I("%s/%s: Temperature %s is %s ms", __FILE__, __FUNCTION__, name, value);
+
+    if (NULL != temp_min_intervals)
     {
-        LOG_I("%s/%s: This device has %u temperature sensors", __FILE__, __FUNCTION__, count);
+        g_array_free(temp_min_intervals, TRUE);
     }
-    tempsensors_t *tempsensors_p = &tempsensors;
-    tempsensors_init(&tempsensors_p, count);
-    assert(NULL != tempsensors_p);
-    for (uint32_t i = 0; i < count; i++)
+    temp_min_intervals = intervals;
+    for (size_t i = 0; i < channels.size; i++)
     {
-        snprintf(tempsensors.labels[i], TEMP_LABEL_LEN, TEMP_LABEL_FMT, i);
-        double value;
-        if (!dbus_temp_get_value(i, &value))
+        const channel_t *channel = &channels.slots[i];
+        if (CHANNEL_TEMP == channel->type)
         {
-            LOG_E("%s/%s: Failed to get temperature", __FILE__, __FUNCTION__);
+            const double min_interval = sensor_setting(intervals, channel->index, 0);
+            coalesce_set_min_interval(channel, (guint)min_interval);
         }
-        else
+    }
+}
+
+static void aggregate_windows_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    uint32_t seconds[AGGREGATES_WINDOWS_MAX];
+    size_t count = 0;
+
+    // Empty means no aggregates
+    if (NULL != value && '\0' != value[0])
+    {
+        GArray *windows = parse_sensor_list(value, AGGREGATES_WINDOW_MAX_S);
+        if (NULL == windows || AGGREGATES_WINDOWS_MAX < windows->len)
         {
-            LOG_I("%s/%s: Got temperature for sensor %i: %f", __FILE__, __FUNCTION__, i, value);
-            ua_server_add_double(tempsensors.labels[i], value);
+            LOG_E("%s/%s: illegal value for %s: '%s'", __FILE__, __FUNCTION__, name, value);
+            if (NULL != windows)
+            {
+                g_array_free(windows, TRUE);
+            }
+            return;
         }
-        assert(NULL != tempsensors.subid);
-        if (!dbus_temp_subscribe_to_change(&tempsensors.subid[i], i, 0.1))
+        for (guint i = 0; i < windows->len; i++)
         {
-            LOG_E("%s/%s: Failed to subscribe to changes for sensor with id %i", __FILE__, __FUNCTION__, i);
+            const double window = g_array_index(windows, double, i);
+            if (1 > window)
+            {
+                continue;
+            }
+            seconds[count++] = (uint32_t)window;
         }
+        g_array_free(windows, TRUE);
     }
+    LOG_I("%s/%s: Aggregate %s is '%s' s", __FILE__, __FUNCTION__, name, NULL != value ? value : "");
+    aggregates_set_windows(seconds, count);
 }
 
-static void add_ports(void)
+/* A comma separated list of limits, one per sensor, where an empty entry is no limit. Empty for none at all. */
+static bool parse_limit_list(const gchar *value, GArray **list)
 {
-    uint32_t count_all = 0;
-    uint32_t count_in = 0;
-    uint32_t count_out = 0;
+    *list = NULL;
+    if (NULL == value || '\0' == value[0])
+    {
+        return true;
+    }
 
-    if (!dbus_get_number_of_ioports(&count_in, &count_out))
+    gchar **items = g_strsplit(value, ",", -1);
+    GArray *limits = g_array_new(FALSE, FALSE, sizeof(double));
+    bool ok = true;
+    for (gchar **item = items; NULL != *item && ok; item++)
     {
-        LOG_E("%s/%s: Failed to get number of ports", __FILE__, __FUNCTION__);
+        gchar *end;
+        const gchar *text = g_strstrip(*item);
+        double number = NAN;
+        if ('\0' != text[0])
+        {
+            number = g_ascii_strtod(text, &end);
+            ok = end != text && '\0' == *end && isfinite(number);
+        }
+        g_array_append_val(limits, number);
     }
-    else
+    g_strfreev(items);
+
+    if (!ok)
     {
-        count_all = count_in + count_out;
-        LOG_I(
-            "%s/%s: This device has %u input ports and %u output ports. (%u)",
-            __FILE__,
-            __FUNCTION__,
-            count_in,
-            count_out,
-            count_all);
+        g_array_free(limits, TRUE);
+        return false;
     }
+    *list = limits;
+    return true;
+}
 
-    ports_t *ports_p = &ports;
-    ports_init(&ports_p, count_all);
-    assert(NULL != ports_p);
+/* Combine the lists into the limits of each sensor, up to the longest list */
+static void apply_alarm_limits(void)
+{
+    GArray *lists[] = {alarm_low_low, alarm_low, alarm_high, alarm_high_high};
+    guint count = 0;
+    for (size_t i = 0; i < G_N_ELEMENTS(lists); i++)
+    {
+        count = NULL != lists[i] ? MAX(count, lists[i]->len) : count;
+    }
+    // No limits means no alarms, whatever the hysteresis
+    if (0 < count && NULL != alarm_hysteresis)
+    {
+        count = MAX(count, alarm_hysteresis->len);
+    }
 
-    for (uint32_t i = 0; i < count_all; i++)
+    alarm_limits_t *limits = g_new(alarm_limits_t, MAX(count, 1));
+    for (guint i = 0; i < count; i++)
     {
-        snprintf(ports.labels[i], PORT_LABEL_LEN, PORT_LABEL_FMT, i);
-        LOG_I("%s/%s: Added label (%s) for port:%i", __FILE__, __FUNCTION__, ports.labels[i], i);
+        limits[i].low_low = sensor_setting(alarm_low_low, i, NAN);
+        limits[i].low = sensor_setting(alarm_low, i, NAN);
+        limits[i].high = sensor_setting(alarm_high, i, NAN);
+        limits[i].high_high = sensor_setting(alarm_high_high, i, NAN);
+        limits[i].hysteresis = sensor_setting(alarm_hysteresis, i, ALARM_HYSTERESIS_DEFAULT);
+    }
+    alarms_set_limits(limits, count);
+    g_free(limits);
+}
 
-        bool state;
-        if (!dbus_port_get_state(i, &state))
-        {
-            LOG_E("%s/%s: Failed to get port state", __FILE__, __FUNCTION__);
-        }
-        else
-        {
-            LOG_I("%s/%s: Got state for port %i: %d", __FILE__, __FUNCTION__, i, state);
-            ua_server_add_bool(ports.labels[i], state);
-        }
+static void alarm_limit(const gchar *name, const gchar *value, GArray **list)
+{
+    GArray *limits;
+    if (!parse_limit_list(value, &limits))
+    {
+        LOG_E("%s/%s: illegal value for %s: '%s'", __FILE__, __FUNCTION__, name, value);
+        return;
+    }
+    LOG_I("%s/%s: Temperature alarm %s is '%s'", __FILE__, __FUNCTION__, name, NULL != value ? value : "");
+    if (NULL != *list)
+    {
+        g_array_free(*list, TRUE);
+    }
+    *list = limits;
+    apply_alarm_limits();
+}
+
+static void alarm_low_low_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    alarm_limit(name, value, &alarm_low_low);
+}
+
+static void alarm_low_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    alarm_limit(name, value, &alarm_low);
+}
+
+static void alarm_high_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    alarm_limit(name, value, &alarm_high);
+}
+
+static void alarm_high_high_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    alarm_limit(name, value, &alarm_high_high);
+}
 
-        assert(NULL != ports.subid);
-        ports.subid[i] = i;
+static void alarm_hysteresis_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    GArray *hysteresis = parse_sensor_list(value, G_MAXDOUBLE);
+    if (NULL == hysteresis)
+    {
+        LOG_E("%s/%s: illegal value for %s: '%s'", __FILE__, __FUNCTION__, name, value);
+        return;
     }
+    LOG_I("%s/%s: Temperature alarm %s is %s", __FILE__, __FUNCTION__, name, value);
+    if (NULL != alarm_hysteresis)
+    {
+        g_array_free(alarm_hysteresis, TRUE);
+    }
+    alarm_hysteresis = hysteresis;
+    apply_alarm_limits();
 }
 
-static gboolean launch_ua_server(const guint serverport)
+static void port_events_callback(const gchar *name, const gchar *value, void *data)
 {
-    assert(NULL == server);
-    assert(0 < serverport);
-    assert(!ua_server_running);
-    assert(1024 <= serverport && 65535 >= serverport);
+    (void)data;
+    port_events = (0 == g_strcmp0(value, "yes"));
+    if (port_events && !EVENTS_SUPPORTED)
+    {
+        LOG_W("%s/%s: open62541 is built without events, no port events", __FILE__, __FUNCTION__);
+        port_events = false;
+    }
+    LOG_I("%s/%s: Port %s is %s", __FILE__, __FUNCTION__, name, port_events ? "yes" : "no");
+}
 
-    // Create an OPC UA server
-    LOG_I("%s/%s: Create UA server serving on port %u", __FILE__, __FUNCTION__, serverport);
-    ua_server_init(serverport);
+static void poll_max_calls_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    /* Translate parameter value to number; atoi can handle NULL */
+    int calls = atoi(value);
+    if (1 > calls)
+    {
+        LOG_E("%s/%s: illegal value for %s: '%s'", __FILE__, __FUNCTION__, name, value);
+        return;
+    }
+    LOG_I("%s/%s: Polling %s is %i", __FILE__, __FUNCTION__, name, calls);
+    poll_set_max_calls(calls);
+}
 
-    // Add temperature sensors to OPA UA server
-    add_tempsensors();
+/* Returns the value of a server limit parameter, or -1 if it is below min */
+static int server_limit_value(const gchar *name, const gchar *value, const int min)
+{
+    /* Translate parameter value to number; atoi can handle NULL */
+    int number = atoi(value);
+    if (min > number)
+    {
+        LOG_E("%s/%s: illegal value for %s: '%s'", __FILE__, __FUNCTION__, name, value);
+        return -1;
+    }
+    LOG_I("%s/%s: OPC UA server %s is %i", __FILE__, __FUNCTION__, name, number);
+    return number;
+}
 
-    // Add IO ports to OPC UA Server
-    add_ports();
+static void server_memory_budget_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    const int budget = server_limit_value(name, value, 0);
+    if (0 <= budget)
+    {
+        server_limits.memory_budget = (uint64_t)budget * 1024;
+        limits_set(&server_limits);
+    }
+}
 
-    ua_server_running = true;
-    LOG_I("%s/%s: Starting UA server on port %u ...", __FILE__, __FUNCTION__, serverport);
-    if (!ua_server_run(&ua_server_thread_id, &ua_server_running))
+static void server_max_sessions_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    const int sessions = server_limit_value(name, value, 1);
+    if (0 <= sessions)
     {
-        LOG_E("%s/%s: Failed to launch UA server", __FILE__, __FUNCTION__);
-        return FALSE;
+        server_limits.max_sessions = (uint32_t)sessions;
+        limits_set(&server_limits);
     }
+}
 
-    return TRUE;
+static void server_max_subscriptions_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    const int subscriptions = server_limit_value(name, value, 1);
+    if (0 <= subscriptions)
+    {
+        server_limits.max_subscriptions = (uint32_t)subscriptions;
+        limits_set(&server_limits);
+    }
 }
 
-static void shutdown_ua_server(void)
+static void server_max_monitored_items_callback(const gchar *name, const gchar *value, void *data)
 {
-    assert(ua_server_running);
-    ua_server_running = false;
-    pthread_join(ua_server_thread_id, NULL);
+    (void)data;
+    const int items = server_limit_value(name, value, 1);
+    if (0 <= items)
+    {
+        server_limits.max_monitored_items = (uint32_t)items;
+        limits_set(&server_limits);
+    }
 }
 
-static void port_callback(const gchar *name, const gchar *value, void *data)
+static void server_max_notifications_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    const int notifications = server_limit_value(name, value, 1);
+    if (0 <= notifications)
+    {
+        server_limits.max_notifications = (uint32_t)notifications;
+        limits_set(&server_limits);
+    }
+}
+
+static void server_min_publishing_interval_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    const int interval = server_limit_value(name, value, 1);
+    if (0 <= interval)
+    {
+        server_limits.min_publishing_ms = interval;
+        limits_set(&server_limits);
+    }
+}
+
+static void server_min_sampling_interval_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    const int interval = server_limit_value(name, value, 0);
+    if (0 <= interval)
+    {
+        server_limits.min_sampling_ms = interval;
+        limits_set(&server_limits);
+    }
+}
+
+static void server_buffer_size_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    const int size = server_limit_value(name, value, 8);
+    if (0 > size || server_limits.buffer_size == (uint32_t)size * 1024)
+    {
+        return;
+    }
+    server_limits.buffer_size = (uint32_t)size * 1024;
+    limits_set(&server_limits);
+
+    // Only new connections of a restarted network layer get the new buffers
+    if (ua_server_running || launching)
+    {
+        restart_ua_server();
+    }
+}
+
+static void pull_values_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    bool pull = (0 == g_strcmp0(value, "yes"));
+    LOG_I("%s/%s: OPC UA server %s is %s", __FILE__, __FUNCTION__, name, pull ? "yes" : "no");
+
+    // Other nodes are a full relaunch, like a new number of servers
+    if (ua_server_set_pull(pull) && (ua_server_running || launching))
+    {
+        restart_ua_server();
+    }
+}
+
+static void single_loop_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    bool enabled = (0 == g_strcmp0(value, "yes"));
+    LOG_I("%s/%s: OPC UA server %s is %s", __FILE__, __FUNCTION__, name, enabled ? "yes" : "no");
+
+    // Used when the server runs again, the network restart is enough
+    if (ua_server_set_single_loop(enabled) && (ua_server_running || launching))
+    {
+        restart_ua_server();
+    }
+}
+
+static void enumerate_interval_callback(const gchar *name, const gchar *value, void *data)
 {
     (void)data;
     /* Translate parameter value to number; atoi can handle NULL */
-    int newport = atoi(value);
-    /* Only allow non-privileged ports */
-    if (1024 > newport || 65535 < newport)
+    int interval = atoi(value);
+    if (0 > interval)
     {
         LOG_E("%s/%s: illegal value for %s: '%s'", __FILE__, __FUNCTION__, name, value);
         return;
     }
-    port = newport;
-    LOG_I("%s/%s: OPC UA server %s is %u", __FILE__, __FUNCTION__, name, port);
+    LOG_I("%s/%s: Channel %s is %i s", __FILE__, __FUNCTION__, name, interval);
+    g_clear_handle_id(&enumerate_id, g_source_remove);
+    if (0 < interval)
+    {
+        enumerate_id = g_timeout_add_seconds((guint)interval, on_enumerate, NULL);
+    }
+}
 
-    if (ua_server_running)
+static void security_none_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    bool allowed = (0 == g_strcmp0(value, "yes"));
+    LOG_I("%s/%s: OPC UA server %s is %s", __FILE__, __FUNCTION__, name, allowed ? "yes" : "no");
+
+    // The endpoints are set up with the server, see ua_server_rebind
+    if (security_set_allow_none(allowed) && (ua_server_running || launching))
     {
-        shutdown_ua_server();
+        restart_ua_server();
+    }
+}
+
+static void security_accept_all_callback(const gchar *name, const gchar *value, void *data)
+{
+    (void)data;
+    bool accepted = (0 == g_strcmp0(value, "yes"));
+    LOG_I("%s/%s: OPC UA server %s is %s", __FILE__, __FUNCTION__, name, accepted ? "yes" : "no");
+
+    // The trust list is set up with the server, like the endpoints
+    if (security_set_accept_all(accepted) && (ua_server_running || launching))
+    {
+        restart_ua_server();
     }
-    (void)launch_ua_server(port);
 }
 
 static gboolean setup_param(const gchar *name, AXParameterCallback callbackfn)
@@ -310,7 +1391,31 @@ static gboolean setup_params(const char *appname)
         return FALSE;
     }
 
-    if (!setup_param("port", port_callback))
+    if (!setup_param("logLevel", log_level_callback) || !setup_param("coalesceWindow", coalesce_window_callback) ||
+        !setup_param("coalescePortEdges", coalesce_port_edges_callback) ||
+        !setup_param("historyBudget", history_budget_callback) ||
+        !setup_param("historyPortDelta", history_port_delta_callback) ||
+        !setup_param("historyPersist", history_persist_callback) ||
+        !setup_param("tempDeadband", temp_deadband_callback) ||
+        !setup_param("tempMinInterval", temp_min_interval_callback) ||
+        !setup_param("pollMaxCalls", poll_max_calls_callback) ||
+        !setup_param("aggregateWindows", aggregate_windows_callback) ||
+        !setup_param("portEvents", port_events_callback) ||
+        !setup_param("alarmHysteresis", alarm_hysteresis_callback) ||
+        !setup_param("alarmLowLow", alarm_low_low_callback) || !setup_param("alarmLow", alarm_low_callback) ||
+        !setup_param("alarmHigh", alarm_high_callback) || !setup_param("alarmHighHigh", alarm_high_high_callback) ||
+        !setup_param("serverMemoryBudget", server_memory_budget_callback) ||
+        !setup_param("serverMaxSessions", server_max_sessions_callback) ||
+        !setup_param("serverMaxSubscriptions", server_max_subscriptions_callback) ||
+        !setup_param("serverMaxMonitoredItems", server_max_monitored_items_callback) ||
+        !setup_param("serverMaxNotifications", server_max_notifications_callback) ||
+        !setup_param("serverMinPublishingInterval", server_min_publishing_interval_callback) ||
+        !setup_param("serverMinSamplingInterval", server_min_sampling_interval_callback) ||
+        !setup_param("serverBufferSize", server_buffer_size_callback) ||
+        !setup_param("pullValues", pull_values_callback) || !setup_param("singleLoop", single_loop_callback) ||
+        !setup_param("enumerateInterval", enumerate_interval_callback) ||
+        !setup_param("securityNone", security_none_callback) ||
+        !setup_param("securityAcceptAll", security_accept_all_callback) || !setup_param("port", port_callback))
     {
         ax_parameter_free(axparameter);
         return FALSE;
@@ -333,6 +1438,19 @@ static void signal_handler(gint signal_num)
     }
 }
 
+/* On the main loop rather than in a signal handler, writing a file is not async-signal-safe */
+static gboolean on_latency_dump(G_GNUC_UNUSED gpointer user_data)
+{
+    (void)diagnostics_latency_dump(DIAG_LATENCY_FILE);
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean on_latency_reset(G_GNUC_UNUSED gpointer user_data)
+{
+    diagnostics_latency_reset();
+    return G_SOURCE_CONTINUE;
+}
+
 static gboolean signal_handler_init(void)
 {
     struct sigaction sa = {0};
@@ -351,11 +1469,16 @@ static gboolean signal_handler_init(void)
         return FALSE;
     }
 
+    // SIGUSR1 dumps the latency histograms, SIGUSR2 resets them
+    g_unix_signal_add(SIGUSR1, on_latency_dump, NULL);
+    g_unix_signal_add(SIGUSR2, on_latency_reset, NULL);
+
     return TRUE;
 }
 
 int main(int argc, char **argv)
 {
+    main_start = g_get_monotonic_time();
     char *app_name = basename(argv[0]);
     open_syslog(app_name);
 
@@ -371,12 +1494,16 @@ int main(int argc, char **argv)
         LOG_E("%s/%s: Failed to setup D-Bus", __FILE__, __FUNCTION__);
     }
 
-    // Connect to D-Bus signals
-    LOG_I("%s/%s: Connect to D-Bus signal ...", __FILE__, __FUNCTION__);
-    dbus_connect_temp_g_signal(G_CALLBACK(on_dbus_signal));
+    // Connect to D-Bus signals, one handler per signal
+    LOG_I("%s/%s: Connect to D-Bus signal %s ...", __FILE__, __FUNCTION__, TEMP_SIGNAL_NAME);
+    dbus_connect_temp_g_signal(G_CALLBACK(on_temp_signal));
+
+    LOG_I("%s/%s: Connect to D-Bus signal %s ...", __FILE__, __FUNCTION__, PORT_SIGNAL_NAME);
+    dbus_connect_ports_g_signal(G_CALLBACK(on_port_signal));
 
-    LOG_I("%s/%s: Connect to D-Bus signal ...", __FILE__, __FUNCTION__);
-    dbus_connect_ports_g_signal(G_CALLBACK(on_dbus_signal));
+    // Output ports set by clients are set on D-Bus and read back
+    outputs_init(on_output_confirmed);
+    ua_server_set_output_handler(outputs_set);
 
     // Setup parameters (will also launch OPC UA server)
     LOG_I("%s/%s: Setup parameters", __FILE__, __FUNCTION__);
@@ -385,26 +1512,79 @@ int main(int argc, char **argv)
         LOG_E("%s/%s: Failed to setup parameters", __FILE__, __FUNCTION__);
     }
 
-    // Main loop
-    LOG_I("%s/%s: Ready", __FILE__, __FUNCTION__);
+    // Main loop, ready when the first launch has its values
     assert(NULL == main_loop);
     main_loop = g_main_loop_new(NULL, FALSE);
     g_main_loop_run(main_loop);
 
     // Cleanup and controlled shutdown
+    g_clear_handle_id(&enumerate_id, g_source_remove);
     LOG_I("%s/%s: Free parameter handler ...", __FILE__, __FUNCTION__);
     ax_parameter_free(axparameter);
     LOG_I("%s/%s: Clean up DBus ...", __FILE__, __FUNCTION__);
     dbus_all_cleanup();
 
     LOG_I("%s/%s: Shut down UA server ...", __FILE__, __FUNCTION__);
-    shutdown_ua_server();
+    if (ua_server_running)
+    {
+        shutdown_ua_server();
+    }
+    ua_server_cleanup();
+    security_cleanup();
+
+    coalesce_stats_t coalesce_stats;
+    coalesce_get_stats(&coalesce_stats);
+    LOG_I(
+        "%s/%s: Forwarded %llu updates, coalesced %llu",
+        __FILE__,
+        __FUNCTION__,
+        (unsigned long long)coalesce_stats.forwarded,
+        (unsigned long long)coalesce_stats.coalesced);
+
+    poll_stats_t poll_stats;
+    poll_get_stats(&poll_stats);
+    LOG_I(
+        "%s/%s: Polled %llu times in %llu cycles, %u channels polled at exit",
+        __FILE__,
+        __FUNCTION__,
+        (unsigned long long)poll_stats.calls,
+        (unsigned long long)poll_stats.cycles,
+        poll_stats.polled);
+
+    history_stats_t history_stats;
+    history_get_stats(&history_stats);
+    LOG_I(
+        "%s/%s: History holds %llu samples in %zu bytes (%llu appended, %llu restored)",
+        __FILE__,
+        __FUNCTION__,
+        (unsigned long long)history_stats.samples,
+        history_stats.bytes,
+        (unsigned long long)history_stats.appended,
+        (unsigned long long)history_stats.restored);
 
     LOG_I("%s/%s: Free data structures ...", __FILE__, __FUNCTION__);
-    tempsensors_t *tempsensors_p = &tempsensors;
-    tempsensors_free(&tempsensors_p);
-    ports_t *ports_p = &ports;
-    ports_free(&ports_p);
+    history_cleanup();
+    aggregates_cleanup();
+    alarms_cleanup();
+    poll_cleanup();
+    coalesce_cleanup();
+    channels_free(&channels);
+    if (NULL != temp_deadbands)
+    {
+        g_array_free(temp_deadbands, TRUE);
+    }
+    if (NULL != temp_min_intervals)
+    {
+        g_array_free(temp_min_intervals, TRUE);
+    }
+    GArray *alarm_lists[] = {alarm_low_low, alarm_low, alarm_high, alarm_high_high, alarm_hysteresis};
+    for (size_t i = 0; i < G_N_ELEMENTS(alarm_lists); i++)
+    {
+        if (NULL != alarm_lists[i])
+        {
+            g_array_free(alarm_lists[i], TRUE);
+        }
+    }
 
     LOG_I("%s/%s: Unreference main loop ...", __FILE__, __FUNCTION__);
     g_main_loop_unref(main_loop);
@@ -0,0 +1,125 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "opcua_snapshot.h"
+
+/* Reads that found a store in progress before the reader gives the writer the CPU */
+#define SNAPSHOT_SPINS 64
+
+static snapshot_slot_t *get_slot(snapshot_t *snapshot, const uint32_t slot)
+{
+    if (SNAPSHOT_SLOTS_MAX <= slot)
+    {
+        return NULL;
+    }
+    snapshot_slot_t *chunk = atomic_load_explicit(&snapshot->chunks[slot / SNAPSHOT_CHUNK], memory_order_acquire);
+    return NULL != chunk ? &chunk[slot % SNAPSHOT_CHUNK] : NULL;
+}
+
+/* Only when no server reads the snapshot */
+void snapshot_free(snapshot_t *snapshot)
+{
+    assert(NULL != snapshot);
+    for (size_t i = 0; i < SNAPSHOT_CHUNKS; i++)
+    {
+        free(atomic_load_explicit(&snapshot->chunks[i], memory_order_relaxed));
+        atomic_store_explicit(&snapshot->chunks[i], NULL, memory_order_relaxed);
+    }
+}
+
+/* Make room for a slot, from the thread that stores. False if there is no memory for it. */
+bool snapshot_add(snapshot_t *snapshot, uint32_t slot)
+{
+    assert(NULL != snapshot);
+    if (SNAPSHOT_SLOTS_MAX <= slot)
+    {
+        return false;
+    }
+    if (NULL != get_slot(snapshot, slot))
+    {
+        return true;
+    }
+    snapshot_slot_t *chunk = aligned_alloc(SNAPSHOT_CACHELINE, SNAPSHOT_CHUNK * sizeof(snapshot_slot_t));
+    if (NULL == chunk)
+    {
+        return false;
+    }
+    memset(chunk, 0, SNAPSHOT_CHUNK * sizeof(snapshot_slot_t));
+    atomic_store_explicit(&snapshot->chunks[slot / SNAPSHOT_CHUNK], chunk, memory_order_release);
+    return true;
+}
+
+/* Only called from the one thread that stores, false if the slot was not added */
+bool snapshot_store(snapshot_t *snapshot, uint32_t slot, const snapshot_value_t *value)
+{
+    assert(NULL != snapshot);
+    assert(NULL != value);
+    snapshot_slot_t *s = get_slot(snapshot, slot);
+    if (NULL == s)
+    {
+        return false;
+    }
+    uint64_t bits;
+    memcpy(&bits, &value->value, sizeof(bits));
+
+    const unsigned seq = atomic_load_explicit(&s->seq, memory_order_relaxed);
+    atomic_store_explicit(&s->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&s->value, bits, memory_order_relaxed);
+    atomic_store_explicit(&s->source_ns, value->source_ns, memory_order_relaxed);
+    atomic_store_explicit(&s->server_ns, value->server_ns, memory_order_relaxed);
+    atomic_store_explicit(&s->seq, seq + 2, memory_order_release);
+    return true;
+}
+
+/* From any thread, false if the slot has never been stored */
+bool snapshot_load(snapshot_t *snapshot, uint32_t slot, snapshot_value_t *value)
+{
+    assert(NULL != snapshot);
+    assert(NULL != value);
+    snapshot_slot_t *s = get_slot(snapshot, slot);
+    if (NULL == s)
+    {
+        return false;
+    }
+    for (unsigned spins = 0;; spins++)
+    {
+        const unsigned seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+        if (0 == (seq & 1))
+        {
+            const uint64_t bits = atomic_load_explicit(&s->value, memory_order_relaxed);
+            value->source_ns = atomic_load_explicit(&s->source_ns, memory_order_relaxed);
+            value->server_ns = atomic_load_explicit(&s->server_ns, memory_order_relaxed);
+            atomic_thread_fence(memory_order_acquire);
+            if (seq == atomic_load_explicit(&s->seq, memory_order_relaxed))
+            {
+                memcpy(&value->value, &bits, sizeof(bits));
+                return 0 != seq;
+            }
+        }
+        if (SNAPSHOT_SPINS <= spins)
+        {
+            // The writer was preempted in the middle of a store
+            (void)sched_yield();
+            spins = 0;
+        }
+    }
+}
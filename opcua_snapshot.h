@@ -0,0 +1,68 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _OPCUA_SNAPSHOT_H_
+#define _OPCUA_SNAPSHOT_H_
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "opcua_channels.h"
+
+#define SNAPSHOT_CACHELINE 64
+
+/* Slots are allocated in chunks that never move, so that slots can be added while servers read others */
+#define SNAPSHOT_CHUNK 64
+#define SNAPSHOT_SLOTS_MAX (CHANNEL_TYPES * CHANNELS_MAX_PER_TYPE)
+#define SNAPSHOT_CHUNKS ((SNAPSHOT_SLOTS_MAX + SNAPSHOT_CHUNK - 1) / SNAPSHOT_CHUNK)
+
+/* The latest value of a node, a port's state is 0 or 1 */
+typedef struct
+{
+    double value;
+    int64_t source_ns; // CLOCK_REALTIME when it was received
+    int64_t server_ns; // CLOCK_REALTIME when it was stored
+} snapshot_value_t;
+
+/*
+ * One slot per channel slot, each on its own cache line so that a store to
+ * one node does not disturb the readers of the others. The slots are sequence
+ * locks with a single writer, the GLib main loop, and any number of readers,
+ * the server threads. The sequence is odd while a slot is being stored, and a
+ * reader that sees it odd or changed reads again.
+ */
+typedef struct
+{
+    alignas(SNAPSHOT_CACHELINE) atomic_uint seq;
+    atomic_uint_fast64_t value; // bits of the double
+    atomic_int_fast64_t source_ns;
+    atomic_int_fast64_t server_ns;
+} snapshot_slot_t;
+
+typedef struct
+{
+    _Atomic(snapshot_slot_t *) chunks[SNAPSHOT_CHUNKS];
+} snapshot_t;
+
+void snapshot_free(snapshot_t *snapshot);
+bool snapshot_add(snapshot_t *snapshot, uint32_t slot);
+bool snapshot_store(snapshot_t *snapshot, uint32_t slot, const snapshot_value_t *value);
+bool snapshot_load(snapshot_t *snapshot, uint32_t slot, snapshot_value_t *value);
+
+#endif /* _OPCUA_SNAPSHOT_H_ */
@@ -0,0 +1,120 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <time.h>
+
+#include "opcua_updates.h"
+
+#define UPDATES_MASK (UPDATES_CAPACITY - 1)
+
+_Static_assert(0 == (UPDATES_CAPACITY & UPDATES_MASK), "UPDATES_CAPACITY must be a power of two");
+
+static int64_t clock_ns(const clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void updates_time_now(update_time_t *time)
+{
+    assert(NULL != time);
+    time->real_ns = clock_ns(CLOCK_REALTIME);
+    time->mono_ns = clock_ns(CLOCK_MONOTONIC);
+}
+
+void updates_init(updates_t *updates)
+{
+    assert(NULL != updates);
+    atomic_init(&updates->head, 0);
+    atomic_init(&updates->tail, 0);
+    atomic_init(&updates->high_water, 0);
+    atomic_init(&updates->pushed, 0);
+    atomic_init(&updates->overflows, 0);
+    updates->tail_cache = 0;
+    updates->head_cache = 0;
+}
+
+bool updates_push(updates_t *updates, const update_t *update)
+{
+    assert(NULL != updates);
+    assert(NULL != update);
+
+    const size_t head = atomic_load_explicit(&updates->head, memory_order_relaxed);
+    if (UPDATES_CAPACITY <= head - updates->tail_cache)
+    {
+        // Only reload the shared tail when the cached one says we are full
+        updates->tail_cache = atomic_load_explicit(&updates->tail, memory_order_acquire);
+        if (UPDATES_CAPACITY <= head - updates->tail_cache)
+        {
+            atomic_fetch_add_explicit(&updates->overflows, 1, memory_order_relaxed);
+            return false;
+        }
+    }
+
+    updates->events[head & UPDATES_MASK] = *update;
+    atomic_store_explicit(&updates->head, head + 1, memory_order_release);
+    atomic_fetch_add_explicit(&updates->pushed, 1, memory_order_relaxed);
+    return true;
+}
+
+size_t updates_drain(updates_t *updates, updates_handler_t handler, void *user_data, size_t max)
+{
+    assert(NULL != updates);
+    assert(NULL != handler);
+
+    size_t tail = atomic_load_explicit(&updates->tail, memory_order_relaxed);
+    if (tail == updates->head_cache)
+    {
+        updates->head_cache = atomic_load_explicit(&updates->head, memory_order_acquire);
+    }
+
+    // Only the consumer writes the high-water mark, the producer's cached tail is too stale for it
+    const size_t depth = updates->head_cache - tail;
+    if (depth > atomic_load_explicit(&updates->high_water, memory_order_relaxed))
+    {
+        atomic_store_explicit(&updates->high_water, depth, memory_order_relaxed);
+    }
+
+    size_t count = 0;
+    while (tail != updates->head_cache && count < max)
+    {
+        handler(&updates->events[tail & UPDATES_MASK], user_data);
+        tail++;
+        count++;
+    }
+
+    // Hand the whole batch of slots back to the producer at once
+    if (0 < count)
+    {
+        atomic_store_explicit(&updates->tail, tail, memory_order_release);
+    }
+    return count;
+}
+
+void updates_get_stats(updates_t *updates, updates_stats_t *stats)
+{
+    assert(NULL != updates);
+    assert(NULL != stats);
+
+    const size_t tail = atomic_load_explicit(&updates->tail, memory_order_acquire);
+    const size_t head = atomic_load_explicit(&updates->head, memory_order_acquire);
+    stats->depth = head - tail;
+    stats->high_water = atomic_load_explicit(&updates->high_water, memory_order_relaxed);
+    stats->pushed = atomic_load_explicit(&updates->pushed, memory_order_relaxed);
+    stats->overflows = atomic_load_explicit(&updates->overflows, memory_order_relaxed);
+}
@@ -0,0 +1,97 @@
+/**
+ * Copyright (C) 2026, Axis Communications AB, Lund, Sweden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _OPCUA_UPDATES_H_
+#define _OPCUA_UPDATES_H_
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "opcua_channels.h"
+
+/* Number of slots in the update queue, must be a power of two */
+#ifndef UPDATES_CAPACITY
+#define UPDATES_CAPACITY 1024
+#endif
+
+#define UPDATES_CACHELINE 64
+
+/* When a value was received: wall clock time for the clients and monotonic time to measure the lag */
+typedef struct
+{
+    int64_t real_ns;
+    int64_t mono_ns;
+} update_time_t;
+
+/* A value update for one node, passed from the D-Bus side to the UA server thread */
+typedef struct
+{
+    const channel_t *channel;
+    update_time_t received;
+    int64_t queued_ns; // monotonic time when it was queued
+    union
+    {
+        double temp;
+        bool state;
+        struct
+        {
+            bool state;
+            bool activelow;
+            bool virtual;
+        } transition; // a port transition as signaled, for its event
+    } value;
+} update_t;
+
+typedef struct
+{
+    size_t depth;
+    size_t high_water;
+    uint64_t pushed;
+    uint64_t overflows;
+} updates_stats_t;
+
+/*
+ * Bounded single-producer/single-consumer ring. The producer (the GLib main
+ * loop) only writes head and the consumer (the UA server thread) only writes
+ * tail, so no locks are needed. The indices live on separate cache lines to
+ * avoid false sharing between the two threads.
+ */
+typedef struct
+{
+    alignas(UPDATES_CACHELINE) atomic_size_t head;
+    size_t tail_cache; // producer's last seen tail
+    atomic_uint_fast64_t pushed;
+    atomic_uint_fast64_t overflows;
+
+    alignas(UPDATES_CACHELINE) atomic_size_t tail;
+    size_t head_cache; // consumer's last seen head
+    atomic_size_t high_water; // most updates found waiting by the consumer
+
+    alignas(UPDATES_CACHELINE) update_t events[UPDATES_CAPACITY];
+} updates_t;
+
+typedef void (*updates_handler_t)(const update_t *update, void *user_data);
+
+void updates_time_now(update_time_t *time);
+void updates_init(updates_t *updates);
+bool updates_push(updates_t *updates, const update_t *update);
+size_t updates_drain(updates_t *updates, updates_handler_t handler, void *user_data, size_t max);
+void updates_get_stats(updates_t *updates, updates_stats_t *stats);
+
+#endif /* _OPCUA_UPDATES_H_ */
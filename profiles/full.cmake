@@ -0,0 +1,10 @@
+# open62541 build options of the default profile, used with cmake -C
+set(CMAKE_BUILD_TYPE Release CACHE STRING "")
+set(BUILD_SHARED_LIBS OFF CACHE BOOL "")
+set(UA_ENABLE_NODEMANAGEMENT ON CACHE BOOL "")
+set(UA_ENABLE_HISTORIZING ON CACHE BOOL "")
+set(UA_ENABLE_DA ON CACHE BOOL "")
+set(UA_ENABLE_SUBSCRIPTIONS_EVENTS ON CACHE BOOL "")
+set(UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS ON CACHE BOOL "")
+set(UA_MULTITHREADING 100 CACHE STRING "")
+set(UA_ENABLE_ENCRYPTION OPENSSL CACHE STRING "")
@@ -0,0 +1,23 @@
+# open62541 build options for devices short on RAM, used with cmake -C
+#
+# Keeps what the application's variables and subscriptions need: history,
+# data access (percent deadbands) and status code names for the log. Drops
+# the generated namespace zero, the node management and discovery services,
+# events, the JSON and XML encodings, type names, thread safety and library
+# log messages below warning.
+set(CMAKE_BUILD_TYPE MinSizeRel CACHE STRING "")
+set(BUILD_SHARED_LIBS OFF CACHE BOOL "")
+set(UA_NAMESPACE_ZERO MINIMAL CACHE STRING "")
+set(UA_ENABLE_NODEMANAGEMENT OFF CACHE BOOL "")
+set(UA_ENABLE_HISTORIZING ON CACHE BOOL "")
+set(UA_ENABLE_DA ON CACHE BOOL "")
+set(UA_ENABLE_STATUSCODE_DESCRIPTIONS ON CACHE BOOL "")
+set(UA_ENABLE_DISCOVERY OFF CACHE BOOL "")
+set(UA_ENABLE_SUBSCRIPTIONS_EVENTS OFF CACHE BOOL "")
+set(UA_ENABLE_JSON_ENCODING OFF CACHE BOOL "")
+set(UA_ENABLE_XML_ENCODING OFF CACHE BOOL "")
+set(UA_ENABLE_PARSING OFF CACHE BOOL "")
+set(UA_ENABLE_TYPEDESCRIPTION OFF CACHE BOOL "")
+set(UA_ENABLE_DIAGNOSTICS OFF CACHE BOOL "")
+set(UA_MULTITHREADING 0 CACHE STRING "")
+set(UA_LOGLEVEL 400 CACHE STRING "")